@@ -18,6 +18,7 @@ set(CORE_SOURCES
   heuristic.cc
   int_packer.cc
   memory.cc
+  novelty_table.cc
   operator.cc
   operator_cost.cc
   option_parser.cc
@@ -33,6 +34,7 @@ set(CORE_SOURCES
   state_id.cc
   state_registry.cc
   successor_generator.cc
+  thread_pool.cc
   timer.cc
   utilities.cc
   pruning_method.cc
@@ -102,24 +104,44 @@ fast_downward_plugin(
     sum_evaluator.cc
     weighted_evaluator.cc
     weighted_astar.cc
+    breadth_first_heuristic_search.cc
+    ida_star_search.cc
+    external_astar_search.cc
+    ara_star_search.cc
+    focal_search.cc
+    parallel_portfolio.cc
+    beam_search.cc
+    iw_search.cc
+    bfws_search.cc
+    random_walk_search.cc
+    hda_astar.cc
     enforced_hill_climbing_search.cc
     iterated_search.cc
     linear_program.cc
+    heuristics/relaxed_task.cc
+    heuristics/relaxed_exploration.cc
+    heuristics/bit_parallel_exploration.cc
     heuristics/blind_heuristic.cc
     heuristics/goal_count_heuristic.cc
     heuristics/max_heuristic.cc
     heuristics/additive_heuristic.cc
     heuristics/critical_path_heuristic.cc
+    heuristics/hm_heuristic.cc
+    heuristics/pm_compilation.cc
+    heuristics/landmark_graph.cc
     heuristics/ff_heuristic.cc
     heuristics/red_black_heuristic.cc
     heuristics/landmark_cut_heuristic.cc
     heuristics/landmark_heuristic.cc
+    heuristics/factored_transition_system.cc
     heuristics/merge_and_shrink_heuristic.cc
     heuristics/pattern_database_heuristic.cc
     heuristics/potential_heuristic.cc
     heuristics/operator_counting_heuristic.cc
     pruning/strong_stubborn_sets.cc
     pruning/dominance.cc
+    symbolic/bdd.cc
+    symbolic/symbolic_search.cc
 #    DEPENDS BOOST
 )
 
@@ -0,0 +1,269 @@
+#include "ara_star_search.h"
+
+#include "globals.h"
+#include "heuristic.h"
+#include "option_parser.h"
+#include "plugin.h"
+#include "successor_generator.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+using namespace std;
+
+static const int INF = numeric_limits<int>::max();
+
+
+ARAStarSearch::ARAStarSearch(const Options &opts)
+    : SearchEngine(opts),
+      heuristic(opts.get<Heuristic *>("eval")),
+      weight(opts.get<double>("w")),
+      weight_decrement(opts.get<double>("w_decrement")),
+      expansion_iteration(-1),
+      iteration(0),
+      incumbent_g(INF),
+      plan_counter(0),
+      suboptimality_bound(numeric_limits<double>::infinity())
+{
+}
+
+void ARAStarSearch::initialize()
+{
+    cout << "Conducting ARA* with initial weight " << weight
+         << " and weight decrement " << weight_decrement
+         << ", (real) bound = " << bound << endl;
+    search_progress.add_heuristic(heuristic);
+
+    const State &initial_state = g_initial_state();
+    heuristic->evaluate(initial_state);
+    search_progress.inc_evaluated_states();
+    search_progress.inc_evaluations();
+    if (heuristic->is_dead_end()) {
+        cout << "Initial state is a dead end." << endl;
+        return;
+    }
+    search_progress.get_initial_h_values();
+    SearchNode node = search_space.get_node(initial_state);
+    node.open_initial(heuristic->get_heuristic());
+    check_incumbent(initial_state, node);
+    insert(node);
+    cout << "Starting iteration with w = " << weight << " [t=" << g_timer
+         << "]" << endl;
+}
+
+void ARAStarSearch::insert(const SearchNode &node)
+{
+    double f = node.get_g() + weight * node.get_h();
+    open_list.push(OpenEntry(f, node.get_h(), node.get_g(),
+                             node.get_state_id()));
+}
+
+bool ARAStarSearch::is_stale(const OpenEntry &entry)
+{
+    State state = g_state_registry->lookup_state(entry.state_id);
+    SearchNode node = search_space.get_node(state);
+    return !node.is_open() || node.get_g() != entry.g ||
+           expansion_iteration[state] == iteration;
+}
+
+void ARAStarSearch::check_incumbent(const State &state, const SearchNode &node)
+{
+    if (node.get_g() < incumbent_g && test_goal(state)) {
+        incumbent_g = node.get_g();
+        incumbent_plan.clear();
+        search_space.trace_path(state, incumbent_plan);
+        // Only cheaper plans are of interest from now on.
+        bound = min(bound, node.get_real_g());
+        // Save the plan right away (and publish its cost through set_plan)
+        // so that it is not lost if the search is interrupted before the
+        // iteration ends.
+        set_plan(incumbent_plan);
+        ++plan_counter;
+        cout << "Saving plan " << plan_counter << " with cost " << incumbent_g
+             << " found with w = " << weight << endl;
+        save_plan(incumbent_plan, plan_counter);
+    }
+}
+
+SearchStatus ARAStarSearch::step()
+{
+    while (!open_list.empty() && is_stale(open_list.top())) {
+        open_list.pop();
+    }
+    if (open_list.empty() || open_list.top().f >= incumbent_g) {
+        return finish_iteration();
+    }
+    StateID id = open_list.top().state_id;
+    open_list.pop();
+    State state = g_state_registry->lookup_state(id);
+    SearchNode node = search_space.get_node(state);
+    expand(state, node);
+    return IN_PROGRESS;
+}
+
+void ARAStarSearch::expand(const State &state, SearchNode &node)
+{
+    node.close();
+    expansion_iteration[state] = iteration;
+    search_progress.inc_expanded();
+
+    applicable_ops.clear();
+    g_successor_generator->generate_applicable_ops(state, applicable_ops);
+    search_progress.inc_generated_ops(applicable_ops.size());
+    for (size_t i = 0; i < applicable_ops.size(); ++i) {
+        const Operator *op = applicable_ops[i];
+        if (node.get_real_g() + op->get_cost() >= bound) {
+            continue;
+        }
+        State succ_state = g_state_registry->get_successor_state(state, *op);
+        search_progress.inc_generated();
+        SearchNode succ_node = search_space.get_node(succ_state);
+        if (succ_node.is_dead_end()) {
+            continue;
+        }
+        int succ_g = node.get_g() + get_adjusted_cost(*op);
+        if (succ_node.is_new()) {
+            heuristic->reach_state(state, *op, succ_state);
+            heuristic->evaluate(succ_state);
+            search_progress.inc_evaluated_states();
+            search_progress.inc_evaluations();
+            if (heuristic->is_dead_end()) {
+                succ_node.mark_as_dead_end();
+                search_progress.inc_dead_ends();
+                continue;
+            }
+            succ_node.open(heuristic->get_heuristic(), node, op);
+        } else if (succ_g < succ_node.get_g()) {
+            if (succ_node.is_closed()) {
+                search_progress.inc_reopened();
+            }
+            succ_node.reopen(node, op);
+        } else {
+            continue;
+        }
+        check_incumbent(succ_state, succ_node);
+        if (expansion_iteration[succ_state] == iteration) {
+            incons_list.push_back(succ_state.get_id());
+        } else {
+            insert(succ_node);
+        }
+    }
+}
+
+SearchStatus ARAStarSearch::finish_iteration()
+{
+    // The minimum g + h of all states that may still improve the plan.
+    int min_f = INF;
+    vector<OpenEntry> open_entries;
+    while (!open_list.empty()) {
+        if (!is_stale(open_list.top())) {
+            open_entries.push_back(open_list.top());
+            min_f = min(min_f, open_list.top().g + open_list.top().h);
+        }
+        open_list.pop();
+    }
+    for (size_t i = 0; i < incons_list.size(); ++i) {
+        SearchNode node = search_space.get_node(
+            g_state_registry->lookup_state(incons_list[i]));
+        min_f = min(min_f, node.get_g() + node.get_h());
+    }
+
+    if (incumbent_g != INF) {
+        double bound_from_f = min_f == INF ? 1.0 :
+                              static_cast<double>(incumbent_g) / max(min_f, 1);
+        suboptimality_bound = max(1.0, min(weight, bound_from_f));
+    }
+    cout << "Finished iteration with w = " << weight << ": ";
+    if (incumbent_g == INF) {
+        cout << "no plan";
+    } else {
+        cout << "plan cost " << incumbent_g
+             << ", suboptimality bound " << suboptimality_bound;
+    }
+    cout << " [expanded " << search_progress.get_expanded()
+         << " state(s), t=" << g_timer << "]" << endl;
+
+    if (open_entries.empty() && incons_list.empty()) {
+        if (found_solution()) {
+            cout << "No open states left -- plan is optimal" << endl;
+            return SOLVED;
+        }
+        cout << "Completely explored state space -- no solution!" << endl;
+        return FAILED;
+    }
+    if (weight <= 1.0 || (found_solution() && suboptimality_bound <= 1.0)) {
+        return found_solution() ? SOLVED : FAILED;
+    }
+
+    weight = max(1.0, weight - weight_decrement);
+    for (size_t i = 0; i < open_entries.size(); ++i) {
+        const OpenEntry &entry = open_entries[i];
+        open_list.push(OpenEntry(entry.g + weight * entry.h, entry.h,
+                                 entry.g, entry.state_id));
+    }
+    start_iteration();
+    return IN_PROGRESS;
+}
+
+void ARAStarSearch::start_iteration()
+{
+    ++iteration;
+    for (size_t i = 0; i < incons_list.size(); ++i) {
+        State state = g_state_registry->lookup_state(incons_list[i]);
+        // The list may contain a state more than once.
+        insert(search_space.get_node(state));
+    }
+    vector<StateID>().swap(incons_list);
+    cout << "Starting iteration with w = " << weight << " [t=" << g_timer
+         << "]" << endl;
+}
+
+void ARAStarSearch::statistics() const
+{
+    search_progress.print_statistics();
+    search_space.statistics();
+    cout << "Iterations: " << iteration + 1 << endl;
+    cout << "Plans found: " << plan_counter << endl;
+    if (found_solution()) {
+        cout << "Suboptimality bound: " << suboptimality_bound << endl;
+    }
+}
+
+void ARAStarSearch::save_plan_if_necessary() const
+{
+    // Every improved plan has already been saved.
+}
+
+static SearchEngine *_parse(OptionParser &parser)
+{
+    parser.document_synopsis(
+        "ARA* search",
+        "Anytime repairing A*: a sequence of weighted A* searches with "
+        "decreasing weights that reuses the g-values of the previous "
+        "searches and saves every improved plan. With an admissible "
+        "heuristic, the last plan is optimal.");
+    parser.document_note(
+        "Plan files",
+        "The i-th improved plan is written to sas_plan.i.");
+    parser.add_option<Heuristic *>("eval", "heuristic");
+    parser.add_option<double>("w", "weight of the first iteration", "5");
+    parser.add_option<double>(
+        "w_decrement", "amount by which the weight is lowered after each "
+        "iteration (it never gets smaller than 1)", "1");
+    SearchEngine::add_options_to_parser(parser);
+    Options opts = parser.parse();
+
+    if (opts.get<double>("w") < 1) {
+        parser.error("w must be at least 1");
+    }
+    if (opts.get<double>("w_decrement") <= 0) {
+        parser.error("w_decrement must be positive");
+    }
+    if (parser.dry_run()) {
+        return 0;
+    }
+    return new ARAStarSearch(opts);
+}
+
+static Plugin<SearchEngine> _plugin("ara_star", _parse);
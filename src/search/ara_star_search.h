@@ -0,0 +1,106 @@
+#ifndef ARA_STAR_SEARCH_H
+#define ARA_STAR_SEARCH_H
+
+#include "per_state_information.h"
+#include "search_engine.h"
+#include "state.h"
+
+#include <queue>
+#include <vector>
+
+// Usage example: the command line option for using ARA* with heuristic h,
+// initial weight x and weight decrement d is
+// ./fast-downward.py [path-to-PDDL-problem-file] --search "ara_star(h(), w=x, w_decrement=d)"
+// So, for h^{max}, starting with weight 5 and lowering it by 0.5 it is
+// ./fast-downward.py [path-to-PDDL-problem-file] --search "ara_star(hmax(), w=5, w_decrement=0.5)"
+// Every improved plan is written to sas_plan.1, sas_plan.2 and so on.
+// Obviously, [path-to-PDDL-problem-file] has to be replaced by the actual path
+// to the PDDL problem file.
+
+/*
+  Anytime repairing A* (Likhachev, Gordon & Thrun, 2003).
+
+  Each iteration is a weighted A* search with f = g + w * h that stops as
+  soon as no open state has a smaller f-value than the cost of the best
+  plan found so far. After an iteration, the weight is lowered and the
+  next iteration continues with the same g-values: states whose g-value
+  decreased after they were expanded in the current iteration are not put
+  into the open list again but into the INCONS list, and at the start of
+  the next iteration, the open list is rebuilt from the remaining open
+  states and the INCONS list with the new weight. So each state is
+  expanded at most once per iteration.
+
+  Every improved plan is saved as soon as it is found. At the end of each
+  iteration, the search reports the suboptimality bound
+  min(w, cost / min(g + h)) of the best plan, where the minimum is over all
+  open and inconsistent states. With an admissible heuristic,
+  the plan of the iteration with weight 1 is optimal and the search stops
+  early once the bound reaches 1. Once a plan has been found, it becomes
+  the cost bound for the rest of the search.
+*/
+
+class Heuristic;
+class Options;
+
+class ARAStarSearch : public SearchEngine
+{
+    struct OpenEntry {
+        double f;
+        int h;
+        // g-value of the state when it was inserted; the entry is stale if
+        // the g-value has changed since then.
+        int g;
+        StateID state_id;
+
+        OpenEntry(double f_, int h_, int g_, StateID state_id_)
+            : f(f_), h(h_), g(g_), state_id(state_id_)
+        {
+        }
+
+        bool operator>(const OpenEntry &other) const
+        {
+            if (f != other.f) {
+                return f > other.f;
+            }
+            return h > other.h;
+        }
+    };
+
+    typedef std::priority_queue<OpenEntry, std::vector<OpenEntry>,
+                                std::greater<OpenEntry>> OpenList;
+
+    Heuristic *heuristic;
+    double weight;
+    double weight_decrement;
+
+    OpenList open_list;
+    std::vector<StateID> incons_list;
+    // Iteration in which a state was last expanded.
+    PerStateInformation<int> expansion_iteration;
+    int iteration;
+
+    // Cost (with adjusted costs) of the best plan found so far.
+    int incumbent_g;
+    Plan incumbent_plan;
+    int plan_counter;
+    double suboptimality_bound;
+
+    std::vector<const Operator *> applicable_ops;
+
+    void insert(const SearchNode &node);
+    bool is_stale(const OpenEntry &entry);
+    void check_incumbent(const State &state, const SearchNode &node);
+    void expand(const State &state, SearchNode &node);
+    SearchStatus finish_iteration();
+    void start_iteration();
+protected:
+    virtual void initialize();
+    virtual SearchStatus step();
+public:
+    ARAStarSearch(const Options &opts);
+    virtual ~ARAStarSearch() = default;
+    virtual void statistics() const;
+    virtual void save_plan_if_necessary() const;
+};
+
+#endif
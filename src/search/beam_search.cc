@@ -0,0 +1,264 @@
+#include "beam_search.h"
+
+#include "globals.h"
+#include "heuristic.h"
+#include "option_parser.h"
+#include "plugin.h"
+#include "state_registry.h"
+#include "successor_generator.h"
+#include "utilities.h"
+
+#include <algorithm>
+#include <limits>
+
+using namespace std;
+
+
+BeamSearch::BeamSearch(const Options &opts)
+    : SearchEngine(opts),
+      heuristic(opts.get<Heuristic *>("eval")),
+      width(opts.get<int>("width")),
+      duplicate_filter(opts.get<int>("filter_size"), 0),
+      cut_off(false),
+      best_h(numeric_limits<int>::max()),
+      num_duplicates(0)
+{
+}
+
+bool BeamSearch::warm_start(const SearchEngine &previous)
+{
+    const BeamSearch *previous_search =
+        dynamic_cast<const BeamSearch *>(&previous);
+    // A beam that was never cut off has explored the whole state space.
+    if (!previous_search || !previous_search->cut_off) {
+        return false;
+    }
+    width = max(width, 2 * previous_search->width);
+    return true;
+}
+
+bool BeamSearch::can_continue() const
+{
+    return cut_off;
+}
+
+void BeamSearch::initialize()
+{
+    cout << "Conducting beam search with width " << width
+         << ", (real) bound = " << bound << endl;
+    search_progress.add_heuristic(heuristic);
+
+    layer_data.resize(g_state_packer->get_num_bins());
+    StateRegistry::compute_initial_state_data(&layer_data[0]);
+    insert_into_filter(&layer_data[0]);
+    State initial_state =
+        g_state_registry->get_unregistered_state(&layer_data[0]);
+    heuristic->evaluate(initial_state);
+    search_progress.inc_evaluated_states();
+    search_progress.inc_evaluations();
+    if (heuristic->is_dead_end()) {
+        cout << "Initial state is a dead end." << endl;
+        layer_data.clear();
+        return;
+    }
+    search_progress.get_initial_h_values();
+    best_h = heuristic->get_heuristic();
+    if (test_goal(initial_state)) {
+        cout << "Solution found!" << endl;
+        set_plan(Plan());
+    }
+    layers.push_back(vector<Link>(1, Link(-1, 0)));
+    layer_g.push_back(0);
+    layer_real_g.push_back(0);
+}
+
+unsigned long long BeamSearch::get_fingerprint(
+    const PackedStateBin *buffer) const
+{
+    unsigned long long hash = hash_number_sequence(
+        buffer, g_state_packer->get_num_bins());
+    // Mix the bits since the table index is taken modulo the table size.
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash ? hash : 1;
+}
+
+/*
+  Returns false if the state is a known duplicate and stores its fingerprint
+  otherwise.
+*/
+bool BeamSearch::insert_into_filter(const PackedStateBin *buffer)
+{
+    if (duplicate_filter.empty()) {
+        return true;
+    }
+    unsigned long long fingerprint = get_fingerprint(buffer);
+    unsigned long long &entry =
+        duplicate_filter[fingerprint % duplicate_filter.size()];
+    if (entry == fingerprint) {
+        return false;
+    }
+    entry = fingerprint;
+    return true;
+}
+
+void BeamSearch::extract_plan(int parent, const Operator *op)
+{
+    Plan plan;
+    plan.push_back(op);
+    for (int layer = layers.size() - 1; layer > 0; --layer) {
+        const Link &link = layers[layer][parent];
+        plan.push_back(link.op);
+        parent = link.parent;
+    }
+    reverse(plan.begin(), plan.end());
+    set_plan(plan);
+}
+
+SearchStatus BeamSearch::step()
+{
+    if (found_solution()) {
+        return SOLVED;
+    }
+    if (layer_g.empty()) {
+        if (cut_off) {
+            cout << "Beam search failed: no successors left." << endl;
+        } else {
+            cout << "Completely explored state space -- no solution!" << endl;
+        }
+        return FAILED;
+    }
+
+    size_t num_bins = g_state_packer->get_num_bins();
+    candidates.clear();
+    candidate_data.clear();
+    for (size_t i = 0; i < layer_g.size(); ++i) {
+        State state = g_state_registry->get_unregistered_state(
+            &layer_data[i * num_bins]);
+        search_progress.inc_expanded();
+        applicable_ops.clear();
+        g_successor_generator->generate_applicable_ops(state, applicable_ops);
+        search_progress.inc_generated_ops(applicable_ops.size());
+        for (size_t j = 0; j < applicable_ops.size(); ++j) {
+            const Operator *op = applicable_ops[j];
+            int succ_real_g = layer_real_g[i] + op->get_cost();
+            if (succ_real_g >= bound) {
+                continue;
+            }
+            size_t data_pos = candidate_data.size();
+            candidate_data.resize(data_pos + num_bins);
+            PackedStateBin *succ_data = &candidate_data[data_pos];
+            StateRegistry::compute_successor_data(state, *op, succ_data);
+            search_progress.inc_generated();
+            if (!insert_into_filter(succ_data)) {
+                ++num_duplicates;
+                candidate_data.resize(data_pos);
+                continue;
+            }
+            State succ_state =
+                g_state_registry->get_unregistered_state(succ_data);
+            if (test_goal(succ_state)) {
+                cout << "Solution found!" << endl;
+                extract_plan(i, op);
+                return SOLVED;
+            }
+            heuristic->evaluate(succ_state);
+            search_progress.inc_evaluated_states();
+            search_progress.inc_evaluations();
+            if (heuristic->is_dead_end()) {
+                search_progress.inc_dead_ends();
+                candidate_data.resize(data_pos);
+                continue;
+            }
+            int succ_g = layer_g[i] + get_adjusted_cost(*op);
+            candidates.push_back(Candidate(heuristic->get_heuristic(), succ_g,
+                                           succ_real_g, Link(i, op),
+                                           data_pos));
+        }
+    }
+
+    if (candidates.size() > static_cast<size_t>(width)) {
+        nth_element(candidates.begin(), candidates.begin() + width,
+                    candidates.end());
+        candidates.erase(candidates.begin() + width, candidates.end());
+        cut_off = true;
+    }
+
+    layers.push_back(vector<Link>());
+    vector<Link> &layer = layers.back();
+    layer.reserve(candidates.size());
+    layer_data.resize(candidates.size() * num_bins);
+    layer_g.clear();
+    layer_real_g.clear();
+    for (size_t i = 0; i < candidates.size(); ++i) {
+        const Candidate &candidate = candidates[i];
+        layer.push_back(candidate.link);
+        copy(candidate_data.begin() + candidate.data_pos,
+             candidate_data.begin() + candidate.data_pos + num_bins,
+             layer_data.begin() + i * num_bins);
+        layer_g.push_back(candidate.g);
+        layer_real_g.push_back(candidate.real_g);
+        if (candidate.h < best_h) {
+            best_h = candidate.h;
+            cout << "Best heuristic value: " << best_h << " [layer "
+                 << layers.size() - 1 << ", expanded "
+                 << search_progress.get_expanded() << " state(s), t="
+                 << g_timer << "]" << endl;
+        }
+    }
+    return IN_PROGRESS;
+}
+
+void BeamSearch::statistics() const
+{
+    search_progress.print_statistics();
+    cout << "Beam width: " << width << endl;
+    cout << "Layers: " << layers.size() << endl;
+    cout << "Filtered duplicates: " << num_duplicates << endl;
+}
+
+static SearchEngine *_parse(OptionParser &parser)
+{
+    parser.document_synopsis(
+        "Beam search",
+        "Breadth-first search that keeps only the width best successors "
+        "(by h) of each layer. Uses memory linear in width times the plan "
+        "length plus a fixed-size duplicate filter. Incomplete unless no "
+        "layer has to be cut off.");
+    parser.document_note(
+        "Restarts",
+        "When warm-started from a previous beam search in an iterated "
+        "search, the width is twice the previous width.");
+    parser.document_note(
+        "Heuristics",
+        "States are not registered, so heuristics that store information "
+        "per state or rely on reach_state are not supported.");
+    parser.add_option<Heuristic *>("eval", "heuristic");
+    parser.add_option<int>("width", "number of states kept per layer", "100");
+    parser.add_option<int>(
+        "filter_size",
+        "number of entries of the duplicate filter (0 disables it)",
+        "1000000");
+    SearchEngine::add_options_to_parser(parser);
+    Options opts = parser.parse();
+
+    if (opts.get<int>("width") < 1) {
+        parser.error("width must be positive");
+    }
+    if (opts.get<int>("filter_size") < 0) {
+        parser.error("filter_size must not be negative");
+    }
+    if (parser.dry_run()) {
+        return 0;
+    }
+    if (opts.get<Heuristic *>("eval")->is_path_dependent()) {
+        parser.error("beam does not support heuristics that depend on the "
+                     "path to a state");
+    }
+    return new BeamSearch(opts);
+}
+
+static Plugin<SearchEngine> _plugin("beam", _parse);
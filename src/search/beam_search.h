@@ -0,0 +1,110 @@
+#ifndef BEAM_SEARCH_H
+#define BEAM_SEARCH_H
+
+#include "search_engine.h"
+#include "state.h"
+
+#include <vector>
+
+// Usage example: the command line option for using beam search with
+// heuristic h and beam width K is
+// ./fast-downward.py [path-to-PDDL-problem-file] --search "beam(h(), width=K)"
+// To restart with doubled widths until a plan is found (and then to keep
+// looking for cheaper plans with doubled widths), use iterated search:
+// ./fast-downward.py [path-to-PDDL-problem-file] --search "iterated([beam(ff(), width=100)], repeat_last=true, continue_on_fail=true)"
+// Obviously, [path-to-PDDL-problem-file] has to be replaced by the actual path
+// to the PDDL problem file.
+
+/*
+  Beam search: a breadth-first search that keeps only the K successors with
+  the smallest h-values (ties broken by smaller g) of each layer. The K best
+  candidates are selected with nth_element, so a layer is never sorted.
+
+  States are not registered. The search stores the packed data of the
+  current layer only and, for every earlier layer, the parent index and
+  operator of each state, which is enough to extract the plan. So it needs
+  O(K * depth) memory instead of memory linear in the number of states.
+  Duplicates are detected with a fixed-size table of 64-bit fingerprints of
+  generated states (as in the IDA* transposition table); colliding states
+  replace each other, so some duplicates are generated again.
+
+  A goal test is done when a state is generated. If a layer becomes empty
+  without any layer having been cut off, the state space (within the bound)
+  has been explored completely. Otherwise, a warm start from a failed or
+  solved beam search doubles the width, which lets iterated search restart
+  with wider beams.
+*/
+
+class Heuristic;
+class Options;
+
+class BeamSearch : public SearchEngine
+{
+    // Describes how a state of a layer was reached from the previous layer.
+    struct Link {
+        int parent;
+        const Operator *op;
+
+        Link(int parent_, const Operator *op_)
+            : parent(parent_), op(op_)
+        {
+        }
+    };
+
+    struct Candidate {
+        int h;
+        int g;
+        int real_g;
+        Link link;
+        // Offset of the packed state data in candidate_data.
+        size_t data_pos;
+
+        Candidate(int h_, int g_, int real_g_, const Link &link_,
+                  size_t data_pos_)
+            : h(h_), g(g_), real_g(real_g_), link(link_), data_pos(data_pos_)
+        {
+        }
+
+        bool operator<(const Candidate &other) const
+        {
+            if (h != other.h) {
+                return h < other.h;
+            }
+            return g < other.g;
+        }
+    };
+
+    Heuristic *heuristic;
+    int width;
+    // Fingerprints of generated states (0 marks empty entries).
+    std::vector<unsigned long long> duplicate_filter;
+
+    std::vector<std::vector<Link>> layers;
+    // Packed data, g and real g of the states of the last layer.
+    std::vector<PackedStateBin> layer_data;
+    std::vector<int> layer_g;
+    std::vector<int> layer_real_g;
+
+    std::vector<Candidate> candidates;
+    std::vector<PackedStateBin> candidate_data;
+    std::vector<const Operator *> applicable_ops;
+
+    bool cut_off;
+    int best_h;
+    int num_duplicates;
+
+    unsigned long long get_fingerprint(const PackedStateBin *buffer) const;
+    bool insert_into_filter(const PackedStateBin *buffer);
+    void extract_plan(int parent, const Operator *op);
+protected:
+    virtual void initialize();
+    virtual SearchStatus step();
+public:
+    BeamSearch(const Options &opts);
+    virtual ~BeamSearch() = default;
+    virtual bool warm_start(const SearchEngine &previous);
+    virtual bool can_continue() const;
+    virtual void statistics() const;
+};
+
+#endif
@@ -0,0 +1,139 @@
+#include "bfws_search.h"
+
+#include "globals.h"
+#include "heuristic.h"
+#include "option_parser.h"
+#include "plugin.h"
+#include "successor_generator.h"
+
+using namespace std;
+
+
+BFWSSearch::BFWSSearch(const Options &opts)
+    : SearchEngine(opts),
+      heuristic(opts.get<Heuristic *>("eval")),
+      novelty_table(opts.get<int>("width")),
+      expanded_by_novelty(opts.get<int>("width") + 2, 0)
+{
+}
+
+void BFWSSearch::initialize()
+{
+    cout << "Conducting best-first width search with width "
+         << novelty_table.get_max_novelty() << ", (real) bound = " << bound
+         << endl;
+    search_progress.add_heuristic(heuristic);
+
+    const State &initial_state = g_initial_state();
+    heuristic->evaluate(initial_state);
+    search_progress.inc_evaluated_states();
+    search_progress.inc_evaluations();
+    if (heuristic->is_dead_end()) {
+        cout << "Initial state is a dead end." << endl;
+        return;
+    }
+    search_progress.get_initial_h_values();
+    search_progress.check_h_progress(0);
+    SearchNode node = search_space.get_node(initial_state);
+    node.open_initial(heuristic->get_heuristic());
+    insert(initial_state, node.get_h());
+}
+
+void BFWSSearch::insert(const State &state, int h)
+{
+    int novelty = novelty_table.compute_and_insert(state, h);
+    open_buckets[make_pair(novelty, h)].push_back(state.get_id());
+}
+
+SearchStatus BFWSSearch::step()
+{
+    if (open_buckets.empty()) {
+        cout << "Completely explored state space -- no solution!" << endl;
+        return FAILED;
+    }
+    deque<StateID> &bucket = open_buckets.begin()->second;
+    int novelty = open_buckets.begin()->first.first;
+    State state = g_state_registry->lookup_state(bucket.front());
+    bucket.pop_front();
+    if (bucket.empty()) {
+        open_buckets.erase(open_buckets.begin());
+    }
+    SearchNode node = search_space.get_node(state);
+    node.close();
+    if (check_goal_and_set_plan(state)) {
+        return SOLVED;
+    }
+    search_progress.inc_expanded();
+    ++expanded_by_novelty[novelty];
+
+    applicable_ops.clear();
+    g_successor_generator->generate_applicable_ops(state, applicable_ops);
+    search_progress.inc_generated_ops(applicable_ops.size());
+    for (size_t i = 0; i < applicable_ops.size(); ++i) {
+        const Operator *op = applicable_ops[i];
+        if (node.get_real_g() + op->get_cost() >= bound) {
+            continue;
+        }
+        State succ_state = g_state_registry->get_successor_state(state, *op);
+        search_progress.inc_generated();
+        SearchNode succ_node = search_space.get_node(succ_state);
+        if (!succ_node.is_new()) {
+            continue;
+        }
+        heuristic->reach_state(state, *op, succ_state);
+        heuristic->evaluate(succ_state);
+        search_progress.inc_evaluated_states();
+        search_progress.inc_evaluations();
+        if (heuristic->is_dead_end()) {
+            succ_node.mark_as_dead_end();
+            search_progress.inc_dead_ends();
+            continue;
+        }
+        succ_node.open(heuristic->get_heuristic(), node, op);
+        search_progress.check_h_progress(succ_node.get_g());
+        insert(succ_state, succ_node.get_h());
+    }
+    return IN_PROGRESS;
+}
+
+void BFWSSearch::statistics() const
+{
+    search_progress.print_statistics();
+    search_space.statistics();
+    for (size_t novelty = 1; novelty < expanded_by_novelty.size(); ++novelty) {
+        cout << "Expanded states with novelty ";
+        if (static_cast<int>(novelty) > novelty_table.get_max_novelty()) {
+            cout << "> " << novelty_table.get_max_novelty();
+        } else {
+            cout << novelty;
+        }
+        cout << ": " << expanded_by_novelty[novelty] << endl;
+    }
+    cout << "Novelty partitions: " << novelty_table.get_num_partitions()
+         << endl;
+}
+
+static SearchEngine *_parse(OptionParser &parser)
+{
+    parser.document_synopsis(
+        "Best-first width search",
+        "Greedy best-first search ordered by the novelty of a state among "
+        "the states with the same heuristic value and then by the heuristic "
+        "value. With gc(), this is BFWS(f5).");
+    parser.add_option<Heuristic *>(
+        "eval", "heuristic that partitions the novelty tables");
+    parser.add_option<int>("width", "maximum novelty that is computed (1 or 2)",
+                           "2");
+    SearchEngine::add_options_to_parser(parser);
+    Options opts = parser.parse();
+
+    if (opts.get<int>("width") < 1 || opts.get<int>("width") > 2) {
+        parser.error("width must be 1 or 2");
+    }
+    if (parser.dry_run()) {
+        return 0;
+    }
+    return new BFWSSearch(opts);
+}
+
+static Plugin<SearchEngine> _plugin("bfws", _parse);
@@ -0,0 +1,57 @@
+#ifndef BFWS_SEARCH_H
+#define BFWS_SEARCH_H
+
+#include "novelty_table.h"
+#include "search_engine.h"
+#include "state.h"
+
+#include <deque>
+#include <map>
+#include <utility>
+#include <vector>
+
+// Usage example: the command line option for using best-first width search
+// with heuristic h is
+// ./fast-downward.py [path-to-PDDL-problem-file] --search "bfws(h())"
+// So, for the goal count heuristic (BFWS(f5)) it is
+// ./fast-downward.py [path-to-PDDL-problem-file] --search "bfws(gc())"
+// Obviously, [path-to-PDDL-problem-file] has to be replaced by the actual path
+// to the PDDL problem file.
+
+/*
+  Best-first width search (Lipovetzky & Geffner, 2017).
+
+  Greedy best-first search that orders the open states by <w, h> (ties are
+  broken in FIFO order), where w is the novelty of the state among the
+  generated states with the same h-value (see NoveltyTable) and h is the
+  value of the given heuristic. With the goal count heuristic, this is the
+  BFWS(f5) configuration without the relaxed-plan partitioning. Novelty is
+  computed once, when a state is generated, and states that are not novel
+  up to the given width are not pruned but get the lowest priority.
+*/
+
+class Heuristic;
+class Options;
+
+class BFWSSearch : public SearchEngine
+{
+    Heuristic *heuristic;
+    NoveltyTable novelty_table;
+
+    // Open states by (novelty, h).
+    std::map<std::pair<int, int>, std::deque<StateID>> open_buckets;
+    std::vector<const Operator *> applicable_ops;
+    // Number of expanded states for each novelty.
+    std::vector<int> expanded_by_novelty;
+
+    void insert(const State &state, int h);
+protected:
+    virtual void initialize();
+    virtual SearchStatus step();
+public:
+    BFWSSearch(const Options &opts);
+    virtual ~BFWSSearch() = default;
+    virtual void statistics() const;
+};
+
+#endif
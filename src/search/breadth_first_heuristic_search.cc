@@ -0,0 +1,340 @@
+#include "breadth_first_heuristic_search.h"
+
+#include "globals.h"
+#include "heuristic.h"
+#include "option_parser.h"
+#include "plugin.h"
+#include "successor_generator.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+using namespace std;
+
+static const size_t EVALUATION_REGISTRY_SIZE = 1024;
+
+BreadthFirstHeuristicSearch::BreadthFirstHeuristicSearch(const Options &opts)
+    : SearchEngine(opts),
+      heuristic(opts.get<Heuristic *>("eval")),
+      f_bound(opts.get<int>("f_bound")),
+      iterative_deepening(f_bound == -1),
+      next_f_bound(numeric_limits<int>::max()),
+      evaluation_registry(0),
+      peak_stored_states(0),
+      num_iterations(0)
+{
+}
+
+void BreadthFirstHeuristicSearch::initialize()
+{
+    cout << "Conducting breadth-first heuristic search, (real) bound = "
+         << bound << endl;
+    for (size_t i = 0; i < g_operators.size(); ++i) {
+        if (get_adjusted_cost(g_operators[i]) != 1) {
+            cerr << "bfhs only supports unit-cost tasks "
+                 << "(use cost_type=one to ignore action costs)." << endl;
+            exit_with(EXIT_UNSUPPORTED);
+        }
+    }
+
+    search_progress.add_heuristic(heuristic);
+    const State &initial_state = g_initial_state();
+    get_state_data(initial_state, initial_state_data);
+    heuristic->evaluate(initial_state);
+    search_progress.inc_evaluated_states();
+    search_progress.inc_evaluations();
+    if (heuristic->is_dead_end()) {
+        cout << "Initial state is a dead end." << endl;
+        f_bound = -1;
+        return;
+    }
+    search_progress.get_initial_h_values();
+    if (iterative_deepening) {
+        f_bound = heuristic->get_heuristic();
+    }
+}
+
+void BreadthFirstHeuristicSearch::get_state_data(const State &state,
+                                                 StateData &data)
+{
+    data.assign(g_state_packer->get_num_bins(), 0);
+    for (size_t var = 0; var < g_variable_domain.size(); ++var) {
+        g_state_packer->set(&data[0], var, state[var]);
+    }
+}
+
+bool BreadthFirstHeuristicSearch::has_state_data(const State &state,
+                                                 const StateData &data)
+{
+    for (size_t var = 0; var < g_variable_domain.size(); ++var) {
+        if (state[var] != g_state_packer->get(&data[0], var)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+SearchStatus BreadthFirstHeuristicSearch::step()
+{
+    if (f_bound == -1) {
+        return FAILED;
+    }
+    if (f_bound >= bound) {
+        cout << "No solution with cost below the bound." << endl;
+        return FAILED;
+    }
+    ++num_iterations;
+    cout << "f_bound = " << f_bound << " [t=" << g_timer << "]" << endl;
+
+    next_f_bound = numeric_limits<int>::max();
+    StateData goal;
+    StateData relay;
+    int relay_depth;
+    int depth = search_layers(initial_state_data, 0, 0, f_bound, f_bound,
+                              goal, relay, relay_depth);
+    if (depth != -1) {
+        cout << "Solution found with cost " << depth
+             << ", reconstructing plan..." << endl;
+        Plan plan;
+        if (relay.empty()) {
+            reconstruct_path(initial_state_data, goal, 0, depth, depth, plan);
+        } else {
+            reconstruct_path(initial_state_data, relay, 0, relay_depth, depth,
+                             plan);
+            reconstruct_path(relay, goal, relay_depth, depth - relay_depth,
+                             depth, plan);
+        }
+        set_plan(plan);
+        return SOLVED;
+    }
+    if (next_f_bound == numeric_limits<int>::max()) {
+        cout << "Completely explored state space -- no solution!" << endl;
+        return FAILED;
+    }
+    if (!iterative_deepening) {
+        cout << "No solution with f <= f_bound." << endl;
+        return FAILED;
+    }
+    f_bound = next_f_bound;
+    return IN_PROGRESS;
+}
+
+/*
+  Breadth-first search from start that stops at the first state in depth at
+  most max_depth that is the target (or a goal state if target is 0) and
+  prunes states with g_start + depth + h > cost_bound. Returns the depth of
+  the target and writes its data to end or returns -1 if it is not found.
+  If the target is at least relay_depth deep, its ancestor in that depth is
+  written to relay, otherwise relay is cleared.
+*/
+int BreadthFirstHeuristicSearch::search_layers(
+    const StateData &start, const StateData *target, int g_start,
+    int max_depth, int cost_bound, StateData &end, StateData &relay,
+    int &relay_depth)
+{
+    relay_depth = max(1, max_depth / 2);
+    relay.clear();
+
+    StateRegistry *relay_layer = 0;
+    StateRegistry *previous = 0;
+    StateRegistry *current = new StateRegistry();
+    current->register_state_data(&start[0]);
+    StateData buffer(g_state_packer->get_num_bins());
+    evaluation_registry = new StateRegistry();
+
+    int found_depth = -1;
+    for (int depth = 0; ; ++depth) {
+        for (StateRegistry::const_iterator it = current->begin();
+             it != current->end(); ++it) {
+            State state = current->lookup_state(*it);
+            const LayerNodeInfo &info = node_infos[state];
+            if (target ? has_state_data(state, *target) : test_goal(state)) {
+                get_state_data(state, end);
+                if (info.relay_id != StateID::no_state) {
+                    get_state_data(relay_layer->lookup_state(info.relay_id),
+                                   relay);
+                }
+                found_depth = depth;
+                break;
+            }
+        }
+        if (found_depth != -1 || depth == max_depth) {
+            break;
+        }
+
+        StateRegistry *next = new StateRegistry();
+        if (depth + 1 == relay_depth) {
+            relay_layer = next;
+        }
+        int succ_g = g_start + depth + 1;
+        for (StateRegistry::const_iterator it = current->begin();
+             it != current->end(); ++it) {
+            State state = current->lookup_state(*it);
+            StateID relay_id = node_infos[state].relay_id;
+            search_progress.inc_expanded();
+            applicable_ops.clear();
+            g_successor_generator->generate_applicable_ops(state,
+                                                           applicable_ops);
+            search_progress.inc_generated_ops(applicable_ops.size());
+            for (size_t i = 0; i < applicable_ops.size(); ++i) {
+                StateRegistry::compute_successor_data(
+                    state, *applicable_ops[i], &buffer[0]);
+                search_progress.inc_generated();
+                if ((previous && previous->find_state_data(&buffer[0])
+                     != StateID::no_state) ||
+                    current->find_state_data(&buffer[0]) != StateID::no_state ||
+                    next->find_state_data(&buffer[0]) != StateID::no_state) {
+                    continue;
+                }
+                /*
+                  Pruned states are not stored, so we evaluate the state in a
+                  scratch registry that we discard every now and then.
+                */
+                if (evaluation_registry->size() >= EVALUATION_REGISTRY_SIZE) {
+                    delete evaluation_registry;
+                    evaluation_registry = new StateRegistry();
+                }
+                heuristic->evaluate(
+                    evaluation_registry->register_state_data(&buffer[0]));
+                search_progress.inc_evaluated_states();
+                search_progress.inc_evaluations();
+                if (heuristic->is_dead_end()) {
+                    search_progress.inc_dead_ends();
+                    continue;
+                }
+                int succ_f = succ_g + heuristic->get_heuristic();
+                if (succ_f > cost_bound) {
+                    next_f_bound = min(next_f_bound, succ_f);
+                    continue;
+                }
+                State succ_state = next->register_state_data(&buffer[0]);
+                LayerNodeInfo &succ_info = node_infos[succ_state];
+                if (depth + 1 == relay_depth) {
+                    succ_info.relay_id = succ_state.get_id();
+                } else {
+                    succ_info.relay_id = relay_id;
+                }
+            }
+        }
+
+        size_t stored_states = current->size() + next->size();
+        if (previous) {
+            stored_states += previous->size();
+        }
+        if (relay_layer && relay_layer != previous && relay_layer != current &&
+            relay_layer != next) {
+            stored_states += relay_layer->size();
+        }
+        peak_stored_states = max(peak_stored_states, stored_states);
+
+        // Drop the oldest layer unless it is the relay layer.
+        if (previous != relay_layer) {
+            delete previous;
+        }
+        previous = current;
+        current = next;
+        if (current->size() == 0) {
+            break;
+        }
+    }
+
+    if (previous != relay_layer) {
+        delete previous;
+    }
+    if (current != relay_layer) {
+        delete current;
+    }
+    delete relay_layer;
+    delete evaluation_registry;
+    evaluation_registry = 0;
+    return found_depth;
+}
+
+/*
+  Appends a path of the given depth from start to end to plan. Every
+  intermediate state of the path has f <= cost_bound.
+*/
+void BreadthFirstHeuristicSearch::reconstruct_path(
+    const StateData &start, const StateData &end, int g_start, int depth,
+    int cost_bound, Plan &plan)
+{
+    if (depth == 0) {
+        return;
+    }
+    if (depth == 1) {
+        StateRegistry registry;
+        State state = registry.register_state_data(&start[0]);
+        applicable_ops.clear();
+        g_successor_generator->generate_applicable_ops(state, applicable_ops);
+        StateData buffer(g_state_packer->get_num_bins());
+        for (size_t i = 0; i < applicable_ops.size(); ++i) {
+            StateRegistry::compute_successor_data(state, *applicable_ops[i],
+                                                  &buffer[0]);
+            State succ_state = registry.register_state_data(&buffer[0]);
+            if (has_state_data(succ_state, end)) {
+                plan.push_back(applicable_ops[i]);
+                return;
+            }
+        }
+        cerr << "bfhs: plan reconstruction failed." << endl;
+        exit_with(EXIT_CRITICAL_ERROR);
+    }
+
+    StateData segment_end;
+    StateData relay;
+    int relay_depth;
+    int found_depth = search_layers(start, &end, g_start, depth, cost_bound,
+                                    segment_end, relay, relay_depth);
+    if (found_depth == -1) {
+        cerr << "bfhs: plan reconstruction failed." << endl;
+        exit_with(EXIT_CRITICAL_ERROR);
+    }
+    if (relay.empty()) {
+        // The end state is closer than the relay layer.
+        reconstruct_path(start, end, g_start, found_depth, cost_bound, plan);
+    } else {
+        reconstruct_path(start, relay, g_start, relay_depth, cost_bound, plan);
+        reconstruct_path(relay, end, g_start + relay_depth,
+                         found_depth - relay_depth, cost_bound, plan);
+    }
+}
+
+void BreadthFirstHeuristicSearch::statistics() const
+{
+    search_progress.print_statistics();
+    cout << "Iterations: " << num_iterations << endl;
+    cout << "Peak number of stored states: " << peak_stored_states << endl;
+}
+
+static SearchEngine *_parse(OptionParser &parser)
+{
+    parser.document_synopsis(
+        "Breadth-first heuristic search",
+        "Layered breadth-first search with f-pruning that only stores a few "
+        "layers and reconstructs the plan by divide and conquer. Finds "
+        "optimal plans for unit-cost tasks with admissible heuristics.");
+    parser.document_note(
+        "Heuristics",
+        "The heuristic is not told the paths to the states (reach_state), "
+        "so heuristics that depend on them are not supported.");
+    parser.add_option<Heuristic *>("eval", "heuristic");
+    parser.add_option<int>(
+        "f_bound",
+        "prune states with f > f_bound; -1 for iterative deepening starting "
+        "with the heuristic value of the initial state",
+        "-1");
+    SearchEngine::add_options_to_parser(parser);
+    Options opts = parser.parse();
+
+    if (parser.dry_run()) {
+        return 0;
+    }
+    if (opts.get<Heuristic *>("eval")->is_path_dependent()) {
+        parser.error("bfhs does not support heuristics that depend on the "
+                     "path to a state");
+    }
+    return new BreadthFirstHeuristicSearch(opts);
+}
+
+static Plugin<SearchEngine> _plugin("bfhs", _parse);
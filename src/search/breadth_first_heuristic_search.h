@@ -0,0 +1,87 @@
+#ifndef BREADTH_FIRST_HEURISTIC_SEARCH_H
+#define BREADTH_FIRST_HEURISTIC_SEARCH_H
+
+#include "per_state_information.h"
+#include "search_engine.h"
+#include "state_id.h"
+#include "state_registry.h"
+
+#include <vector>
+
+// Usage example: the command line option for using breadth-first heuristic
+// search with heuristic h is
+// ./fast-downward.py [path-to-PDDL-problem-file] --search "bfhs(h())"
+// So, for the h^{max} heuristic it is
+// ./fast-downward.py [path-to-PDDL-problem-file] --search "bfhs(hmax())"
+// Obviously, [path-to-PDDL-problem-file] has to be replaced by the actual path
+// to the PDDL problem file.
+
+/*
+  Breadth-first heuristic search (Zhou & Hansen, 2006) for unit-cost tasks.
+
+  The search expands the state space layer by layer and prunes states with
+  g + h > f_bound. Only the previous, current and next layer are stored
+  (each in its own state registry, which frees its memory when the layer is
+  dropped), plus one relay layer in the middle of the search depth. Pruned
+  states are not stored at all. Every state remembers its ancestor in the
+  relay layer instead of its parent.
+
+  When a goal is found, the plan is reconstructed by divide and conquer:
+  the relay state splits the plan into two halves, each of which is found
+  by a breadth-first search between two known states (pruned with the cost
+  of the plan) and split again recursively.
+
+  If no f_bound is given, it is increased by iterative deepening starting
+  with the heuristic value of the initial state. In both cases it is
+  limited by the bound of the search engine (e.g., set by iterated search).
+*/
+
+class Heuristic;
+class Options;
+
+class BreadthFirstHeuristicSearch : public SearchEngine
+{
+    typedef std::vector<PackedStateBin> StateData;
+
+    struct LayerNodeInfo {
+        // Ancestor in the relay layer; no_state above the relay layer.
+        StateID relay_id;
+
+        LayerNodeInfo()
+            : relay_id(StateID::no_state)
+        {
+        }
+    };
+
+    Heuristic *heuristic;
+    int f_bound;
+    bool iterative_deepening;
+    // Smallest f-value above f_bound seen in the current iteration.
+    int next_f_bound;
+
+    PerStateInformation<LayerNodeInfo> node_infos;
+    // Holds states only while they are evaluated (see search_layers).
+    StateRegistry *evaluation_registry;
+    StateData initial_state_data;
+    std::vector<const Operator *> applicable_ops;
+    size_t peak_stored_states;
+    int num_iterations;
+
+    static void get_state_data(const State &state, StateData &data);
+    static bool has_state_data(const State &state, const StateData &data);
+
+    int search_layers(const StateData &start, const StateData *target,
+                      int g_start, int max_depth, int cost_bound,
+                      StateData &end, StateData &relay, int &relay_depth);
+    void reconstruct_path(const StateData &start, const StateData &end,
+                          int g_start, int depth, int cost_bound, Plan &plan);
+protected:
+    virtual void initialize();
+    virtual SearchStatus step();
+public:
+    BreadthFirstHeuristicSearch(const Options &opts);
+    virtual ~BreadthFirstHeuristicSearch() = default;
+    virtual void statistics() const;
+};
+
+#endif
@@ -5,29 +5,36 @@
 #include "successor_generator.h"
 #include "utilities.h"
 
-#include <cassert>
 #include <algorithm>
-#include <numeric>
-
-
+#include <cassert>
+#include <deque>
+#include <limits>
 
 using namespace std;
 
+// h-value stored for dead ends in the plateau nodes
+static const int DEAD_END_H = numeric_limits<int>::max();
+
 EnforcedHillClimbingSearch::EnforcedHillClimbingSearch(
     const Options& opts)
     : SearchEngine(opts),
     helpful_actions(opts.get<bool>("helpful_actions")),
     heuristic(opts.get<Heuristic* >("heuristic")),
+    registry(0),
     current_state(g_initial_state()),
-    current_g(0)
+    current_h(0),
+    current_g(0),
+    num_phases(0),
+    num_fallback_phases(0),
+    num_restarts(0),
+    max_plateau_size(0)
 {
     search_progress.add_heuristic(heuristic);
 }
 
 EnforcedHillClimbingSearch::~EnforcedHillClimbingSearch()
 {
-
-
+    delete registry;
 }
 
 void EnforcedHillClimbingSearch::initialize()
@@ -39,7 +46,7 @@ void EnforcedHillClimbingSearch::initialize()
         cout << "Performing helpful actions pruning" << endl;
     }
 
-    evaluate(current_state, NULL, current_state);
+    reset_to_initial_state();
 
     if (heuristic->is_dead_end()) {
         cout << "Initial state is a dead end, no solution" << endl;
@@ -51,8 +58,19 @@ void EnforcedHillClimbingSearch::initialize()
     }
 
     search_progress.get_initial_h_values();
+}
 
+void EnforcedHillClimbingSearch::reset_to_initial_state()
+{
+    delete registry;
+    registry = new StateRegistry();
+    current_state_data.assign(g_state_packer->get_num_bins(), 0);
+    StateRegistry::compute_initial_state_data(&current_state_data[0]);
+    current_state = registry->register_state_data(&current_state_data[0]);
+    evaluate(current_state, NULL, current_state);
     current_h = heuristic->get_heuristic();
+    current_g = 0;
+    plan.clear();
 }
 
 void EnforcedHillClimbingSearch::evaluate(const State& parent,
@@ -63,25 +81,55 @@ void EnforcedHillClimbingSearch::evaluate(const State& parent,
     if (op != NULL) {
         heuristic->reach_state(parent, *op, state);
     }
-    heuristic->evaluate(state);
+    // Helpful actions are not cached, so they need a fresh evaluation.
+    if (helpful_actions) {
+        heuristic->evaluate_uncached(state);
+    } else {
+        heuristic->evaluate(state);
+    }
 
     search_progress.inc_evaluations();
     // current_g is not the g-value of state, but rather of current_state
     // since it is only used for statistics output, it doesn't matter too much
     search_progress.check_h_progress(current_g);
+
+    PlateauNode &node = plateau_nodes[state];
+    if (heuristic->is_dead_end()) {
+        node.h = DEAD_END_H;
+    } else {
+        node.h = heuristic->get_heuristic();
+        if (helpful_actions) {
+            heuristic->get_helpful_actions(node.helpful_ops);
+        }
+    }
 }
 
 void EnforcedHillClimbingSearch::get_applicable_operators(const State& state,
-    vector<const Operator*>& ops)
+    vector<const Operator*>& ops, bool use_helpful_actions)
 {
     g_successor_generator->generate_applicable_ops(state, ops);
 
     search_progress.inc_expanded();
-    search_progress.inc_generated_ops(ops.size());
 
-    // TODO: implement helpful actions prunining here
-    // Use the helpful_actions class variable to determine whether helpful
-    // actions pruning is enabled or not.
+    PlateauNode &node = plateau_nodes[state];
+    if (use_helpful_actions && !node.helpful_ops.empty()) {
+        // Helpful actions need not be applicable, so intersect both sets.
+        vector<const Operator*> &helpful = node.helpful_ops;
+        sort(helpful.begin(), helpful.end());
+        size_t num_helpful = 0;
+        for (size_t i = 0; i < ops.size(); ++i) {
+            if (binary_search(helpful.begin(), helpful.end(), ops[i])) {
+                ops[num_helpful++] = ops[i];
+            }
+        }
+        // Fall back to all applicable operators if none is helpful.
+        if (num_helpful > 0) {
+            ops.resize(num_helpful);
+        }
+    }
+    vector<const Operator*>().swap(node.helpful_ops);
+
+    search_progress.inc_generated_ops(ops.size());
 
 #ifndef NDEBUG
     for (const Operator* op : ops) {
@@ -90,197 +138,139 @@ void EnforcedHillClimbingSearch::get_applicable_operators(const State& state,
 #endif
 }
 
-// Combinations without order, with duplicates 
-std::vector<std::vector<int>> getCombinations(int n, int depth) {
-    std::vector<std::vector<int>> combinations;
-    if (depth == 0) {
-        combinations.push_back({});
-        return combinations;
+// Each call is one improvement phase. After a successful phase,
+// current_state is the better state and the plan leads to it.
+SearchStatus EnforcedHillClimbingSearch::hill_climbing()
+{
+    if (test_goal(current_state)) {
+        cout << "Found a goal state!" << endl;
+        assert(is_plan(plan));
+        set_plan(plan);
+        return SOLVED;
     }
-    for (int i = 0; i < n; i++) {
-        std::vector<std::vector<int>> subcombinations = getCombinations(n, depth - 1);
-        for (auto& subcombination : subcombinations) {
-            subcombination.push_back(i);
-            std::sort(subcombination.begin(), subcombination.end());
-            if (std::find(combinations.begin(), combinations.end(), subcombination) == combinations.end()) {
-                combinations.push_back(subcombination);
-            }
+
+    if (improve(helpful_actions)) {
+        return IN_PROGRESS;
+    }
+    if (helpful_actions) {
+        cout << "No better state reachable with helpful actions, "
+             << "repeating phase with all successors" << endl;
+        ++num_fallback_phases;
+        if (improve(false)) {
+            return IN_PROGRESS;
         }
     }
-    return combinations;
-}
-
-// Order the possible clause learning:
-//  clausels are first learned if they are closer it is to the problem.
-bool compareVectors(const std::vector<int>& a, const std::vector<int>& b) {
-    int sumA = 0;
-    for (int x : a) sumA += x;
-    int sumB = 0;
-    for (int x : b) sumB += x;
-    return sumA > sumB;
+    if (plan.empty()) {
+        cout << "No state with a smaller heuristic value reachable from the "
+             << "initial state -- enforced hill-climbing failed" << endl;
+        return FAILED;
+    }
+    /*
+      Each restart avoids one more state, so the search terminates. All
+      states reachable without the avoided states are considered again.
+    */
+    avoided_states.register_state_data(&current_state_data[0]);
+    ++num_restarts;
+    cout << "No state with a smaller heuristic value reachable, restarting "
+         << "from the initial state (avoiding " << avoided_states.size()
+         << " state(s))" << endl;
+    reset_to_initial_state();
+    return IN_PROGRESS;
 }
 
-// this function is called only once for the input planning task.
-// if current_state is a goal state, search will break out of the while loop,
-// output some statistics and store the plan.
-// if enforced hill-climbing did not find a solution, you need to "return FAILED;"
-SearchStatus EnforcedHillClimbingSearch::hill_climbing()
+bool EnforcedHillClimbingSearch::improve(bool use_helpful_actions)
 {
-    // functions that you have to use:
-
-    // get_applicable_operators(state,  ops):
-    // see description in header file
-
-    // evaluate(parent, operator*, state):
-    // after a call to evaluate(..), you can query the heuristic by using
-    // heuristic->is_dead_end(): returns true if the heuristic detected state as a dead-end
-    // heuristic->get_heuristic(): returns the heuristic value of state
-
-    // NOTE: if for an evaluated state, heuristic->is_dead_end() returns true,
-    // then heuristic->get_heuristic() returns DEAD_END.
-
-    // g_state_registry->get_successor_state(state, operator):
-    // returns the outcome state when applying operator to state
-
-    // g_state_registry->lookup_state(id): if you stored the StateID of a state, you can
-    // retrieve the corresponding state by a call to this function.
-
-    // NOTE: To augment the statistics output, you can call search_progess->inc_generated()
-    // whenever you generated a new state and search_progess->inc_dead_ends() if
-    // you detected a new dead-end state
-
-    // remember to keep the variables
-    //      current_state
-    //      current_h
-    //      current_g
-    //      plan
-    // up-to-date
-
-    // IMPORTANT: after each breadth-first-search for a state with smaller
-    // heuristic value, you have to make sure that you append the entire path
-    // from the old state to the new state to plan! Otherwise, the computed plan
-    // will not be valid!
-
-    // basic construct:
-    // https://www.cs.cmu.edu/afs/cs/project/jair/pub/volume28/coles07a-html/node5.html
-    // But I deleted the "break", because it will lead to really inefficent paths.
-    // And added a list of all opend states, to there are no loops in opening nodes
-    //
-    // If Hill Climbing failed to find a new best heuristic,
-    // we used first breath to find the nex solution. 
-    // Therefor we use open_list, there is only one state, if we found a lower heuristic value.
-    // otherwise every child state will be added to the open_list
-    // and only deleted, when a new best heuristic have been found.
-    // 
-    // To save the right plan, we track indivually the plan for every opend state.
-    // If we find a new best heuristic we append the indivual plan to the real plan and delete every indivual plan.
-
-    std::deque<StateID> open_list; // the breadth-first list also called frontier
-    std::vector<const Operator*> ops; // all available operations for the current state
-    std::deque<std::vector<const Operator*>> plans; // multiple plans, without the plan, that is tracked for every opend state
-    std::vector<const Operator*> current_plan; // the plan for current_state
-    std::vector<StateID> opend;
-    std::vector<StateID> dead_ends;
-    std::vector<std::vector<int>> clausels;
-    std::vector<StateID> clausel;
-    std::deque<StateID> state_plan;
-    bool clause_learning_failed = false;
-
-    state_plan = {};
-    open_list.push_back(current_state.get_id());
-    plans.push_back(plan);
+    int phase = ++num_phases;
+    plateau_nodes[current_state].phase = phase;
 
-    // only stop if there is no more possibilities
-    while (!open_list.empty()) {
-        current_state = g_state_registry->lookup_state(open_list.front()); // initialize new current_state for hill_climbing algorithm
+    deque<StateID> open_list;
+    open_list.push_back(current_state.get_id());
+    vector<const Operator*> ops;
+    vector<PackedStateBin> succ_data(g_state_packer->get_num_bins());
+    bool found_better_state = false;
+    while (!open_list.empty() && !found_better_state) {
+        State state = registry->lookup_state(open_list.front());
         open_list.pop_front();
-        current_plan.clear(); 
-        if (!plans.empty()) { // only if there havent been found a new min heuristic
-            current_plan = plans.front(); // initialize plan for the current_state
-            plans.pop_front();
-        }
         ops.clear();
-        get_applicable_operators(current_state, ops); // get the available operations
-        for (int i = 0; i < ops.size(); i++) { // loop through every possible operation
-            State next_state = g_state_registry->get_successor_state(current_state, *ops[i]); // state after applying the operator
-            if ((!(std::find(opend.begin(), opend.end(), next_state.get_id()) != opend.end()))) {
-                evaluate(current_state, ops[i], next_state); // get statistics (heuristic value of successor)
-                opend.push_back(next_state.get_id());
-                current_plan.push_back(ops[i]); // create plan for next_state
-                if (heuristic->is_dead_end()) {
-                    dead_ends.push_back(next_state.get_id());
-                } 
-                else if (heuristic->get_heuristic() < current_h) {
-                    opend.clear();
-                    opend.insert(opend.end(), clausel.begin(), clausel.end());
-                    opend.insert(opend.end(), dead_ends.begin(), dead_ends.end());
-                    current_g = plan.size() + current_plan.size();
-                    current_h = heuristic->get_heuristic(); // update current_h
-                    open_list.clear();
-                    plans.clear();
-                    open_list.push_front(next_state.get_id()); // best_state will be expanded as next
-                    state_plan.push_back(current_state.get_id());
-                    plans.push_front(current_plan);
-                    clause_learning_failed = false;
-                    clausel.clear();
-                    if (test_goal(next_state)) { // next_state is goal state
-                        for (int j = 0; j < current_plan.size(); j++) {
-                            plan.push_back(current_plan[j]);
-                        }
-                        cout << "Found a goal state!" << endl;
-                        assert(is_plan(plan));
-                        set_plan(plan);
-                        return SOLVED;
-                    }
-                } 
-                else {
-                    open_list.push_back(next_state.get_id()); // no new best heuristic have been found, breath first search will continue 
-                    plans.push_back(current_plan);
-                }
-                current_plan.pop_back(); // reset plan to current_state plan.
+        get_applicable_operators(state, ops, use_helpful_actions);
+        for (const Operator* op : ops) {
+            StateRegistry::compute_successor_data(state, *op, &succ_data[0]);
+            search_progress.inc_generated();
+            if (avoided_states.size() > 0 &&
+                avoided_states.find_state_data(&succ_data[0]) !=
+                StateID::no_state) {
+                continue;
             }
-        }
-        if (open_list.empty()) { // Idea of AI Course 1, clause learning to make this ehc compatible with every domain.
-            //cout << clausels << endl;
-            if (clause_learning_failed) {
-                return FAILED;
+            State succ_state = registry->register_state_data(&succ_data[0]);
+            PlateauNode &succ_node = plateau_nodes[succ_state];
+            if (succ_node.phase == phase) {
+                continue;
             }
-            if (clausels.empty()) {
-                clausels = getCombinations(state_plan.size(), state_plan.size());
-                std::sort(clausels.begin(), clausels.end(), compareVectors);
-                clause_learning_failed = true;
+            succ_node.phase = phase;
+            // States from a failed phase with pruning keep their h-value.
+            if (succ_node.h == -1) {
+                evaluate(state, op, succ_state);
             }
-            for (int i = 0; i < state_plan.size(); i++) {
-                clausel.clear();
-                clausel.push_back(state_plan[clausels.back()[i]]);
+            if (succ_node.h == DEAD_END_H) {
+                search_progress.inc_dead_ends();
+                continue;
             }
-            //cout << "__" << endl;
-            clausels.pop_back();
-            plan.clear();
-            plans.clear();
-            plans.push_back(plan);
-            open_list.clear();
-            open_list.push_back(g_initial_state().get_id());
-            state_plan.clear();
-            opend.clear();
-            opend.insert(opend.end(), clausel.begin(), clausel.end());
-            opend.insert(opend.end(), dead_ends.begin(), dead_ends.end());
-
+            succ_node.parent_id = state.get_id();
+            succ_node.creating_op = op;
+            if (succ_node.h < current_h || test_goal(succ_state)) {
+                max_plateau_size = max(max_plateau_size, registry->size());
+                set_current_state(state, op, succ_state, succ_data);
+                found_better_state = true;
+                break;
+            }
+            open_list.push_back(succ_state.get_id());
         }
+    }
+    max_plateau_size = max(max_plateau_size, registry->size());
+    return found_better_state;
+}
 
+void EnforcedHillClimbingSearch::set_current_state(const State& parent,
+    const Operator* op, const State& state, const vector<PackedStateBin>& data)
+{
+    Plan path;
+    StateID id = state.get_id();
+    while (id != current_state.get_id()) {
+        const PlateauNode &node = plateau_nodes[registry->lookup_state(id)];
+        path.push_back(node.creating_op);
+        id = node.parent_id;
+    }
+    for (auto it = path.rbegin(); it != path.rend(); ++it) {
+        plan.push_back(*it);
+        current_g += get_adjusted_cost(**it);
     }
 
-    return FAILED;
+    // Only keep the new current state, all other states of the phase are
+    // freed with the old registry.
+    StateRegistry *next_registry = new StateRegistry();
+    State next_state = next_registry->register_state_data(&data[0]);
+    PlateauNode &node = plateau_nodes[state];
+    PlateauNode &next_node = plateau_nodes[next_state];
+    next_node.h = node.h;
+    next_node.helpful_ops.swap(node.helpful_ops);
+    heuristic->reach_state(parent, *op, next_state);
+
+    current_h = next_node.h;
+    current_state = next_state;
+    current_state_data = data;
+    delete registry;
+    registry = next_registry;
 }
 
 auto EnforcedHillClimbingSearch::is_plan(const Plan& plan) -> bool
 {
-    auto state = g_initial_state();
+    StateRegistry plan_registry;
+    auto state = plan_registry.get_initial_state();
     for (const auto* op : plan) {
         // verify that all operators in the plan are applicable
         if (!op->is_applicable(state))
             return false;
-        state = g_state_registry->get_successor_state(state, *op);
+        state = plan_registry.get_successor_state(state, *op);
     }
     // verify that the final state is a goal state
     return test_goal(state);
@@ -289,13 +279,26 @@ auto EnforcedHillClimbingSearch::is_plan(const Plan& plan) -> bool
 void EnforcedHillClimbingSearch::statistics() const
 {
     search_progress.print_statistics();
+    cout << "Improvement phases: " << num_phases << endl;
+    cout << "Phases repeated without helpful actions: "
+         << num_fallback_phases << endl;
+    cout << "Restarts: " << num_restarts << endl;
+    cout << "Largest plateau registry: " << max_plateau_size << " state(s)"
+         << endl;
 }
 
 static SearchEngine* _parse(OptionParser& parser)
 {
-    parser.document_synopsis("Hill-climbing", "");
+    parser.document_synopsis(
+        "Enforced hill-climbing",
+        "Breadth-first searches for states with smaller heuristic values, "
+        "each in a registry that is freed when a better state is found.");
     parser.add_option<Heuristic*>("eval", "evaluator for h-value");
-    parser.add_option<bool>("helpful_actions", "", "false");
+    parser.add_option<bool>(
+        "helpful_actions",
+        "only expand helpful actions (all successors if a state has none or "
+        "a phase fails)",
+        "true");
 
     SearchEngine::add_options_to_parser(parser);
     Options opts = parser.parse();
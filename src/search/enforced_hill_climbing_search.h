@@ -3,18 +3,12 @@
 
 #include "globals.h"
 #include "operator.h"
+#include "per_state_information.h"
 #include "search_engine.h"
-#include "search_node_info.h"
 #include "search_progress.h"
-#include "search_space.h"
 #include "state.h"
 
-#include <map>
 #include <vector>
-#include <algorithm>
-#include <numeric>
-
-
 
 // Usage example: the command line option for using enforced hill climbing
 // using heuristic with name h is
@@ -24,46 +18,99 @@
 // For h^{add}
 // ./fast-downward.py [path-to-PDDL-problem-file] --search "ehc(hadd())"
 // And so on.
-// To enable helpful actions you additionally need to pass helpful_actions=true,
-// so for example running enforced hill climbing with h^{FF} and helpful actions:
-// ./fast-downward.py [path-to-PDDL-problem-file] --search "ehc(ff(), helpful_actions=true)"
+// Helpful actions pruning is enabled by default. To disable it you need to
+// pass helpful_actions=false, so for example running enforced hill climbing
+// with h^{FF} without helpful actions:
+// ./fast-downward.py [path-to-PDDL-problem-file] --search "ehc(ff(), helpful_actions=false)"
 // Obviously, [path-to-PDDL-problem-file] has to be replaced by the actual path
 // to the PDDL problem file.
 
-
-// The implementation of enforced hill climbing goes here. In particular
-// consider the various TODO tags distributed across the code in
-// enforced_hill_climbing.cc
+/*
+  Enforced hill-climbing (Hoffmann & Nebel, 2001).
+
+  Each step is an improvement phase: a breadth-first search from the
+  current state for a state with a smaller heuristic value (or a goal
+  state). The phase runs in its own state registry, which only contains the
+  current state when the phase starts. When a better state is found, it is
+  moved to a fresh registry, the path to it is appended to the plan and the
+  old registry, together with all information stored for its states, is
+  freed. Hence memory only grows with the largest plateau, not with the
+  number of states evaluated so far.
+
+  With helpful actions pruning, only the applicable helpful actions of a
+  state are expanded, or all applicable operators if it has none. If a
+  phase with pruning fails, it is repeated without pruning (reusing the
+  heuristic values computed so far). If that fails as well, the search
+  restarts from the initial state and avoids the state in which it got
+  stuck from then on. It only gives up if it gets stuck in the initial state.
+*/
 
 class Options;
 
 class EnforcedHillClimbingSearch : public SearchEngine
 {
+    struct PlateauNode {
+        // Index of the improvement phase in which the state was reached.
+        int phase;
+        int h;
+        StateID parent_id;
+        const Operator *creating_op;
+        // Only stored until the state is expanded.
+        std::vector<const Operator *> helpful_ops;
+
+        PlateauNode()
+            : phase(-1), h(-1), parent_id(StateID::no_state), creating_op(0)
+        {
+        }
+    };
 
-private:
     bool helpful_actions;
 
     Heuristic *heuristic;
 
-    // the following four variables have to be kept up-to-date during the search
+    // Registry of the current improvement phase.
+    StateRegistry *registry;
+    PerStateInformation<PlateauNode> plateau_nodes;
 
-    // the current root state of the BFS exploration
-    State current_state; // is initialized to the initial state
+    // the current root state of the BFS exploration and its packed data
+    State current_state;
+    std::vector<PackedStateBin> current_state_data;
 
     // h-value of current_state
-    int current_h;      // is initialized to the heuristic value of the initial state
+    int current_h;
 
     // g-value of current_state, only required for statistics output
-    int current_g; // is initialized to 0
+    int current_g;
 
     // the sequence of actions that leads from the initial state of the task to current_state
     Plan plan;  // Plan is just an abbreviation for std::vector<const Operator*>
 
+    // States in which earlier attempts got stuck.
+    StateRegistry avoided_states;
+
+    int num_phases;
+    int num_fallback_phases;
+    int num_restarts;
+    size_t max_plateau_size;
+
     SearchStatus hill_climbing();
 
-    // puts all operators that are applicable in state into the ops vector
+    // makes the (newly evaluated) initial state the current state
+    void reset_to_initial_state();
+
+    // breadth-first search for a better state; returns false if there is none
+    bool improve(bool use_helpful_actions);
+
+    // moves the state reached by op from the given parent to a new registry
+    void set_current_state(const State &parent, const Operator *op,
+                           const State &state,
+                           const std::vector<PackedStateBin> &data);
+
+    // puts the operators that are applicable in state into the ops vector,
+    // only the helpful ones if use_helpful_actions is set and there are any
     void get_applicable_operators(const State &state,
-                                  std::vector<const Operator *> &ops);
+                                  std::vector<const Operator *> &ops,
+                                  bool use_helpful_actions);
 
     // this should be called with the parent of the state that you want to evaluate, the op that
     // reached the state from its parent and the state itself
@@ -0,0 +1,650 @@
+#include "external_astar_search.h"
+
+#include "globals.h"
+#include "heuristic.h"
+#include "option_parser.h"
+#include "plugin.h"
+#include "state_registry.h"
+#include "successor_generator.h"
+#include "utilities.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <queue>
+#include <sstream>
+
+using namespace std;
+
+/*
+  Layout of a record. The fingerprints are accessed with memcpy because
+  records are not 8-byte aligned in general.
+*/
+static const size_t FINGERPRINT_OFFSET = 0;
+static const size_t PARENT_OFFSET = 8;
+static const size_t OPERATOR_OFFSET = 16;
+static const size_t REAL_G_OFFSET = 20;
+static const size_t DATA_OFFSET = 24;
+
+static unsigned long long get_fingerprint(const PackedStateBin *data)
+{
+    unsigned long long hash = hash_number_sequence(
+        data, g_state_packer->get_num_bins());
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+static unsigned long long get_record_fingerprint(const char *record,
+                                                 size_t offset)
+{
+    unsigned long long fingerprint;
+    memcpy(&fingerprint, record + offset, sizeof(fingerprint));
+    return fingerprint;
+}
+
+static int get_record_int(const char *record, size_t offset)
+{
+    int value;
+    memcpy(&value, record + offset, sizeof(value));
+    return value;
+}
+
+static const PackedStateBin *get_record_data(const char *record)
+{
+    // Records have a size divisible by sizeof(PackedStateBin).
+    return reinterpret_cast<const PackedStateBin *>(record + DATA_OFFSET);
+}
+
+static inline double get_wall_clock()
+{
+    return chrono::duration<double>(
+        chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+ExternalAStarSearch::ExternalAStarSearch(const Options &opts)
+    : SearchEngine(opts),
+      heuristic(opts.get<Heuristic *>("eval")),
+      directory(opts.get<string>("dir")),
+      keep_files(opts.get<bool>("keep_files")),
+      buffer_records(0),
+      record_size(0),
+      num_files(0),
+      goal_g(-1),
+      timer(opts.get<double>("max_time")),
+      bytes_read(0),
+      bytes_written(0),
+      io_seconds(0)
+{
+    record_size = DATA_OFFSET +
+                  g_state_packer->get_num_bins() * sizeof(PackedStateBin);
+    long long buffer_bytes = opts.get<int>("memory") * 1024LL * 1024LL;
+    buffer_records = max(1LL, buffer_bytes / static_cast<long long>(record_size));
+}
+
+ExternalAStarSearch::~ExternalAStarSearch()
+{
+    remove_files();
+}
+
+void ExternalAStarSearch::remove_files()
+{
+    for (map<pair<int, int>, Bucket>::iterator it = buckets.begin();
+         it != buckets.end(); ++it) {
+        if (it->second.pending_file) {
+            fclose(it->second.pending_file);
+            it->second.pending_file = 0;
+        }
+    }
+    if (!keep_files && !all_paths.empty()) {
+        for (size_t i = 0; i < all_paths.size(); ++i) {
+            remove(all_paths[i].c_str());
+        }
+        remove(directory.c_str());
+        all_paths.clear();
+    }
+}
+
+void ExternalAStarSearch::initialize()
+{
+    cout << "Conducting external-memory A* with a RAM buffer of "
+         << buffer_records << " records of " << record_size
+         << " bytes, (real) bound = " << bound << endl;
+
+    search_progress.add_heuristic(heuristic);
+    vector<PackedStateBin> initial_data(g_state_packer->get_num_bins(), 0);
+    StateRegistry::compute_initial_state_data(&initial_data[0]);
+    heuristic->evaluate(
+        g_state_registry->get_unregistered_state(&initial_data[0]));
+    search_progress.inc_evaluated_states();
+    search_progress.inc_evaluations();
+    if (heuristic->is_dead_end()) {
+        cout << "Initial state is a dead end." << endl;
+        return;
+    }
+    search_progress.get_initial_h_values();
+
+    string dir_template = directory + "/external_astar_XXXXXX";
+    vector<char> dir_name(dir_template.begin(), dir_template.end());
+    dir_name.push_back('\0');
+    if (!mkdtemp(&dir_name[0])) {
+        cerr << "Could not create a directory in " << directory << endl;
+        exit_with(EXIT_CRITICAL_ERROR);
+    }
+    directory = &dir_name[0];
+    cout << "Storing buckets in " << directory << endl;
+
+    vector<char> record(record_size);
+    make_record(&record[0], &initial_data[0], 0, -1, 0);
+    add_record(0, heuristic->get_heuristic(), &record[0]);
+}
+
+string ExternalAStarSearch::get_new_path()
+{
+    ostringstream path;
+    path << directory << "/" << num_files++ << ".bin";
+    all_paths.push_back(path.str());
+    return path.str();
+}
+
+FILE *ExternalAStarSearch::open_file(const string &path, const char *mode)
+{
+    FILE *file = fopen(path.c_str(), mode);
+    if (!file) {
+        cerr << "Could not open " << path << endl;
+        exit_with(EXIT_CRITICAL_ERROR);
+    }
+    return file;
+}
+
+void ExternalAStarSearch::close_file(FILE *file)
+{
+    double start = get_wall_clock();
+    if (fclose(file) != 0) {
+        cerr << "Could not write bucket file (disk full?)" << endl;
+        exit_with(EXIT_CRITICAL_ERROR);
+    }
+    io_seconds += get_wall_clock() - start;
+}
+
+size_t ExternalAStarSearch::read_records(FILE *file, char *buffer,
+                                         size_t num_records)
+{
+    double start = get_wall_clock();
+    size_t num_read = fread(buffer, record_size, num_records, file);
+    io_seconds += get_wall_clock() - start;
+    bytes_read += num_read * record_size;
+    return num_read;
+}
+
+void ExternalAStarSearch::write_records(FILE *file, const char *buffer,
+                                        size_t num_records)
+{
+    double start = get_wall_clock();
+    size_t num_written = fwrite(buffer, record_size, num_records, file);
+    io_seconds += get_wall_clock() - start;
+    if (num_written != num_records) {
+        cerr << "Could not write bucket file (disk full?)" << endl;
+        exit_with(EXIT_CRITICAL_ERROR);
+    }
+    bytes_written += num_written * record_size;
+}
+
+void ExternalAStarSearch::make_record(
+    char *record, const PackedStateBin *data,
+    unsigned long long parent_fingerprint, int op_index, int real_g) const
+{
+    unsigned long long fingerprint = get_fingerprint(data);
+    memcpy(record + FINGERPRINT_OFFSET, &fingerprint, sizeof(fingerprint));
+    memcpy(record + PARENT_OFFSET, &parent_fingerprint,
+           sizeof(parent_fingerprint));
+    memcpy(record + OPERATOR_OFFSET, &op_index, sizeof(op_index));
+    memcpy(record + REAL_G_OFFSET, &real_g, sizeof(real_g));
+    memcpy(record + DATA_OFFSET, data, record_size - DATA_OFFSET);
+}
+
+void ExternalAStarSearch::add_record(int g, int h, const char *record)
+{
+    Bucket &bucket = buckets[make_pair(g, h)];
+    if (!bucket.pending_file) {
+        bucket.g = g;
+        bucket.h = h;
+        bucket.pending_path = get_new_path();
+        bucket.pending_file = open_file(bucket.pending_path, "wb");
+        open_buckets.insert(make_pair(g + h, g));
+    }
+    write_records(bucket.pending_file, record, 1);
+    ++bucket.num_pending;
+}
+
+/*
+  External merge sort of the records in path by their state data that only
+  keeps the first record of each state. Deletes path and returns the path
+  of the sorted file.
+*/
+string ExternalAStarSearch::sort_and_remove_duplicates(const string &path,
+                                                       long long num_records)
+{
+    size_t data_size = record_size - DATA_OFFSET;
+    size_t run_capacity = min<long long>(num_records, buffer_records);
+    vector<char> buffer(max<size_t>(run_capacity, 1) * record_size);
+    vector<const char *> order;
+    vector<string> runs;
+
+    FILE *input = open_file(path, "rb");
+    size_t num_read;
+    while ((num_read = read_records(input, &buffer[0], run_capacity)) > 0) {
+        order.clear();
+        for (size_t i = 0; i < num_read; ++i) {
+            order.push_back(&buffer[i * record_size]);
+        }
+        sort(order.begin(), order.end(),
+             [&](const char *lhs, const char *rhs) {
+                 return memcmp(lhs + DATA_OFFSET, rhs + DATA_OFFSET,
+                               data_size) < 0;
+             });
+        runs.push_back(get_new_path());
+        FILE *run = open_file(runs.back(), "wb");
+        const char *last = 0;
+        for (size_t i = 0; i < order.size(); ++i) {
+            if (!last || memcmp(last + DATA_OFFSET, order[i] + DATA_OFFSET,
+                                data_size) != 0) {
+                write_records(run, order[i], 1);
+                last = order[i];
+            }
+        }
+        close_file(run);
+    }
+    fclose(input);
+    remove(path.c_str());
+
+    if (runs.empty()) {
+        runs.push_back(get_new_path());
+        close_file(open_file(runs.back(), "wb"));
+    }
+    if (runs.size() == 1) {
+        return runs[0];
+    }
+
+    // Merge the runs, giving each of them an equal share of the buffer.
+    size_t num_runs = runs.size();
+    size_t block_records = max<size_t>(1, buffer_records / (num_runs + 1));
+    vector<FILE *> files(num_runs);
+    vector<vector<char>> blocks(num_runs, vector<char>(block_records * record_size));
+    vector<size_t> block_size(num_runs, 0);
+    vector<size_t> block_pos(num_runs, 0);
+    auto current = [&](size_t run) {
+                       return &blocks[run][block_pos[run] * record_size];
+                   };
+    auto greater = [&](size_t lhs, size_t rhs) {
+                       return memcmp(current(lhs) + DATA_OFFSET,
+                                     current(rhs) + DATA_OFFSET,
+                                     data_size) > 0;
+                   };
+    priority_queue<size_t, vector<size_t>, decltype(greater)> heap(greater);
+    for (size_t run = 0; run < num_runs; ++run) {
+        files[run] = open_file(runs[run], "rb");
+        block_size[run] = read_records(files[run], &blocks[run][0],
+                                       block_records);
+        if (block_size[run] > 0) {
+            heap.push(run);
+        }
+    }
+
+    string merged_path = get_new_path();
+    FILE *merged = open_file(merged_path, "wb");
+    vector<char> last(record_size);
+    bool has_last = false;
+    while (!heap.empty()) {
+        size_t run = heap.top();
+        heap.pop();
+        const char *record = current(run);
+        if (!has_last || memcmp(&last[DATA_OFFSET], record + DATA_OFFSET,
+                                data_size) != 0) {
+            write_records(merged, record, 1);
+            memcpy(&last[0], record, record_size);
+            has_last = true;
+        }
+        if (++block_pos[run] == block_size[run]) {
+            block_pos[run] = 0;
+            block_size[run] = read_records(files[run], &blocks[run][0],
+                                           block_records);
+        }
+        if (block_size[run] > 0) {
+            heap.push(run);
+        }
+    }
+    close_file(merged);
+    for (size_t run = 0; run < num_runs; ++run) {
+        fclose(files[run]);
+        remove(runs[run].c_str());
+    }
+    return merged_path;
+}
+
+size_t ExternalAStarSearch::count_records(FILE *file) const
+{
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    rewind(file);
+    return size / record_size;
+}
+
+/*
+  All files must be sorted. Deletes path and returns the path of a file
+  with the records of path whose state occurs in none of the known files.
+  The files are merged in a single pass.
+*/
+string ExternalAStarSearch::remove_known_states(
+    const string &path, const vector<string> &known_paths)
+{
+    size_t data_size = record_size - DATA_OFFSET;
+    size_t num_files = known_paths.size() + 1;
+    // Each file gets an equal share of the buffer, but not more than its
+    // size. File 0 is the input.
+    size_t share = max<size_t>(1, buffer_records / (num_files + 1));
+    vector<FILE *> files(num_files);
+    vector<size_t> block_start(num_files + 1, 0);
+    for (size_t i = 0; i < num_files; ++i) {
+        files[i] = open_file(i == 0 ? path : known_paths[i - 1], "rb");
+        size_t capacity = min(share, max<size_t>(1, count_records(files[i])));
+        block_start[i + 1] = block_start[i] + capacity;
+    }
+    if (merge_buffer.size() < block_start[num_files] * record_size) {
+        merge_buffer.resize(block_start[num_files] * record_size);
+    }
+    vector<size_t> block_size(num_files, 0);
+    vector<size_t> block_pos(num_files, 0);
+    auto current = [&](size_t i) {
+                       return &merge_buffer[(block_start[i] + block_pos[i]) *
+                                            record_size];
+                   };
+    // Returns false at the end of the file.
+    auto advance = [&](size_t i) {
+                       if (++block_pos[i] >= block_size[i]) {
+                           block_pos[i] = 0;
+                           block_size[i] = read_records(
+                               files[i], &merge_buffer[block_start[i] * record_size],
+                               block_start[i + 1] - block_start[i]);
+                       }
+                       return block_size[i] > 0;
+                   };
+    auto greater = [&](size_t lhs, size_t rhs) {
+                       return memcmp(current(lhs) + DATA_OFFSET,
+                                     current(rhs) + DATA_OFFSET,
+                                     data_size) > 0;
+                   };
+    priority_queue<size_t, vector<size_t>, decltype(greater)> known(greater);
+    for (size_t i = 0; i < num_files; ++i) {
+        block_pos[i] = block_size[i];
+        if (advance(i) && i > 0) {
+            known.push(i);
+        }
+    }
+
+    string result_path = get_new_path();
+    FILE *result = open_file(result_path, "wb");
+    for (bool has_record = block_size[0] > 0; has_record;
+         has_record = advance(0)) {
+        const char *record = current(0);
+        int cmp = 1;
+        while (!known.empty()) {
+            size_t i = known.top();
+            cmp = memcmp(current(i) + DATA_OFFSET, record + DATA_OFFSET,
+                         data_size);
+            if (cmp >= 0) {
+                break;
+            }
+            known.pop();
+            if (advance(i)) {
+                known.push(i);
+            }
+        }
+        if (known.empty() || cmp != 0) {
+            write_records(result, record, 1);
+        }
+    }
+    for (size_t i = 0; i < num_files; ++i) {
+        fclose(files[i]);
+    }
+    close_file(result);
+    remove(path.c_str());
+    return result_path;
+}
+
+SearchStatus ExternalAStarSearch::step()
+{
+    // The engine is not destroyed at the end, so clean up here.
+    if (open_buckets.empty()) {
+        cout << "Completely explored state space -- no solution!" << endl;
+        remove_files();
+        return FAILED;
+    }
+    if (timer.is_expired()) {
+        cout << "Time limit reached. Abort search." << endl;
+        remove_files();
+        return TIMEOUT;
+    }
+    pair<int, int> key = *open_buckets.begin();
+    open_buckets.erase(open_buckets.begin());
+    int g = key.second;
+    int h = key.first - g;
+    Bucket &bucket = buckets[make_pair(g, h)];
+
+    close_file(bucket.pending_file);
+    bucket.pending_file = 0;
+    string path = bucket.pending_path;
+    long long num_records = bucket.num_pending;
+    bucket.num_pending = 0;
+    cout << "Expanding bucket g = " << g << ", h = " << h << " with "
+         << num_records << " record(s) [t=" << g_timer << "]" << endl;
+
+    path = sort_and_remove_duplicates(path, num_records);
+    // A state has the same h-value in all buckets it occurs in.
+    vector<string> known_paths;
+    for (map<pair<int, int>, Bucket>::iterator it = buckets.begin();
+         it != buckets.end(); ++it) {
+        const Bucket &other = it->second;
+        if (other.h == h && other.g <= g) {
+            known_paths.insert(known_paths.end(), other.expanded_paths.begin(),
+                               other.expanded_paths.end());
+        }
+    }
+    if (!known_paths.empty()) {
+        path = remove_known_states(path, known_paths);
+    }
+
+    bool found_goal = expand_file(path, g);
+    // References to map elements stay valid when buckets grows.
+    bucket.expanded_paths.push_back(path);
+    if (found_goal) {
+        extract_plan();
+        remove_files();
+        return SOLVED;
+    }
+    return IN_PROGRESS;
+}
+
+bool ExternalAStarSearch::expand_file(const string &path, int g)
+{
+    size_t block_records = min<size_t>(buffer_records, 4096);
+    vector<char> block(block_records * record_size);
+    vector<char> succ_record(record_size);
+    vector<PackedStateBin> succ_data(g_state_packer->get_num_bins());
+
+    FILE *file = open_file(path, "rb");
+    size_t size;
+    while ((size = read_records(file, &block[0], block_records)) > 0) {
+        for (size_t pos = 0; pos < size; ++pos) {
+            const char *record = &block[pos * record_size];
+            State state = g_state_registry->get_unregistered_state(
+                get_record_data(record));
+            search_progress.inc_expanded();
+            if (test_goal(state)) {
+                goal_record.assign(record, record + record_size);
+                goal_g = g;
+                fclose(file);
+                return true;
+            }
+            unsigned long long fingerprint =
+                get_record_fingerprint(record, FINGERPRINT_OFFSET);
+            int real_g = get_record_int(record, REAL_G_OFFSET);
+
+            applicable_ops.clear();
+            g_successor_generator->generate_applicable_ops(state,
+                                                           applicable_ops);
+            search_progress.inc_generated_ops(applicable_ops.size());
+            for (size_t i = 0; i < applicable_ops.size(); ++i) {
+                const Operator *op = applicable_ops[i];
+                int succ_real_g = real_g + op->get_cost();
+                if (succ_real_g >= bound) {
+                    continue;
+                }
+                StateRegistry::compute_successor_data(state, *op,
+                                                      &succ_data[0]);
+                search_progress.inc_generated();
+                heuristic->evaluate(
+                    g_state_registry->get_unregistered_state(&succ_data[0]));
+                search_progress.inc_evaluated_states();
+                search_progress.inc_evaluations();
+                if (heuristic->is_dead_end()) {
+                    search_progress.inc_dead_ends();
+                    continue;
+                }
+                make_record(&succ_record[0], &succ_data[0], fingerprint,
+                            op - &g_operators[0], succ_real_g);
+                add_record(g + get_adjusted_cost(*op),
+                           heuristic->get_heuristic(), &succ_record[0]);
+            }
+        }
+    }
+    fclose(file);
+    return false;
+}
+
+void ExternalAStarSearch::extract_plan()
+{
+    cout << "Solution found, tracing plan through the buckets..." << endl;
+    size_t data_size = record_size - DATA_OFFSET;
+    size_t block_records = min<size_t>(buffer_records, 4096);
+    vector<char> block(block_records * record_size);
+    vector<PackedStateBin> succ_data(g_state_packer->get_num_bins());
+
+    Plan plan;
+    vector<char> record = goal_record;
+    int g = goal_g;
+    while (get_record_int(&record[0], OPERATOR_OFFSET) != -1) {
+        const Operator &op =
+            g_operators[get_record_int(&record[0], OPERATOR_OFFSET)];
+        plan.push_back(&op);
+        unsigned long long parent_fingerprint =
+            get_record_fingerprint(&record[0], PARENT_OFFSET);
+        int parent_g = g - get_adjusted_cost(op);
+
+        bool found_parent = false;
+        for (map<pair<int, int>, Bucket>::iterator it = buckets.begin();
+             it != buckets.end() && !found_parent; ++it) {
+            const Bucket &bucket = it->second;
+            if (bucket.g != parent_g) {
+                continue;
+            }
+            for (size_t i = 0; i < bucket.expanded_paths.size() &&
+                 !found_parent; ++i) {
+                FILE *file = open_file(bucket.expanded_paths[i], "rb");
+                size_t size;
+                while (!found_parent &&
+                       (size = read_records(file, &block[0],
+                                            block_records)) > 0) {
+                    for (size_t pos = 0; pos < size; ++pos) {
+                        const char *candidate = &block[pos * record_size];
+                        if (get_record_fingerprint(candidate,
+                                                   FINGERPRINT_OFFSET)
+                            != parent_fingerprint) {
+                            continue;
+                        }
+                        // Rule out fingerprint collisions.
+                        State parent = g_state_registry->get_unregistered_state(
+                            get_record_data(candidate));
+                        StateRegistry::compute_successor_data(parent, op,
+                                                              &succ_data[0]);
+                        if (memcmp(&succ_data[0], &record[DATA_OFFSET],
+                                   data_size) == 0) {
+                            record.assign(candidate, candidate + record_size);
+                            found_parent = true;
+                            break;
+                        }
+                    }
+                }
+                fclose(file);
+            }
+        }
+        if (!found_parent) {
+            cerr << "external_astar: could not trace the plan." << endl;
+            exit_with(EXIT_CRITICAL_ERROR);
+        }
+        g = parent_g;
+    }
+    reverse(plan.begin(), plan.end());
+    set_plan(plan);
+}
+
+void ExternalAStarSearch::statistics() const
+{
+    search_progress.print_statistics();
+    const double mb = 1024.0 * 1024.0;
+    cout << "Bucket files: " << num_files << endl;
+    cout << "Bytes read: " << bytes_read << " (" << bytes_read / mb
+         << " MB)" << endl;
+    cout << "Bytes written: " << bytes_written << " ("
+         << bytes_written / mb << " MB)" << endl;
+    cout << "I/O time: " << io_seconds << "s" << endl;
+    if (io_seconds > 0) {
+        cout << "I/O throughput: "
+             << (bytes_read + bytes_written) / mb / io_seconds << " MB/s"
+             << endl;
+    }
+}
+
+static SearchEngine *_parse(OptionParser &parser)
+{
+    parser.document_synopsis(
+        "External-memory A*",
+        "A* that stores all states on disk in (g, h) buckets and detects "
+        "duplicates by external sorting and merging. Finds optimal plans "
+        "with consistent heuristics.");
+    parser.document_note(
+        "Heuristics",
+        "States are not registered, so heuristics that store information "
+        "per state or rely on reach_state are not supported.");
+    parser.add_option<Heuristic *>("eval", "heuristic");
+    parser.add_option<int>(
+        "memory", "size of the RAM buffer for sorting in megabytes", "256");
+    parser.add_option<string>(
+        "dir",
+        "directory in which a temporary directory for the buckets is created",
+        ".");
+    parser.add_option<bool>(
+        "keep_files", "do not delete the bucket files at the end", "false");
+    SearchEngine::add_options_to_parser(parser);
+    Options opts = parser.parse();
+
+    if (opts.get<int>("memory") < 1) {
+        parser.error("memory must be positive");
+    }
+    if (parser.dry_run()) {
+        return 0;
+    }
+    if (opts.get<Heuristic *>("eval")->is_path_dependent()) {
+        parser.error("external_astar does not support heuristics that depend on the "
+                     "path to a state");
+    }
+    return new ExternalAStarSearch(opts);
+}
+
+static Plugin<SearchEngine> _plugin("external_astar", _parse);
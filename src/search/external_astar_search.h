@@ -0,0 +1,121 @@
+#ifndef EXTERNAL_ASTAR_SEARCH_H
+#define EXTERNAL_ASTAR_SEARCH_H
+
+#include "countdown_timer.h"
+#include "search_engine.h"
+#include "state.h"
+
+#include <cstdio>
+#include <map>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Usage example: the command line option for using external-memory A* with
+// heuristic h, a RAM buffer of M megabytes and the bucket files in directory
+// D is
+// ./fast-downward.py [path-to-PDDL-problem-file] --search "external_astar(h(), memory=M, dir=D)"
+// So, for the PDB heuristic, 512 MB and /tmp it is
+// ./fast-downward.py [path-to-PDDL-problem-file] --search "external_astar(pdb(), memory=512, dir=/tmp)"
+// Obviously, [path-to-PDDL-problem-file] has to be replaced by the actual path
+// to the PDDL problem file.
+
+/*
+  External-memory A* (Edelkamp, Jabbar & Schroedl, 2004).
+
+  All generated states are stored on disk in buckets, one for each pair of
+  g- and h-value, and buckets are expanded in the order of increasing f and
+  then g. A bucket is a sequence of append-only files of fixed-size records
+  (state fingerprint, fingerprint of the parent, creating operator, real g
+  and packed state data).
+
+  Duplicates are removed in batches (delayed duplicate detection): before
+  a bucket is expanded, its new records are sorted by their state data with
+  an external merge sort (runs of at most the size of the RAM buffer) and
+  merged in one pass with all previously expanded files of buckets with the
+  same h and at most the same g. Since a state always has the same h-value, these are
+  the only buckets in which it can have been expanded before.
+
+  The plan is traced back from the goal through the parent fingerprints by
+  scanning the buckets of the parent's g-value.
+
+  As for A* without reopening, plans are optimal for consistent heuristics.
+  Heuristics that store per-state information are not supported because
+  states are evaluated without being registered.
+*/
+
+class Heuristic;
+class Options;
+
+class ExternalAStarSearch : public SearchEngine
+{
+    struct Bucket {
+        int g;
+        int h;
+        // Records that have been generated but not expanded yet.
+        std::string pending_path;
+        std::FILE *pending_file;
+        long long num_pending;
+        // Sorted, duplicate-free files that have been expanded.
+        std::vector<std::string> expanded_paths;
+
+        Bucket()
+            : g(0), h(0), pending_file(0), num_pending(0)
+        {
+        }
+    };
+
+    Heuristic *heuristic;
+    std::string directory;
+    bool keep_files;
+    size_t buffer_records;
+    size_t record_size;
+
+    // Buckets by (g, h) and the keys (f, g) of buckets with pending records.
+    std::map<std::pair<int, int>, Bucket> buckets;
+    std::set<std::pair<int, int>> open_buckets;
+    int num_files;
+    std::vector<std::string> all_paths;
+
+    std::vector<char> goal_record;
+    int goal_g;
+    std::vector<const Operator *> applicable_ops;
+    // Blocks of the files merged by remove_known_states, reused between calls.
+    std::vector<char> merge_buffer;
+
+    CountdownTimer timer;
+
+    long long bytes_read;
+    long long bytes_written;
+    double io_seconds;
+
+    std::string get_new_path();
+    std::FILE *open_file(const std::string &path, const char *mode);
+    void close_file(std::FILE *file);
+    size_t read_records(std::FILE *file, char *buffer, size_t num_records);
+    void write_records(std::FILE *file, const char *buffer,
+                       size_t num_records);
+
+    void make_record(char *record, const PackedStateBin *data,
+                     unsigned long long parent_fingerprint, int op_index,
+                     int real_g) const;
+    void add_record(int g, int h, const char *record);
+    std::string sort_and_remove_duplicates(const std::string &path,
+                                           long long num_records);
+    size_t count_records(std::FILE *file) const;
+    std::string remove_known_states(const std::string &path,
+                                    const std::vector<std::string> &known_paths);
+    bool expand_file(const std::string &path, int g);
+    void extract_plan();
+    void remove_files();
+protected:
+    virtual void initialize();
+    virtual SearchStatus step();
+public:
+    ExternalAStarSearch(const Options &opts);
+    virtual ~ExternalAStarSearch();
+    virtual void statistics() const;
+};
+
+#endif
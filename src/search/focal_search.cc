@@ -0,0 +1,233 @@
+#include "focal_search.h"
+
+#include "globals.h"
+#include "heuristic.h"
+#include "option_parser.h"
+#include "plugin.h"
+#include "successor_generator.h"
+
+#include <algorithm>
+#include <cassert>
+
+using namespace std;
+
+
+FocalSearch::FocalSearch(const Options &opts)
+    : SearchEngine(opts),
+      heuristic(opts.get<Heuristic *>("eval")),
+      focal_heuristic(opts.get<Heuristic *>("focal_eval")),
+      weight(opts.get<double>("w")),
+      focal_threshold(-1),
+      f_min(-1),
+      focal_values(-1),
+      num_focal_entries(0),
+      max_focal_size(0)
+{
+}
+
+void FocalSearch::initialize()
+{
+    cout << "Conducting focal search with weight " << weight
+         << ", (real) bound = " << bound << endl;
+    search_progress.add_heuristic(heuristic);
+    search_progress.add_heuristic(focal_heuristic);
+
+    const State &initial_state = g_initial_state();
+    heuristic->evaluate(initial_state);
+    focal_heuristic->evaluate(initial_state);
+    search_progress.inc_evaluated_states();
+    search_progress.inc_evaluations(2);
+    if (heuristic->is_dead_end() || focal_heuristic->is_dead_end()) {
+        cout << "Initial state is a dead end." << endl;
+        return;
+    }
+    search_progress.get_initial_h_values();
+    SearchNode node = search_space.get_node(initial_state);
+    node.open_initial(heuristic->get_heuristic());
+    focal_values[initial_state] = focal_heuristic->get_heuristic();
+    insert(node, focal_values[initial_state]);
+}
+
+void FocalSearch::insert(const SearchNode &node, int focal_value)
+{
+    int f = node.get_g() + node.get_h();
+    ++num_open_by_f[f];
+    Entry entry(node.get_state_id(), node.get_g());
+    if (f <= focal_threshold) {
+        focal_buckets[make_pair(focal_value, f)].push_back(entry);
+        ++num_focal_entries;
+        max_focal_size = max(max_focal_size, num_focal_entries);
+    } else {
+        open_buckets[f].push_back(entry);
+    }
+}
+
+void FocalSearch::remove_open_state(int f)
+{
+    map<int, int>::iterator it = num_open_by_f.find(f);
+    assert(it != num_open_by_f.end() && it->second > 0);
+    if (--it->second == 0) {
+        num_open_by_f.erase(it);
+    }
+}
+
+bool FocalSearch::is_stale(const Entry &entry)
+{
+    SearchNode node = search_space.get_node(
+        g_state_registry->lookup_state(entry.state_id));
+    return !node.is_open() || node.get_g() != entry.g;
+}
+
+void FocalSearch::update_focal_threshold()
+{
+    if (num_open_by_f.empty() || num_open_by_f.begin()->first <= f_min) {
+        return;
+    }
+    f_min = num_open_by_f.begin()->first;
+    int new_threshold = static_cast<int>(weight * f_min + 1e-9);
+    if (new_threshold <= focal_threshold) {
+        return;
+    }
+    focal_threshold = new_threshold;
+    cout << "f_min = " << f_min << ", focal threshold = " << focal_threshold
+         << " [expanded " << search_progress.get_expanded()
+         << " state(s), t=" << g_timer << "]" << endl;
+
+    while (!open_buckets.empty() &&
+           open_buckets.begin()->first <= focal_threshold) {
+        int f = open_buckets.begin()->first;
+        Bucket &bucket = open_buckets.begin()->second;
+        for (size_t i = 0; i < bucket.size(); ++i) {
+            const Entry &entry = bucket[i];
+            if (is_stale(entry)) {
+                continue;
+            }
+            int focal_value = focal_values[
+                g_state_registry->lookup_state(entry.state_id)];
+            focal_buckets[make_pair(focal_value, f)].push_back(entry);
+            ++num_focal_entries;
+        }
+        open_buckets.erase(open_buckets.begin());
+    }
+    max_focal_size = max(max_focal_size, num_focal_entries);
+}
+
+SearchStatus FocalSearch::step()
+{
+    update_focal_threshold();
+
+    while (!focal_buckets.empty() &&
+           is_stale(focal_buckets.begin()->second.front())) {
+        Bucket &bucket = focal_buckets.begin()->second;
+        bucket.pop_front();
+        --num_focal_entries;
+        if (bucket.empty()) {
+            focal_buckets.erase(focal_buckets.begin());
+        }
+    }
+    if (focal_buckets.empty()) {
+        // The focal list always contains the states with f = f_min.
+        assert(num_open_by_f.empty());
+        cout << "Completely explored state space -- no solution!" << endl;
+        return FAILED;
+    }
+
+    Bucket &bucket = focal_buckets.begin()->second;
+    StateID id = bucket.front().state_id;
+    bucket.pop_front();
+    --num_focal_entries;
+    if (bucket.empty()) {
+        focal_buckets.erase(focal_buckets.begin());
+    }
+
+    State state = g_state_registry->lookup_state(id);
+    SearchNode node = search_space.get_node(state);
+    remove_open_state(node.get_g() + node.get_h());
+    node.close();
+    if (check_goal_and_set_plan(state)) {
+        return SOLVED;
+    }
+    search_progress.inc_expanded();
+
+    applicable_ops.clear();
+    g_successor_generator->generate_applicable_ops(state, applicable_ops);
+    search_progress.inc_generated_ops(applicable_ops.size());
+    for (size_t i = 0; i < applicable_ops.size(); ++i) {
+        const Operator *op = applicable_ops[i];
+        if (node.get_real_g() + op->get_cost() >= bound) {
+            continue;
+        }
+        State succ_state = g_state_registry->get_successor_state(state, *op);
+        search_progress.inc_generated();
+        SearchNode succ_node = search_space.get_node(succ_state);
+        if (succ_node.is_dead_end()) {
+            continue;
+        }
+        if (succ_node.is_new()) {
+            heuristic->reach_state(state, *op, succ_state);
+            focal_heuristic->reach_state(state, *op, succ_state);
+            heuristic->evaluate(succ_state);
+            search_progress.inc_evaluated_states();
+            search_progress.inc_evaluations();
+            if (heuristic->is_dead_end()) {
+                succ_node.mark_as_dead_end();
+                search_progress.inc_dead_ends();
+                continue;
+            }
+            focal_heuristic->evaluate(succ_state);
+            search_progress.inc_evaluations();
+            if (focal_heuristic->is_dead_end()) {
+                succ_node.mark_as_dead_end();
+                search_progress.inc_dead_ends();
+                continue;
+            }
+            succ_node.open(heuristic->get_heuristic(), node, op);
+            focal_values[succ_state] = focal_heuristic->get_heuristic();
+            insert(succ_node, focal_values[succ_state]);
+            search_progress.check_h_progress(succ_node.get_g());
+        } else if (node.get_g() + get_adjusted_cost(*op) < succ_node.get_g()) {
+            if (succ_node.is_open()) {
+                remove_open_state(succ_node.get_g() + succ_node.get_h());
+            } else {
+                search_progress.inc_reopened();
+            }
+            succ_node.reopen(node, op);
+            insert(succ_node, focal_values[succ_state]);
+        }
+    }
+    return IN_PROGRESS;
+}
+
+void FocalSearch::statistics() const
+{
+    search_progress.print_statistics();
+    search_space.statistics();
+    cout << "Max focal list size: " << max_focal_size << endl;
+    cout << "Final f_min: " << f_min << endl;
+}
+
+static SearchEngine *_parse(OptionParser &parser)
+{
+    parser.document_synopsis(
+        "Focal search (A*_epsilon)",
+        "Expands the states of the focal list, i.e., the open states with "
+        "g + h <= w * f_min, in the order of a second (possibly "
+        "inadmissible) heuristic. With an admissible heuristic eval, the "
+        "plan cost is at most w times the optimal cost.");
+    parser.add_option<Heuristic *>("eval", "admissible heuristic for f = g + h");
+    parser.add_option<Heuristic *>(
+        "focal_eval", "heuristic that orders the focal list");
+    parser.add_option<double>("w", "suboptimality bound", "2");
+    SearchEngine::add_options_to_parser(parser);
+    Options opts = parser.parse();
+
+    if (opts.get<double>("w") < 1) {
+        parser.error("w must be at least 1");
+    }
+    if (parser.dry_run()) {
+        return 0;
+    }
+    return new FocalSearch(opts);
+}
+
+static Plugin<SearchEngine> _plugin("astar_eps", _parse);
@@ -0,0 +1,90 @@
+#ifndef FOCAL_SEARCH_H
+#define FOCAL_SEARCH_H
+
+#include "per_state_information.h"
+#include "search_engine.h"
+#include "state.h"
+
+#include <deque>
+#include <map>
+#include <utility>
+#include <vector>
+
+// Usage example: the command line option for using focal search with the
+// admissible heuristic h, the focal heuristic h2 and suboptimality bound x is
+// ./fast-downward.py [path-to-PDDL-problem-file] --search "astar_eps(h(), h2(), w=x)"
+// So, for h^{max}, goal count and bound 2 it is
+// ./fast-downward.py [path-to-PDDL-problem-file] --search "astar_eps(hmax(), gc(), w=2)"
+// Obviously, [path-to-PDDL-problem-file] has to be replaced by the actual path
+// to the PDDL problem file.
+
+/*
+  Focal search, A*_epsilon (Pearl & Kim, 1982).
+
+  The open list is ordered by f = g + h for the admissible heuristic eval.
+  States are expanded from the focal list, which contains the open states
+  with f <= w * f_min, ordered by the value of focal_eval (ties are broken
+  by smaller f). The plan cost is at most w times the optimal cost.
+
+  Both lists are bucket-based (like TieBreakingOpenList). The focal
+  threshold w * f_min only grows: new states below the threshold go
+  directly into the focal list, all others into the f-bucket of the open
+  list, and when f_min rises, the buckets that fall below the new threshold
+  are moved into the focal list as a whole. So each entry is moved at most
+  once and the focal list is never rebuilt. The threshold may stay above
+  w * f_min if f_min drops (with inconsistent heuristics), which is still
+  safe because every value f_min takes is a lower bound on the optimal
+  cost. Entries of states that have been expanded or reached more cheaply
+  in the meantime are skipped lazily.
+*/
+
+class Heuristic;
+class Options;
+
+class FocalSearch : public SearchEngine
+{
+    struct Entry {
+        StateID state_id;
+        // g-value at insertion; the entry is stale if it has changed.
+        int g;
+
+        Entry(StateID state_id_, int g_)
+            : state_id(state_id_), g(g_)
+        {
+        }
+    };
+    typedef std::deque<Entry> Bucket;
+
+    Heuristic *heuristic;
+    Heuristic *focal_heuristic;
+    double weight;
+
+    // Open states above the focal threshold by f.
+    std::map<int, Bucket> open_buckets;
+    // Focal states by (focal value, f).
+    std::map<std::pair<int, int>, Bucket> focal_buckets;
+    // Number of open states (in either list) for each f-value.
+    std::map<int, int> num_open_by_f;
+    int focal_threshold;
+    int f_min;
+
+    PerStateInformation<int> focal_values;
+    std::vector<const Operator *> applicable_ops;
+
+    size_t num_focal_entries;
+    size_t max_focal_size;
+
+    void insert(const SearchNode &node, int focal_value);
+    void remove_open_state(int f);
+    void update_focal_threshold();
+    bool is_stale(const Entry &entry);
+protected:
+    virtual void initialize();
+    virtual SearchStatus step();
+public:
+    FocalSearch(const Options &opts);
+    virtual ~FocalSearch() = default;
+    virtual void statistics() const;
+};
+
+#endif
@@ -453,5 +453,6 @@ CausalGraph *g_causal_graph;
 
 Timer g_timer;
 string g_plan_filename = "sas_plan";
-RandomNumberGenerator g_rng(2011); // Use an arbitrary default seed.
-StateRegistry *g_state_registry = 0;
+int g_random_seed = 2011; // Use an arbitrary default seed.
+thread_local RandomNumberGenerator g_rng(g_random_seed);
+thread_local StateRegistry *g_state_registry = 0;
@@ -67,11 +67,19 @@ extern CausalGraph *g_causal_graph;
 extern LegacyCausalGraph *g_legacy_causal_graph;
 extern Timer g_timer;
 extern std::string g_plan_filename;
-extern RandomNumberGenerator g_rng;
+// Set with --random-seed while the command line is parsed.
+extern int g_random_seed;
+// Thread-local; threads of a parallel portfolio seed their own generator.
+extern thread_local RandomNumberGenerator g_rng;
 // Only one global object for now. Could later be changed to use one instance
 // for each problem in this case the method State::get_id would also have to be
 // changed.
-extern StateRegistry *g_state_registry;
+// The registry is thread-local, so that engines running in different threads
+// (see parallel_portfolio) each work on their own registry. Apart from the
+// registry, g_rng (also thread-local) and g_axiom_evaluator (which keeps
+// scratch data), the globals are only read after read_everything(), so
+// several threads may use them.
+extern thread_local StateRegistry *g_state_registry;
 
 
 
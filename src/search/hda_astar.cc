@@ -0,0 +1,542 @@
+#include "hda_astar.h"
+
+#include "countdown_timer.h"
+#include "g_evaluator.h"
+#include "globals.h"
+#include "heuristic.h"
+#include "option_parser.h"
+#include "per_state_information.h"
+#include "plugin.h"
+#include "state_registry.h"
+#include "successor_generator.h"
+#include "sum_evaluator.h"
+#include "tiebreaking_open_list.h"
+#include "utilities.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <thread>
+
+using namespace std;
+
+
+struct HDAStar::NodeInfo {
+    int g;
+    int real_g;
+    int h; // -1 if the state has not been evaluated yet
+    bool closed;
+    bool dead_end;
+    int parent_worker;
+    StateID parent_id;
+    const Operator *creating_operator;
+
+    NodeInfo()
+        : g(numeric_limits<int>::max()), real_g(numeric_limits<int>::max()),
+          h(-1), closed(false), dead_end(false), parent_worker(-1),
+          parent_id(StateID::no_state), creating_operator(0)
+    {
+    }
+};
+
+struct HDAStar::MessageBatch {
+    struct Message {
+        int g;
+        int real_g;
+        int parent_worker;
+        StateID parent_id;
+        const Operator *creating_operator;
+
+        Message(int g_, int real_g_, int parent_worker_, StateID parent_id_,
+                const Operator *creating_operator_)
+            : g(g_), real_g(real_g_), parent_worker(parent_worker_),
+              parent_id(parent_id_), creating_operator(creating_operator_)
+        {
+        }
+    };
+
+    // The packed data of messages[i] starts at state_data[i * num_bins].
+    vector<PackedStateBin> state_data;
+    vector<Message> messages;
+    MessageBatch *next;
+
+    MessageBatch()
+        : next(0)
+    {
+    }
+};
+
+struct HDAStar::Worker {
+    const int id;
+    Heuristic *heuristic;
+    StateRegistry registry;
+    PerStateInformation<NodeInfo> node_infos;
+
+    GEvaluator *g_evaluator;
+    SumEvaluator *f_evaluator;
+    OpenList<StateID> *open_list;
+
+    // Lock-free stack of batches that other workers sent to this one.
+    atomic<MessageBatch *> inbox;
+    // Batch under construction for each other worker (0 if there is none).
+    vector<MessageBatch *> outbox;
+
+    vector<PackedStateBin> successor_data;
+    vector<const Operator *> applicable_ops;
+
+    SearchProgress progress;
+    int sent_states;
+    int received_states;
+
+    Worker(int id_, Heuristic *heuristic_, int num_workers)
+        : id(id_), heuristic(heuristic_), inbox(0), outbox(num_workers, 0),
+          successor_data(g_state_packer->get_num_bins()), sent_states(0),
+          received_states(0)
+    {
+        g_evaluator = new GEvaluator();
+        vector<ScalarEvaluator *> sum_evals;
+        sum_evals.push_back(g_evaluator);
+        sum_evals.push_back(heuristic);
+        f_evaluator = new SumEvaluator(sum_evals);
+        vector<ScalarEvaluator *> evals;
+        evals.push_back(f_evaluator);
+        evals.push_back(heuristic);
+        open_list = new TieBreakingOpenList<StateID>(evals, false, false);
+    }
+
+    ~Worker()
+    {
+        for (size_t i = 0; i < outbox.size(); ++i) {
+            delete outbox[i];
+        }
+        MessageBatch *batch = inbox.load();
+        while (batch) {
+            MessageBatch *next = batch->next;
+            delete batch;
+            batch = next;
+        }
+        delete open_list;
+        delete f_evaluator;
+        delete g_evaluator;
+    }
+};
+
+
+HDAStar::HDAStar(const Options &opts)
+    : SearchEngine(opts),
+      heuristic_config(opts.get<ParseTree>("eval")),
+      num_threads(opts.get<int>("threads")),
+      batch_size(opts.get<int>("batch_size")),
+      incumbent_cost(numeric_limits<int>::max()),
+      incumbent_worker(-1),
+      incumbent_state_id(StateID::no_state),
+      outstanding_work(0),
+      abort_search(false)
+{
+}
+
+HDAStar::~HDAStar()
+{
+    for (size_t i = 0; i < workers.size(); ++i) {
+        delete workers[i];
+    }
+}
+
+void HDAStar::initialize()
+{
+    cout << "Conducting hash-distributed A* with " << num_threads
+         << " thread(s), (real) bound = " << bound << endl;
+    if (has_axioms()) {
+        // The global axiom evaluator keeps scratch data in its members.
+        cerr << "hda_astar does not support axioms!" << endl
+             << "Terminating." << endl;
+        exit_with(EXIT_UNSUPPORTED);
+    }
+
+    vector<Heuristic *> heuristics;
+    OptionParser parser(heuristic_config, false);
+    Heuristic *heuristic = parser.start_parsing<Heuristic *>();
+    if (heuristic->is_path_dependent()) {
+        cerr << "hda_astar does not support heuristics that depend on the "
+             << "path to a state" << endl;
+        exit_with(EXIT_UNSUPPORTED);
+    }
+    heuristics = heuristic->create_evaluation_contexts(num_threads);
+    if (heuristics.empty()) {
+        // Fall back to one independently parsed heuristic per thread.
+        heuristics.push_back(heuristic);
+        for (int i = 1; i < num_threads; ++i) {
+            OptionParser parser(heuristic_config, false);
+            heuristic = parser.start_parsing<Heuristic *>();
+            if (find(heuristics.begin(), heuristics.end(), heuristic)
+                != heuristics.end()) {
+                cerr << "hda_astar needs one heuristic object per thread, "
+                     << "so a predefined heuristic must support "
+                     << "evaluation contexts." << endl;
+                exit_with(EXIT_INPUT_ERROR);
+            }
+            heuristics.push_back(heuristic);
+        }
+    }
+    for (int i = 0; i < num_threads; ++i) {
+        /*
+          Evaluating the initial state triggers the (lazy) initialization
+          of heuristics without evaluation contexts. We do this here so that
+          all preprocessing happens before the threads are started.
+        */
+        heuristics[i]->evaluate(g_initial_state());
+        workers.push_back(new Worker(i, heuristics[i], num_threads));
+    }
+
+    search_progress.add_heuristic(heuristics[0]);
+    search_progress.inc_evaluated_states();
+    search_progress.inc_evaluations();
+    if (heuristics[0]->is_dead_end()) {
+        cout << "Initial state is a dead end." << endl;
+        return;
+    }
+    search_progress.get_initial_h_values();
+
+    vector<PackedStateBin> buffer(g_state_packer->get_num_bins());
+    StateRegistry::compute_initial_state_data(&buffer[0]);
+    Worker &owner = *workers[get_owner(&buffer[0])];
+    insert_state(owner, &buffer[0], 0, 0, -1, StateID::no_state, 0);
+}
+
+int HDAStar::get_owner(const PackedStateBin *buffer) const
+{
+    /*
+      The registries hash the same data, so we mix the bits before taking
+      the remainder to avoid correlations between the partitioning and the
+      buckets of the registries.
+    */
+    unsigned long long hash = hash_number_sequence(
+        buffer, g_state_packer->get_num_bins());
+    hash ^= hash >> 31;
+    hash *= 0x7fb5d329728ea185ULL;
+    hash ^= hash >> 27;
+    return hash % num_threads;
+}
+
+SearchStatus HDAStar::step()
+{
+    outstanding_work = num_threads;
+
+    vector<thread> threads;
+    for (int i = 1; i < num_threads; ++i) {
+        threads.push_back(thread(&HDAStar::run_worker, this, ref(*workers[i])));
+    }
+    run_worker(*workers[0]);
+    for (size_t i = 0; i < threads.size(); ++i) {
+        threads[i].join();
+    }
+
+    for (size_t i = 0; i < workers.size(); ++i) {
+        const SearchProgress &progress = workers[i]->progress;
+        search_progress.inc_expanded(progress.get_expanded());
+        search_progress.inc_evaluated_states(progress.get_evaluated_states());
+        search_progress.inc_evaluations(progress.get_evaluations());
+        search_progress.inc_generated(progress.get_generated());
+        search_progress.inc_generated_ops(progress.get_generated_ops());
+        search_progress.inc_reopened(progress.get_reopened());
+        search_progress.inc_dead_ends(progress.get_dead_ends());
+    }
+
+    if (incumbent_worker != -1) {
+        extract_plan();
+    }
+    if (abort_search) {
+        cout << "Time limit reached. Abort search." << endl;
+        return TIMEOUT;
+    }
+    if (incumbent_worker == -1) {
+        cout << "Completely explored state space -- no solution!" << endl;
+        return FAILED;
+    }
+    return SOLVED;
+}
+
+void HDAStar::run_worker(Worker &worker)
+{
+    CountdownTimer timer(max_time);
+    int iterations = 0;
+    int expansions_since_flush = 0;
+    while (!abort_search.load(memory_order_relaxed)) {
+        if ((++iterations & 1023) == 0 && timer.is_expired()) {
+            abort_search = true;
+            break;
+        }
+        receive_messages(worker);
+        if (expand_next_node(worker)) {
+            if (++expansions_since_flush >= batch_size) {
+                // Do not let other workers wait for partially filled batches.
+                for (int dest = 0; dest < num_threads; ++dest) {
+                    if (worker.outbox[dest]) {
+                        send(worker, dest);
+                    }
+                }
+                expansions_since_flush = 0;
+            }
+            continue;
+        }
+
+        for (int dest = 0; dest < num_threads; ++dest) {
+            if (worker.outbox[dest]) {
+                send(worker, dest);
+            }
+        }
+        expansions_since_flush = 0;
+        if (worker.inbox.load(memory_order_acquire)) {
+            continue;
+        }
+
+        // Become idle until another worker sends something or all are done.
+        --outstanding_work;
+        while (true) {
+            if (worker.inbox.load(memory_order_acquire)) {
+                // The batch in the inbox is still counted, so
+                // outstanding_work is positive here.
+                ++outstanding_work;
+                break;
+            }
+            if (outstanding_work == 0 || abort_search) {
+                return;
+            }
+            this_thread::yield();
+        }
+    }
+}
+
+void HDAStar::receive_messages(Worker &worker)
+{
+    int num_bins = g_state_packer->get_num_bins();
+    MessageBatch *batch = worker.inbox.exchange(0, memory_order_acquire);
+    while (batch) {
+        for (size_t i = 0; i < batch->messages.size(); ++i) {
+            const MessageBatch::Message &msg = batch->messages[i];
+            insert_state(worker, &batch->state_data[i * num_bins], msg.g,
+                         msg.real_g, msg.parent_worker, msg.parent_id,
+                         msg.creating_operator);
+        }
+        worker.received_states += batch->messages.size();
+        MessageBatch *next = batch->next;
+        delete batch;
+        // Only now the states of the batch are in our open list.
+        --outstanding_work;
+        batch = next;
+    }
+}
+
+bool HDAStar::expand_next_node(Worker &worker)
+{
+    int num_bins = g_state_packer->get_num_bins();
+    while (!worker.open_list->empty()) {
+        vector<int> key;
+        StateID id = worker.open_list->remove_min(&key);
+        State state = worker.registry.lookup_state(id);
+        NodeInfo &info = worker.node_infos[state];
+        if (info.closed || key[0] != info.g + info.h) {
+            // Outdated entry for a state that was reached on a cheaper path.
+            continue;
+        }
+        if (key[0] >= incumbent_cost.load(memory_order_relaxed)) {
+            // The incumbent only decreases, so this node stays pruned.
+            continue;
+        }
+        info.closed = true;
+        worker.progress.inc_expanded();
+        if (test_goal(state)) {
+            report_goal(worker, id, info.g);
+            return true;
+        }
+
+        int g = info.g;
+        int real_g = info.real_g;
+        worker.applicable_ops.clear();
+        g_successor_generator->generate_applicable_ops(
+            state, worker.applicable_ops);
+        worker.progress.inc_generated_ops(worker.applicable_ops.size());
+        for (size_t i = 0; i < worker.applicable_ops.size(); ++i) {
+            const Operator *op = worker.applicable_ops[i];
+            int succ_real_g = real_g + op->get_cost();
+            if (succ_real_g >= bound) {
+                continue;
+            }
+            int succ_g = g + get_adjusted_cost(*op);
+
+            PackedStateBin *buffer = &worker.successor_data[0];
+            StateRegistry::compute_successor_data(state, *op, buffer);
+            worker.progress.inc_generated();
+            int owner = get_owner(buffer);
+            if (owner == worker.id) {
+                insert_state(worker, buffer, succ_g, succ_real_g, worker.id,
+                             id, op);
+            } else {
+                MessageBatch *&batch = worker.outbox[owner];
+                if (!batch) {
+                    batch = new MessageBatch();
+                    batch->state_data.reserve(batch_size * num_bins);
+                    batch->messages.reserve(batch_size);
+                }
+                batch->state_data.insert(batch->state_data.end(),
+                                         buffer, buffer + num_bins);
+                batch->messages.push_back(MessageBatch::Message(
+                                              succ_g, succ_real_g, worker.id,
+                                              id, op));
+                if (static_cast<int>(batch->messages.size()) >= batch_size) {
+                    send(worker, owner);
+                }
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+void HDAStar::insert_state(Worker &worker, const PackedStateBin *buffer,
+                           int g, int real_g, int parent_worker,
+                           StateID parent_id,
+                           const Operator *creating_operator)
+{
+    State state = worker.registry.register_state_data(buffer);
+    NodeInfo &info = worker.node_infos[state];
+    if (info.dead_end || g >= info.g) {
+        return;
+    }
+    if (info.h == -1) {
+        worker.heuristic->evaluate(state);
+        worker.progress.inc_evaluated_states();
+        worker.progress.inc_evaluations();
+        if (worker.heuristic->is_dead_end()) {
+            info.dead_end = true;
+            worker.progress.inc_dead_ends();
+            return;
+        }
+        info.h = worker.heuristic->get_heuristic();
+    }
+    if (g + info.h >= incumbent_cost.load(memory_order_relaxed)) {
+        return;
+    }
+    if (info.closed) {
+        worker.progress.inc_reopened();
+        info.closed = false;
+    }
+    info.g = g;
+    info.real_g = real_g;
+    info.parent_worker = parent_worker;
+    info.parent_id = parent_id;
+    info.creating_operator = creating_operator;
+
+    worker.heuristic->set_evaluator_value(info.h);
+    worker.open_list->evaluate(g, false);
+    worker.open_list->insert(state.get_id());
+}
+
+void HDAStar::send(Worker &worker, int destination)
+{
+    MessageBatch *batch = worker.outbox[destination];
+    assert(batch);
+    worker.outbox[destination] = 0;
+    worker.sent_states += batch->messages.size();
+    // Count the batch before it becomes visible to the receiver.
+    ++outstanding_work;
+    atomic<MessageBatch *> &inbox = workers[destination]->inbox;
+    batch->next = inbox.load(memory_order_relaxed);
+    while (!inbox.compare_exchange_weak(batch->next, batch,
+                                        memory_order_release,
+                                        memory_order_relaxed)) {
+    }
+}
+
+void HDAStar::report_goal(Worker &worker, StateID id, int g)
+{
+    lock_guard<mutex> lock(incumbent_mutex);
+    if (g < incumbent_cost) {
+        incumbent_cost = g;
+        incumbent_worker = worker.id;
+        incumbent_state_id = id;
+        cout << "Solution with cost " << g << " found by thread "
+             << worker.id << " [t=" << g_timer << "]" << endl;
+    }
+}
+
+void HDAStar::extract_plan()
+{
+    Plan plan;
+    int worker_id = incumbent_worker;
+    StateID id = incumbent_state_id;
+    while (true) {
+        Worker &worker = *workers[worker_id];
+        const NodeInfo &info =
+            worker.node_infos[worker.registry.lookup_state(id)];
+        if (!info.creating_operator) {
+            assert(info.parent_id == StateID::no_state);
+            break;
+        }
+        plan.push_back(info.creating_operator);
+        worker_id = info.parent_worker;
+        id = info.parent_id;
+    }
+    reverse(plan.begin(), plan.end());
+    set_plan(plan);
+}
+
+void HDAStar::statistics() const
+{
+    search_progress.print_statistics();
+    int registered_states = 0;
+    for (size_t i = 0; i < workers.size(); ++i) {
+        const Worker &worker = *workers[i];
+        registered_states += worker.registry.size();
+        cout << "Thread " << i << ": "
+             << worker.progress.get_expanded() << " expanded, "
+             << worker.progress.get_evaluated_states() << " evaluated, "
+             << worker.registry.size() << " registered, "
+             << worker.sent_states << " sent, "
+             << worker.received_states << " received" << endl;
+    }
+    cout << "Number of registered states: " << registered_states << endl;
+}
+
+static SearchEngine *_parse(OptionParser &parser)
+{
+    parser.document_synopsis(
+        "Hash-distributed A* (HDA*)",
+        "Parallel A* in which each thread owns the states whose hash maps "
+        "to it and sends generated successors to their owners in batches. "
+        "Finds optimal plans with admissible heuristics.");
+    parser.document_note(
+        "Heuristics",
+        "Every thread needs its own heuristic object. If the heuristic "
+        "supports evaluation contexts, the threads share its precomputed "
+        "data. Otherwise, the heuristic is parsed once per thread and "
+        "therefore must not be a predefined heuristic. "
+        "Heuristics that rely on reach_state are not supported.");
+    parser.add_option<ParseTree>("eval", "heuristic");
+    parser.add_option<int>("threads", "number of threads", "1");
+    parser.add_option<int>(
+        "batch_size",
+        "maximum number of states that are sent to another thread at once",
+        "64");
+    SearchEngine::add_options_to_parser(parser);
+    Options opts = parser.parse();
+
+    if (parser.help_mode()) {
+        return 0;
+    }
+    if (opts.get<int>("threads") < 1) {
+        parser.error("hda_astar needs at least one thread");
+    }
+    if (opts.get<int>("batch_size") < 1) {
+        parser.error("batch_size must be positive");
+    }
+    if (parser.dry_run()) {
+        // check if the heuristic can be parsed
+        OptionParser test_parser(opts.get<ParseTree>("eval"), true);
+        test_parser.start_parsing<Heuristic *>();
+        return 0;
+    }
+    return new HDAStar(opts);
+}
+
+static Plugin<SearchEngine> _plugin("hda_astar", _parse);
@@ -0,0 +1,89 @@
+#ifndef HDA_ASTAR_H
+#define HDA_ASTAR_H
+
+#include "option_parser_util.h"
+#include "search_engine.h"
+#include "state_id.h"
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+// Usage example: the command line option for using hash-distributed A* with
+// heuristic h and N threads is
+// ./fast-downward.py [path-to-PDDL-problem-file] --search "hda_astar(h(), threads=N)"
+// So, for the LM-cut heuristic and 8 threads it is
+// ./fast-downward.py [path-to-PDDL-problem-file] --search "hda_astar(lmcut(), threads=8)"
+// Obviously, [path-to-PDDL-problem-file] has to be replaced by the actual path
+// to the PDDL problem file.
+
+/*
+  Hash-distributed A* (Kishimoto, Fukunaga & Botea, 2009).
+
+  Every thread ("worker") owns the states whose hash value maps to it. A
+  worker keeps its own state registry, node table and open list and never
+  touches the data of another worker during the search. Successors owned by
+  another worker are collected in per-destination batches and pushed onto
+  the receiver's inbox, a lock-free stack of batches.
+
+  The search ends when no worker has a node with f < incumbent_cost left
+  and no batch is in flight. This is detected with a single counter
+  (outstanding_work) that counts the active workers plus the batches that
+  have been sent but not processed yet. Active workers only increase it
+  while they are counted themselves and idle workers only increase it while
+  a batch sent to them is counted, so it cannot become positive again once
+  it has reached zero. Since every node with f < incumbent_cost has been
+  expanded at that point, the incumbent is optimal for admissible
+  heuristics.
+
+  Every worker uses its own heuristic object. These are evaluation contexts
+  of a single heuristic if it supports them and are created by parsing the
+  heuristic configuration once per thread otherwise. Path-dependent
+  heuristics (that rely on reach_state) are not supported.
+*/
+
+class Heuristic;
+class Options;
+
+class HDAStar : public SearchEngine
+{
+    struct NodeInfo;
+    struct MessageBatch;
+    struct Worker;
+
+    const ParseTree heuristic_config;
+    const int num_threads;
+    const int batch_size;
+
+    std::vector<Worker *> workers;
+
+    // Cost of the cheapest plan found so far; all workers prune nodes with
+    // f >= incumbent_cost.
+    std::atomic<int> incumbent_cost;
+    std::mutex incumbent_mutex;
+    int incumbent_worker;
+    StateID incumbent_state_id;
+
+    std::atomic<int> outstanding_work;
+    std::atomic<bool> abort_search;
+
+    int get_owner(const PackedStateBin *buffer) const;
+    void run_worker(Worker &worker);
+    void receive_messages(Worker &worker);
+    bool expand_next_node(Worker &worker);
+    void insert_state(Worker &worker, const PackedStateBin *buffer, int g,
+                      int real_g, int parent_worker, StateID parent_id,
+                      const Operator *creating_operator);
+    void send(Worker &worker, int destination);
+    void report_goal(Worker &worker, StateID id, int g);
+    void extract_plan();
+protected:
+    virtual void initialize();
+    virtual SearchStatus step();
+public:
+    HDAStar(const Options &opts);
+    virtual ~HDAStar();
+    virtual void statistics() const;
+};
+
+#endif
@@ -3,6 +3,7 @@
 #include "operator.h"
 #include "option_parser.h"
 #include "operator_cost.h"
+#include "per_state_information.h"
 
 #include <cassert>
 #include <cstdlib>
@@ -10,10 +11,76 @@
 
 using namespace std;
 
+// Value of states in the cache that have not been evaluated yet.
+static const int NOT_CACHED = -2;
+
+static thread_local bool cache_estimates_by_default = false;
+
+class Heuristic::ForwardingContext : public Heuristic
+{
+    Heuristic &original;
+protected:
+    virtual int compute_heuristic(const State &state)
+    {
+        return original.compute_heuristic(state);
+    }
+public:
+    explicit ForwardingContext(Heuristic &original_)
+        : Heuristic(original_), original(original_)
+    {
+    }
+    virtual bool dead_ends_are_reliable() const
+    {
+        return original.dead_ends_are_reliable();
+    }
+};
+
 Heuristic::Heuristic(const Options &opts)
-    : cost_type(OperatorCost(opts.get_enum("cost_type")))
+    : initialized(false),
+      heuristic(DEAD_END),
+      helpful_actions_valid(false),
+      evaluator_value(DEAD_END),
+      num_cache_hits(0),
+      cost_type(OperatorCost(opts.get_enum("cost_type")))
+{
+    bool cache = opts.contains("cache_estimates") ?
+                 opts.get<bool>("cache_estimates") : cache_estimates_by_default;
+    if (cache) {
+        const string &config = opts.get_unparsed_config();
+        if (config.empty()) {
+            cached_estimates = make_shared<PerStateInformation<int>>(NOT_CACHED);
+        } else {
+            cached_estimates = get_shared_cache(config);
+        }
+    }
+}
+
+Heuristic::Heuristic(const Heuristic &other)
+    : ScalarEvaluator(other),
+      initialized(other.initialized),
+      heuristic(other.heuristic),
+      helpful_actions_valid(false),
+      evaluator_value(other.evaluator_value),
+      num_cache_hits(0),
+      cost_type(other.cost_type)
+{
+    // Copies are evaluation contexts, and the cache is not thread-safe.
+}
+
+shared_ptr<PerStateInformation<int>> Heuristic::get_shared_cache(
+    const string &config)
 {
-    heuristic = NOT_INITIALIZED;
+    /*
+      Never destroyed, so that no registry is accessed at exit. Each thread
+      has its own caches, because PerStateInformation is not thread-safe.
+    */
+    static thread_local map<string, shared_ptr<PerStateInformation<int>>> *caches =
+        new map<string, shared_ptr<PerStateInformation<int>>>();
+    shared_ptr<PerStateInformation<int>> &cache = (*caches)[config];
+    if (!cache) {
+        cache = make_shared<PerStateInformation<int>>(NOT_CACHED);
+    }
+    return cache;
 }
 
 Heuristic::~Heuristic()
@@ -22,14 +89,84 @@ Heuristic::~Heuristic()
 
 void Heuristic::evaluate(const State &state)
 {
-    if (heuristic == NOT_INITIALIZED) {
+    if (!cached_estimates || state.get_id() == StateID::no_state) {
+        evaluate_uncached(state);
+        return;
+    }
+    int &cached = (*cached_estimates)[state];
+    if (cached == NOT_CACHED) {
+        evaluate_uncached(state);
+        cached = heuristic;
+    } else {
+        ++num_cache_hits;
+        heuristic = cached;
+        helpful_actions_valid = false;
+        evaluator_value = heuristic;
+    }
+}
+
+void Heuristic::evaluate_uncached(const State &state)
+{
+    if (!initialized) {
         initialize();
+        initialized = true;
     }
     heuristic = compute_heuristic(state);
     assert(heuristic == DEAD_END || heuristic >= 0);
+    helpful_actions_valid = true;
     evaluator_value = heuristic;
 }
 
+void Heuristic::evaluate_batch(const vector<State> &states,
+                               vector<int> &values)
+{
+    if (!initialized) {
+        initialize();
+        initialized = true;
+    }
+    values.assign(states.size(), NOT_CACHED);
+    // Positions of the states that are not cached.
+    vector<int> uncached;
+    vector<State> uncached_states;
+    for (size_t i = 0; i < states.size(); ++i) {
+        const State &state = states[i];
+        if (cached_estimates && state.get_id() != StateID::no_state) {
+            int cached = (*cached_estimates)[state];
+            if (cached != NOT_CACHED) {
+                ++num_cache_hits;
+                values[i] = cached;
+                continue;
+            }
+        }
+        uncached.push_back(i);
+        uncached_states.push_back(state);
+    }
+    if (uncached.empty()) {
+        return;
+    }
+    vector<int> uncached_values;
+    compute_heuristic_batch(uncached_states, uncached_values);
+    // The scratch data now belongs to another state.
+    helpful_actions_valid = false;
+    for (size_t i = 0; i < uncached.size(); ++i) {
+        int value = uncached_values[i];
+        assert(value == DEAD_END || value >= 0);
+        values[uncached[i]] = value;
+        if (cached_estimates && uncached_states[i].get_id() != StateID::no_state) {
+            (*cached_estimates)[uncached_states[i]] = value;
+        }
+    }
+}
+
+void Heuristic::compute_heuristic_batch(const vector<State> &states,
+                                        vector<int> &values)
+{
+    values.resize(states.size());
+    for (size_t i = 0; i < states.size(); ++i) {
+        values[i] = compute_heuristic(states[i]);
+    }
+}
+
 bool Heuristic::is_dead_end() const
 {
     return evaluator_value == DEAD_END;
@@ -61,7 +198,14 @@ int Heuristic::get_heuristic()
     return heuristic;
 }
 
-void Heuristic::get_helpful_actions(std::vector<const Operator *> &)
+void Heuristic::get_helpful_actions(std::vector<const Operator *> &result)
+{
+    if (helpful_actions_valid) {
+        add_helpful_actions(result);
+    }
+}
+
+void Heuristic::add_helpful_actions(std::vector<const Operator *> &)
 {
 }
 
@@ -89,17 +233,73 @@ bool Heuristic::dead_end_is_reliable() const
 
 void Heuristic::set_evaluator_value(int val)
 {
+    helpful_actions_valid = false;
     evaluator_value = val;
 }
 
+bool Heuristic::has_same_estimates(const Heuristic &other) const
+{
+    return this == &other ||
+           (cached_estimates && cached_estimates == other.cached_estimates);
+}
+
+Heuristic *Heuristic::clone() const
+{
+    if (compute_heuristic_is_thread_safe()) {
+        // The context never modifies the original heuristic.
+        return new ForwardingContext(const_cast<Heuristic &>(*this));
+    }
+    return 0;
+}
+
+Heuristic *Heuristic::create_evaluation_context()
+{
+    if (!initialized) {
+        initialize();
+        initialized = true;
+    }
+    return clone();
+}
+
+vector<Heuristic *> Heuristic::create_evaluation_contexts(int num_contexts)
+{
+    vector<Heuristic *> contexts;
+    for (int i = 0; i < num_contexts; ++i) {
+        Heuristic *context = create_evaluation_context();
+        if (!context) {
+            assert(contexts.empty());
+            break;
+        }
+        contexts.push_back(context);
+    }
+    return contexts;
+}
+
 int Heuristic::get_adjusted_cost(const Operator &op) const
 {
     return get_adjusted_action_cost(op, cost_type);
 }
 
+bool Heuristic::set_cache_estimates_by_default(bool cache)
+{
+    bool previous = cache_estimates_by_default;
+    cache_estimates_by_default = cache;
+    return previous;
+}
+
 void Heuristic::add_options_to_parser(OptionParser &parser)
 {
     ::add_cost_type_option_to_parser(parser);
+    parser.add_option<bool>(
+        "cache_estimates",
+        "cache the values of registered states and share them with all "
+        "heuristics with the same configuration. If not set, only the "
+        "heuristics of the phases of an iterated search cache their values, "
+        "since only they evaluate states again. Helpful actions are not "
+        "cached. Do not enable for heuristics whose values depend on the "
+        "path to a state",
+        "",
+        OptionFlags(false));
 }
 
 //this solution to get default values seems not optimal:
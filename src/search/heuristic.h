@@ -5,6 +5,7 @@
 #include "operator_cost.h"
 
 #include <map>
+#include <memory>
 #include <set>
 #include <string>
 #include <vector>
@@ -13,35 +14,113 @@ class Operator;
 class State;
 class OptionParser;
 class Options;
+template<class Entry>
+class PerStateInformation;
 
 class Heuristic : public ScalarEvaluator
 {
-    enum {NOT_INITIALIZED = -2};
+    class ForwardingContext;
+
+    bool initialized;
     int heuristic;
+    // False if the value was taken from the cache or set from outside.
+    bool helpful_actions_valid;
     int evaluator_value; // usually equal to heuristic but can be different
     // if set with set_evaluator_value which is done if we use precalculated
     // estimates, eg. when re-opening a search node
 
+    /*
+      Heuristic values of registered states. The cache is shared by all
+      heuristics with the same configuration string, so it survives the
+      phases of an iterated search even if each phase parses its own
+      heuristic. Evaluation contexts do not use the cache.
+    */
+    std::shared_ptr<PerStateInformation<int>> cached_estimates;
+    int num_cache_hits;
+
+    static std::shared_ptr<PerStateInformation<int>> get_shared_cache(
+        const std::string &config);
+
 protected:
     OperatorCost cost_type;
     enum {DEAD_END = -1};
     virtual void initialize() {}
     virtual int compute_heuristic(const State &state) = 0;
+    /*
+      Sets values[i] to the value of states[i] (DEAD_END for dead ends).
+      The default implementation calls compute_heuristic() for each state.
+    */
+    virtual void compute_heuristic_batch(const std::vector<State> &states,
+                                         std::vector<int> &values);
     int get_adjusted_cost(const Operator &op) const;
+    /*
+      Adds the helpful actions of the state of the last call of
+      compute_heuristic() to result.
+    */
+    virtual void add_helpful_actions(std::vector<const Operator *> &result);
+
+    /*
+      Heuristics that can be evaluated concurrently override clone() to
+      return a copy that shares the data precomputed in initialize() and
+      has its own scratch data for compute_heuristic(). The data must not
+      be modified after initialize() and compute_heuristic() must not
+      touch global mutable state. clone() is only called on initialized
+      heuristics. Heuristics that rely on reach_state cannot be cloned.
+    */
+    virtual Heuristic *clone() const;
+    /*
+      Heuristics whose compute_heuristic() only reads data that it does not
+      modify after initialize() can return true here instead of overriding
+      clone(). Their contexts then forward compute_heuristic() to them.
+    */
+    virtual bool compute_heuristic_is_thread_safe() const
+    {
+        return false;
+    }
 public:
     Heuristic(const Options &options);
+    Heuristic(const Heuristic &other);
     virtual ~Heuristic();
 
     void evaluate(const State &state);
+    // Always computes the value, e.g. because helpful actions are needed.
+    void evaluate_uncached(const State &state);
+    /*
+      Sets values[i] to the value of states[i], or to -1 for dead ends,
+      using and filling the cache. Unlike evaluate(), this does not change
+      the current value of the heuristic, and reach_state is not taken into
+      account.
+    */
+    void evaluate_batch(const std::vector<State> &states,
+                        std::vector<int> &values);
+    // True if evaluate_batch() is faster than evaluating states one by one.
+    virtual bool supports_batch_evaluation() const
+    {
+        return false;
+    }
     bool is_dead_end() const;
     int get_heuristic();
-    virtual void get_helpful_actions(std::vector<const Operator *> &result);
+    /*
+      Adds the helpful actions of the last evaluated state to result. Adds
+      none if its value was taken from the cache, because the helpful
+      actions are not cached.
+    */
+    void get_helpful_actions(std::vector<const Operator *> &result);
     virtual bool dead_ends_are_reliable() const
     {
         return true;
     }
     virtual void reach_state(const State &parent_state, const Operator &op,
                              const State &state);
+    /*
+      True if the values depend on the paths passed to reach_state, so
+      engines that do not call it (or only evaluate unregistered states)
+      cannot use the heuristic.
+    */
+    virtual bool is_path_dependent() const
+    {
+        return false;
+    }
 
     // for abstract parent ScalarEvaluator
     int get_value() const;
@@ -56,6 +135,30 @@ public:
     {
         return cost_type;
     }
+    // True if both heuristics are known to assign the same values to states.
+    bool has_same_estimates(const Heuristic &other) const;
+    int get_num_cache_hits() const
+    {
+        return num_cache_hits;
+    }
+
+    /*
+      Evaluation contexts are heuristic objects that compute the same
+      values as this heuristic and can be evaluated concurrently with it and
+      with each other, as long as each of them is used by one thread at a
+      time. Creating a context initializes this heuristic if necessary.
+      Returns 0 if the heuristic does not support evaluation contexts.
+    */
+    Heuristic *create_evaluation_context();
+    // Returns num_contexts contexts or an empty vector if not supported.
+    std::vector<Heuristic *> create_evaluation_contexts(int num_contexts);
+
+    /*
+      Sets whether heuristics that do not set cache_estimates cache their
+      values and returns the previous setting. Iterated search enables it
+      while it parses its phases. Each thread has its own setting.
+    */
+    static bool set_cache_estimates_by_default(bool cache);
 
     static void add_options_to_parser(OptionParser &parser);
     static Options default_options();
@@ -0,0 +1,119 @@
+#include "bit_parallel_exploration.h"
+
+#include "../globals.h"
+#include "../state.h"
+
+#include <algorithm>
+#include <cassert>
+
+using namespace std;
+
+
+BitParallelExploration::BitParallelExploration()
+    : relaxed_task(0) {
+}
+
+BitParallelExploration::BitParallelExploration(
+    const RelaxedTask &relaxed_task_)
+    : relaxed_task(&relaxed_task_),
+      reached(relaxed_task->get_num_facts(), 0),
+      fired(relaxed_task->get_num_operators(), 0),
+      pending(relaxed_task->get_num_facts(), 0),
+      operator_marked(relaxed_task->get_num_operators(), false) {
+}
+
+void BitParallelExploration::compute(const vector<State> &states,
+                                     vector<int> &layers) {
+    assert(relaxed_task);
+    int num_states = states.size();
+    layers.assign(num_states, -1);
+    for (int begin = 0; begin < num_states; begin += BATCH_SIZE) {
+        compute_batch(states, begin, min(BATCH_SIZE, num_states - begin),
+                      layers);
+    }
+}
+
+void BitParallelExploration::compute_batch(const vector<State> &states,
+                                           int begin, int num_states,
+                                           vector<int> &layers) {
+    const Word all_states = num_states == BATCH_SIZE ?
+                            ~Word(0) : (Word(1) << num_states) - 1;
+    fill(reached.begin(), reached.end(), 0);
+    fill(fired.begin(), fired.end(), 0);
+    changed_facts.clear();
+    for (int i = 0; i < num_states; ++i) {
+        const State &state = states[begin + i];
+        for (size_t var = 0; var < g_variable_domain.size(); ++var) {
+            int fact = relaxed_task->get_fact_id(var, state[var]);
+            if (!reached[fact])
+                changed_facts.push_back(fact);
+            reached[fact] |= Word(1) << i;
+        }
+    }
+    // Operators without preconditions fire in the first layer only.
+    for (int op : relaxed_task->get_operators_without_preconditions()) {
+        operator_marked[op] = true;
+        candidate_operators.push_back(op);
+    }
+
+    Word solved = 0;
+    for (int layer = 0;; ++layer) {
+        Word goal_reached = all_states;
+        for (int goal : relaxed_task->get_goal_facts())
+            goal_reached &= reached[goal];
+        Word newly_solved = goal_reached & ~solved;
+        for (int i = 0; newly_solved; ++i, newly_solved >>= 1) {
+            if (newly_solved & 1)
+                layers[begin + i] = layer;
+        }
+        solved |= goal_reached;
+        if (solved == all_states)
+            break;
+
+        for (int fact : changed_facts) {
+            for (int op : relaxed_task->get_precondition_of(fact)) {
+                if (!operator_marked[op]) {
+                    operator_marked[op] = true;
+                    candidate_operators.push_back(op);
+                }
+            }
+        }
+        for (int op : candidate_operators) {
+            operator_marked[op] = false;
+            // States of the batch in which the operator fires first now.
+            Word applicable = all_states & ~fired[op];
+            for (int pre : relaxed_task->get_preconditions(op)) {
+                applicable &= reached[pre];
+                if (!applicable)
+                    break;
+            }
+            if (!applicable)
+                continue;
+            fired[op] |= applicable;
+            for (int eff : relaxed_task->get_effects(op)) {
+                if (!pending[eff])
+                    pending_facts.push_back(eff);
+                pending[eff] |= applicable;
+            }
+        }
+        candidate_operators.clear();
+
+        // Effects become reached in the next layer.
+        changed_facts.clear();
+        for (int fact : pending_facts) {
+            Word new_states = pending[fact] & ~reached[fact];
+            pending[fact] = 0;
+            if (new_states) {
+                reached[fact] |= new_states;
+                changed_facts.push_back(fact);
+            }
+        }
+        pending_facts.clear();
+        if (changed_facts.empty())
+            break;
+    }
+    // Candidates of the first layer if all goals were reached at once.
+    for (int op : candidate_operators)
+        operator_marked[op] = false;
+    candidate_operators.clear();
+}
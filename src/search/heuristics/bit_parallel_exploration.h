@@ -0,0 +1,56 @@
+#ifndef HEURISTICS_BIT_PARALLEL_EXPLORATION_H
+#define HEURISTICS_BIT_PARALLEL_EXPLORATION_H
+
+#include "relaxed_task.h"
+
+#include <cstdint>
+#include <vector>
+
+class State;
+
+/*
+  Layered relaxed reachability for up to 64 states at once.
+
+  Bit i of the word of a fact says whether the fact has been reached in
+  the i-th state of the batch, so a relaxed operator is applicable in the
+  states given by the AND of the words of its preconditions, and one pass
+  over the operators advances all states of the batch by one layer. The
+  passes are event-driven: a layer only looks at the operators with a
+  precondition that was reached in the previous layer, and only the bits
+  of the states in which an operator has not fired yet are propagated to
+  its effects.
+
+  The number of layers until all goal facts are reached is h^max under
+  unit costs (uniform costs after multiplying); states in which the
+  fixpoint does not contain the goal are dead ends. Copying an exploration
+  copies the scratch data and shares the relaxed task.
+*/
+class BitParallelExploration {
+public:
+    typedef uint64_t Word;
+    static const int BATCH_SIZE = 64;
+private:
+    const RelaxedTask *relaxed_task;
+    // Scratch data, indexed by fact or relaxed operator.
+    std::vector<Word> reached;
+    std::vector<Word> fired;
+    std::vector<Word> pending;
+    std::vector<bool> operator_marked;
+    std::vector<int> changed_facts;
+    std::vector<int> pending_facts;
+    std::vector<int> candidate_operators;
+
+    void compute_batch(const std::vector<State> &states, int begin,
+                       int num_states, std::vector<int> &layers);
+public:
+    BitParallelExploration();
+    explicit BitParallelExploration(const RelaxedTask &relaxed_task);
+
+    /*
+      Sets layers[i] to the number of layers needed to reach the goal
+      from states[i], or -1 if the goal is not reachable.
+    */
+    void compute(const std::vector<State> &states, std::vector<int> &layers);
+};
+
+#endif
@@ -31,6 +31,11 @@ int BlindHeuristic::compute_heuristic(const State &state)
     }
 }
 
+Heuristic *BlindHeuristic::clone() const
+{
+    return new BlindHeuristic(*this);
+}
+
 static Heuristic *_parse(OptionParser &parser)
 {
     parser.document_synopsis("Blind heuristic",
@@ -14,6 +14,7 @@ class BlindHeuristic : public Heuristic
 protected:
     virtual void initialize();
     virtual int compute_heuristic(const State &state);
+    virtual Heuristic *clone() const;
 public:
     BlindHeuristic(const Options &options);
     ~BlindHeuristic() = default;
@@ -6,169 +6,214 @@
 #include "../plugin.h"
 #include "../state.h"
 
-
 using namespace std;
 
 CriticalPathHeuristic::CriticalPathHeuristic(const Options &opts)
-    : Heuristic(opts) {
+    : Heuristic(opts),
+      relaxed_task(0),
+      num_facts(0),
+      current_stamp(0) {
 }
 
 void CriticalPathHeuristic::initialize() {
     cout << "Initializing h two heuristic..." << endl;
-}
+    verify_no_conditional_effects();
+    relaxed_task = &get_relaxed_task();
+    num_facts = relaxed_task->get_num_facts();
+    int num_operators = relaxed_task->get_num_operators();
+    blocked_var_starts.push_back(0);
+    partner_var_starts.push_back(0);
+    vector<int> vars;
+    for (int op = 0; op < num_operators; ++op) {
+        const Operator &op_ = g_operators[relaxed_task->get_operator_no(op)];
+        operator_costs.push_back(get_adjusted_cost(op_));
+        int num_preconditions = relaxed_task->get_num_preconditions(op);
+        num_precondition_pairs.push_back(
+            num_preconditions * (num_preconditions + 1) / 2);
 
-typedef std::pair<int,int> varVal;
-typedef std::pair<varVal,varVal> varVals;
-typedef std::map<varVals,int> facts_map;
-typedef std::map<varVals,int>::iterator facts_map_it;
-
-vector<int> combination;
-
-/* Function inspired in https://stackoverflow.com/questions/12991758/creating-all-possible-k-combinations-of-n-items-in-c*/
-void create_combination(int offset, int k, facts_map &iterative_costs, const State &state) {
-    if (k == 0) {
-        for(int val = 0; val < g_variable_domain[combination[0]]; val++) {
-            for(int val2 = 0; val2 < g_variable_domain[combination[1]]; val2++) {
-                varVals comb = make_pair(make_pair(combination[0],val), make_pair(combination[1],val2));
-                if (state[combination[0]] == val && state[combination[1]] == val2) {
-                    iterative_costs.insert({comb, 0});
-                } else {
-                    iterative_costs.insert({comb, -1});
-                }
-            }
+        vars.clear();
+        for (int fact : relaxed_task->get_preconditions(op))
+            vars.push_back(relaxed_task->get_fact_var(fact));
+        for (int fact : relaxed_task->get_effects(op))
+            vars.push_back(relaxed_task->get_fact_var(fact));
+        sort(vars.begin(), vars.end());
+        vars.erase(unique(vars.begin(), vars.end()), vars.end());
+        blocked_vars.insert(blocked_vars.end(), vars.begin(), vars.end());
+        blocked_var_starts.push_back(blocked_vars.size());
+        for (size_t var = 0; var < g_variable_domain.size(); ++var) {
+            if (!binary_search(vars.begin(), vars.end(), var))
+                partner_vars.push_back(var);
         }
-        return;
+        partner_var_starts.push_back(partner_vars.size());
     }
-    for (int var = offset; var <= g_variable_domain.size() - k; ++var) {
-        combination.push_back(var);
-        create_combination(var+1, k-1, iterative_costs, state);
-        combination.pop_back();
+    const vector<int> &goal_facts = relaxed_task->get_goal_facts();
+    for (size_t i = 0; i < goal_facts.size(); ++i) {
+        for (size_t j = i; j < goal_facts.size(); ++j)
+            goal_pairs.push_back(get_pair_id(goal_facts[i], goal_facts[j]));
     }
+
+    int num_pairs = num_facts * (num_facts + 1) / 2;
+    pair_costs.resize(num_pairs);
+    pair_stamps.resize(num_pairs, 0);
+    unpopped_precondition_pairs.resize(num_operators);
+    cout << "h^2 pairs: " << num_pairs << endl;
 }
 
+Heuristic *CriticalPathHeuristic::clone() const {
+    // Shares the relaxed task; the other data is copied.
+    return new CriticalPathHeuristic(*this);
+}
 
-int CriticalPathHeuristic::compute_heuristic(const State &state) {
-    /* Init vector with all the variable values with infinite */
-    facts_map iterative_costs;
-    create_combination(0, 2, iterative_costs, state);
-    /* Add size 1 facts as pair of same facts */
-    for(size_t var = 0; var < g_variable_domain.size(); var++) {
-        for(size_t val = 0; val < g_variable_domain[var]; val++) {
-            varVals comb = make_pair(make_pair(var,val), make_pair(var,val));
-            if (state[var] == val) {
-                iterative_costs.insert({comb, 0});
-            } else {
-                iterative_costs.insert({comb, -1});
-            }
+bool CriticalPathHeuristic::is_blocked(int op, int var) const {
+    return binary_search(blocked_vars.begin() + blocked_var_starts[op],
+                         blocked_vars.begin() + blocked_var_starts[op + 1],
+                         var);
+}
+
+bool CriticalPathHeuristic::has_precondition(int op, int fact) const {
+    RelaxedTask::IdRange pre = relaxed_task->get_preconditions(op);
+    return binary_search(pre.begin(), pre.end(), fact);
+}
+
+void CriticalPathHeuristic::update_pair(int fact1, int fact2, int cost) {
+    int id = get_pair_id(fact1, fact2);
+    unsigned int stamp = pair_stamps[id];
+    if (stamp < current_stamp ||
+        (stamp == current_stamp && cost < pair_costs[id])) {
+        pair_stamps[id] = current_stamp;
+        pair_costs[id] = cost;
+        queue.push(cost, make_pair(fact1, fact2));
+    }
+}
+
+/*
+  Called when the last precondition pair of op is popped with the given
+  cost, which is then the cost of the preconditions.
+*/
+void CriticalPathHeuristic::apply_operator(int op, int cost) {
+    int op_cost = operator_costs[op] + cost;
+    RelaxedTask::IdRange effects = relaxed_task->get_effects(op);
+    for (const int *eff1 = effects.begin(); eff1 != effects.end(); ++eff1) {
+        for (const int *eff2 = eff1; eff2 != effects.end(); ++eff2)
+            update_pair(*eff1, *eff2, op_cost);
+    }
+    // Preconditions that are not deleted are partners as well.
+    for (int pre : relaxed_task->get_preconditions(op)) {
+        int var = relaxed_task->get_fact_var(pre);
+        bool deleted = false;
+        for (int eff : effects) {
+            if (relaxed_task->get_fact_var(eff) == var)
+                deleted = true;
         }
-        
+        if (!deleted)
+            apply_operator_with_partner(op, pre, cost);
     }
-    /* Begin iterations */
-    bool state_changed = true;
-    while (state_changed) {
-        state_changed = false;
-        for (size_t i = 0; i < g_operators.size(); i++) {
-            const vector<Condition> &preconditions = g_operators[i].get_preconditions();
-            bool applicable = true;
-            int previous_cost = 0;
-            /* Check for applicability of the action. All pair of preconditions must not different from DEAD_END */
-            for (size_t p = 0; p < preconditions.size(); p++) {
-                if (!applicable) {
-                    break;
-                }
-                for (size_t p2 = 0; p2 < preconditions.size(); p2++) {
-                    varVal pre1 = make_pair(preconditions[p].var,preconditions[p].val);
-                    varVal pre2 = make_pair(preconditions[p2].var,preconditions[p2].val);
-                    varVals key = iterative_costs.find(make_pair(pre1, pre2)) != iterative_costs.end() ? make_pair(pre1, pre2) : make_pair(pre2, pre1);
-                    int cost = iterative_costs[key];
-                    if (cost == DEAD_END) {
-                        // if any is DEAD_END, then the action is not applicable
-                        applicable = false;
+    // Partners whose pairs with the preconditions were popped before.
+    RelaxedTask::IdRange preconditions = relaxed_task->get_preconditions(op);
+    for (int i = partner_var_starts[op]; i < partner_var_starts[op + 1]; ++i) {
+        int var = partner_vars[i];
+        for (int value = 0; value < g_variable_domain[var]; ++value) {
+            int partner = relaxed_task->get_fact_id(var, value);
+            bool ready = true;
+            if (preconditions.empty()) {
+                ready = is_closed(get_pair_id(partner, partner));
+            } else {
+                for (int pre : preconditions) {
+                    if (!is_closed(get_pair_id(pre, partner))) {
+                        ready = false;
                         break;
-                    } else if (cost > previous_cost) {
-                        previous_cost = cost;
-                    }
-                } 
-            }
-            if (applicable) {
-                const vector<Effect> &effects = g_operators[i].get_effects();
-                const int &action_cost = g_operators[i].get_cost();
-                int possible_action_cost = action_cost + previous_cost;
-                /* Create pairs of effects + effects */
-                for (size_t e = 0; e < effects.size(); e++) {
-                    for (size_t e2 = 0; e2 < effects.size(); e2++) {
-                        varVal eff1 = make_pair(effects[e].var,effects[e].val);
-                        varVal eff2 = make_pair(effects[e2].var,effects[e2].val);
-                        varVals key = iterative_costs.find(make_pair(eff1, eff2)) != iterative_costs.end() ? make_pair(eff1, eff2) : make_pair(eff2, eff1);
-                        int cost = iterative_costs[key];
-                        if (cost == DEAD_END || possible_action_cost < cost){
-                            state_changed = true;
-                            iterative_costs[key] = possible_action_cost;
-                        }
                     }
                 }
-                for(facts_map_it it = iterative_costs.begin(); it != iterative_costs.end(); ++it) {
-                    varVal fact1 = it->first.first;
-                    varVal fact2 = it->first.second;
-                    int cost = it->second;
-                    /* If the pair of facts is DEAD_END, do not use it for creating new facts */
-                    if (cost == DEAD_END) { goto exit; }
-                    if (previous_cost < cost) {
-                        possible_action_cost = action_cost + cost;
-                    }
-                    /* If any effect of the action is inconsistent with this pair of facts then break loop */
-                    for (size_t e = 0; e < effects.size(); e++) {
-                        if ((effects[e].var == fact1.first && effects[e].val != fact1.second) ||
-                            (effects[e].var == fact2.first && effects[e].val != fact2.second)) { 
-                                goto exit; 
-                        }
-                    }
-                    /* Create pairs with pairs of facts and effects of the action */
-                    for (size_t e = 0; e < effects.size(); e++) {
-                        varVal eff = make_pair(effects[e].var,effects[e].val);
-                        /* Effect + fact 1 */
-                        varVals key = iterative_costs.find(make_pair(fact1, eff)) != iterative_costs.end() ? make_pair(fact1, eff) : make_pair(eff, fact1);
-                        int cost = iterative_costs[key];
-                        if (cost == DEAD_END || possible_action_cost < cost) {
-                            state_changed = true;
-                            iterative_costs[key] = possible_action_cost;
-                        }
-                    }
-                    if (fact1 == fact2) { goto exit; }
-                    /* Create pairs with pairs of facts and effects of the action */
-                    for (size_t e = 0; e < effects.size(); e++) {
-                        varVal eff = make_pair(effects[e].var,effects[e].val);
-                         /* Effect + fact 2 */
-                        varVals key2 = iterative_costs.find(make_pair(fact2, eff)) != iterative_costs.end() ? make_pair(fact2, eff) : make_pair(eff, fact2);
-                        int cost = iterative_costs[key2];
-                        if (cost == DEAD_END || possible_action_cost < cost) {
-                            state_changed = true;
-                            iterative_costs[key2] = possible_action_cost;
-                        }
-                    }
-                    /* Exit clause */
-                    exit: ;
-                }
             }
+            if (ready)
+                apply_operator_with_partner(op, partner, cost);
         }
     }
-    int max_cost = DEAD_END;
-    for (size_t g = 0; g < g_goal.size(); g++) {
-        for (size_t g2 = 0; g2 < g_goal.size(); g2++) {
-            varVal goal1 = make_pair(g_goal[g].first,g_goal[g].second);
-            varVal goal2 = make_pair(g_goal[g2].first,g_goal[g2].second);
-            varVals key = iterative_costs.find(make_pair(goal1, goal2)) != iterative_costs.end() ? make_pair(goal1, goal2) : make_pair(goal2, goal1);
-            int cost = iterative_costs[key];
-            if (cost == DEAD_END){
-                return DEAD_END;
+}
+
+void CriticalPathHeuristic::apply_operator_with_partner(int op, int partner,
+                                                        int cost) {
+    int op_cost = operator_costs[op] + cost;
+    for (int eff : relaxed_task->get_effects(op))
+        update_pair(eff, partner, op_cost);
+}
+
+/*
+  Called when a pair of the partner and a precondition of op is popped
+  with the given cost.
+*/
+void CriticalPathHeuristic::try_partner(int op, int partner, int cost) {
+    if (unpopped_precondition_pairs[op] != 0)
+        return;
+    for (int pre : relaxed_task->get_preconditions(op)) {
+        if (!is_closed(get_pair_id(pre, partner)))
+            return;
+    }
+    apply_operator_with_partner(op, partner, cost);
+}
+
+int CriticalPathHeuristic::compute_heuristic(const State &state) {
+    current_stamp += 2;
+    if (current_stamp == 0) {
+        // Wrapped around: all stamps are from earlier evaluations again.
+        fill(pair_stamps.begin(), pair_stamps.end(), 0);
+        current_stamp = 2;
+    }
+    unpopped_precondition_pairs = num_precondition_pairs;
+    queue.clear();
+    int num_open_goal_pairs = goal_pairs.size();
+    if (num_open_goal_pairs == 0)
+        return 0;
+
+    for (size_t var1 = 0; var1 < g_variable_domain.size(); ++var1) {
+        int fact1 = relaxed_task->get_fact_id(var1, state[var1]);
+        for (size_t var2 = var1; var2 < g_variable_domain.size(); ++var2)
+            update_pair(fact1, relaxed_task->get_fact_id(var2, state[var2]), 0);
+    }
+    for (int op : relaxed_task->get_operators_without_preconditions())
+        apply_operator(op, 0);
+
+    while (!queue.empty()) {
+        pair<int, pair<int, int>> top = queue.pop();
+        int cost = top.first;
+        int fact1 = top.second.first;
+        int fact2 = top.second.second;
+        int id = get_pair_id(fact1, fact2);
+        if (is_closed(id))
+            continue;
+        pair_stamps[id] = current_stamp + 1;
+        // The goal pair popped last has the maximal cost.
+        if (relaxed_task->is_goal_fact(fact1) &&
+            relaxed_task->is_goal_fact(fact2) && --num_open_goal_pairs == 0)
+            return cost;
+
+        if (fact1 == fact2) {
+            for (int op : relaxed_task->get_precondition_of(fact1)) {
+                if (--unpopped_precondition_pairs[op] == 0)
+                    apply_operator(op, cost);
             }
-            else if (cost > max_cost) {
-                max_cost = cost;
+            int var = relaxed_task->get_fact_var(fact1);
+            for (int op : relaxed_task->get_operators_without_preconditions()) {
+                if (!is_blocked(op, var))
+                    apply_operator_with_partner(op, fact1, cost);
             }
+            continue;
+        }
+        for (int op : relaxed_task->get_precondition_of(fact1)) {
+            if (has_precondition(op, fact2)) {
+                if (--unpopped_precondition_pairs[op] == 0)
+                    apply_operator(op, cost);
+            } else if (!is_blocked(op, relaxed_task->get_fact_var(fact2))) {
+                try_partner(op, fact2, cost);
+            }
+        }
+        for (int op : relaxed_task->get_precondition_of(fact2)) {
+            if (!has_precondition(op, fact1) &&
+                !is_blocked(op, relaxed_task->get_fact_var(fact1)))
+                try_partner(op, fact1, cost);
         }
     }
-    // return DEAD_END;
-    return max_cost;
+    return DEAD_END;
 }
 
 static Heuristic *_parse(OptionParser &parser) {
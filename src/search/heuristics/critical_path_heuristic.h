@@ -2,6 +2,11 @@
 #define CRITICAL_PATH_HEURISTIC_H
 
 #include "../heuristic.h"
+#include "../priority_queue.h"
+#include "relaxed_task.h"
+
+#include <algorithm>
+#include <vector>
 
 // Usage example: the command line option for using the h^{2} heuristic in astar is
 // ./fast-downward.py [path-to-PDDL-problem-file] --search "wastar(h_two())"
@@ -18,11 +23,73 @@
 // a relation of facts/pairs to actions indicating which action can be
 // used to achieve which facts/pairs.
 
+/*
+  h^2 (Haslum & Geffner, 2000) of the relaxed task (see relaxed_task.h).
+
+  The costs of all pairs {p, q} of facts (including the singletons
+  {p, p}) are stored in a dense triangular array indexed by fact IDs.
+  They are computed by a generalized Dijkstra search over pairs: a pair
+  popped from the queue has its final cost, which is at least the cost of
+  every pair popped before. A relaxed operator a becomes applicable when
+  the last pair of its preconditions is popped. It then achieves all pairs
+  of its effects and, for each partner fact q that it does not delete,
+  the pairs {e, q} of its effects e, once all pairs {p, q} with p in
+  pre(a) have been popped as well. Since costs are popped in increasing
+  order, the cost of such an achievement is the operator cost plus the
+  cost of the pair popped last, and each combination of an operator and a
+  partner is processed once.
+
+  The partner facts of an operator are all values of the variables that
+  occur neither in its preconditions nor in its effects; they are stored
+  as variables. Tasks with conditional effects are rejected: the relaxed
+  task splits them into separate operators, so pairs of effects that one
+  operator achieves together would be unreachable.
+*/
 class CriticalPathHeuristic : public Heuristic
 {
+    const RelaxedTask *relaxed_task;
+    int num_facts;
+    // Precomputed data, indexed by relaxed operator.
+    std::vector<int> operator_costs;
+    std::vector<int> num_precondition_pairs;
+    // Sorted variables of the preconditions and effects of each operator
+    // and the partner variables (all other variables), in CSR form.
+    std::vector<int> blocked_var_starts;
+    std::vector<int> blocked_vars;
+    std::vector<int> partner_var_starts;
+    std::vector<int> partner_vars;
+    std::vector<int> goal_pairs;
+
+    // Scratch data of compute_heuristic, indexed by pair or operator.
+    std::vector<int> pair_costs;
+    /*
+      A pair has a cost in the current evaluation if its stamp is
+      current_stamp and is closed if its stamp is current_stamp + 1. Older
+      stamps belong to earlier evaluations, so the pairs need not be reset.
+    */
+    std::vector<unsigned int> pair_stamps;
+    unsigned int current_stamp;
+    std::vector<int> unpopped_precondition_pairs;
+    RadixQueue<std::pair<int, int>> queue;
+
+    int get_pair_id(int fact1, int fact2) const {
+        if (fact1 > fact2)
+            std::swap(fact1, fact2);
+        return fact2 * (fact2 + 1) / 2 + fact1;
+    }
+    bool is_closed(int id) const {
+        return pair_stamps[id] == current_stamp + 1;
+    }
+    bool is_blocked(int op, int var) const;
+    bool has_precondition(int op, int fact) const;
+    void update_pair(int fact1, int fact2, int cost);
+    void apply_operator(int op, int cost);
+    void apply_operator_with_partner(int op, int partner, int cost);
+    void try_partner(int op, int partner, int cost);
 protected:
     virtual void initialize();
     virtual int compute_heuristic(const State &state);
+    virtual Heuristic *clone() const;
 public:
     CriticalPathHeuristic(const Options &options);
     ~CriticalPathHeuristic() = default;
@@ -0,0 +1,519 @@
+#include "factored_transition_system.h"
+
+#include "../globals.h"
+#include "../operator.h"
+#include "../priority_queue.h"
+#include "../state.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+
+using namespace std;
+
+const int FactoredTransitionSystem::INF;
+
+MergeAndShrinkRepresentation::MergeAndShrinkRepresentation(int var_,
+                                                           int domain_size)
+    : var(var_),
+      right_size(0),
+      table(domain_size) {
+    for (int value = 0; value < domain_size; ++value)
+        table[value] = value;
+}
+
+MergeAndShrinkRepresentation::MergeAndShrinkRepresentation(
+    unique_ptr<MergeAndShrinkRepresentation> left_, int left_size,
+    unique_ptr<MergeAndShrinkRepresentation> right_, int right_size_)
+    : var(-1),
+      left(move(left_)),
+      right(move(right_)),
+      right_size(right_size_),
+      table(left_size * right_size_) {
+    for (size_t i = 0; i < table.size(); ++i)
+        table[i] = i;
+}
+
+void MergeAndShrinkRepresentation::apply_abstraction(
+    const vector<int> &abstraction) {
+    for (int &entry : table) {
+        if (entry != -1)
+            entry = abstraction[entry];
+    }
+}
+
+size_t MergeAndShrinkRepresentation::get_num_entries() const {
+    size_t num_entries = table.size();
+    if (left)
+        num_entries += left->get_num_entries() + right->get_num_entries();
+    return num_entries;
+}
+
+size_t FactoredTransitionSystem::Factor::get_num_transitions() const {
+    size_t num_transitions = 0;
+    for (const LabelGroup &group : groups)
+        num_transitions += group.transitions.size();
+    return num_transitions;
+}
+
+bool FactoredTransitionSystem::Factor::is_goal_relevant() const {
+    for (int state = 0; state < num_states; ++state) {
+        if (!goal_states[state])
+            return true;
+    }
+    return false;
+}
+
+bool FactoredTransitionSystem::Factor::is_solvable() const {
+    return init_state != -1 && goal_distances[init_state] != INF;
+}
+
+static size_t hash_transitions(const vector<Transition> &transitions) {
+    size_t hash = transitions.size();
+    for (const Transition &transition : transitions)
+        hash = (hash * 1000003) ^ (size_t(transition.src) * 31 + transition.target);
+    return hash;
+}
+
+// Dijkstra search on a graph in compressed sparse row format.
+static void compute_distances_from(const vector<int> &starts,
+                                   const vector<int> &arc_starts,
+                                   const vector<pair<int, int>> &arcs,
+                                   vector<int> &distances) {
+    AdaptiveQueue<int> queue;
+    for (int state : starts) {
+        distances[state] = 0;
+        queue.push(0, state);
+    }
+    while (!queue.empty()) {
+        pair<int, int> top = queue.pop();
+        int distance = top.first;
+        int state = top.second;
+        if (distance > distances[state])
+            continue;
+        for (int i = arc_starts[state]; i < arc_starts[state + 1]; ++i) {
+            int successor = arcs[i].first;
+            int successor_distance = distance + arcs[i].second;
+            if (successor_distance < distances[successor]) {
+                distances[successor] = successor_distance;
+                queue.push(successor_distance, successor);
+            }
+        }
+    }
+}
+
+FactoredTransitionSystem::FactoredTransitionSystem(
+    const vector<int> &operator_costs)
+    : label_costs(operator_costs),
+      num_active_labels(operator_costs.size()),
+      num_active_factors(0) {
+    for (size_t var = 0; var < g_variable_domain.size(); ++var)
+        build_atomic_factor(var);
+}
+
+void FactoredTransitionSystem::build_atomic_factor(int var) {
+    Factor *factor = new Factor;
+    int domain_size = g_variable_domain[var];
+    factor->num_states = domain_size;
+    factor->init_state = g_initial_state()[var];
+    factor->goal_states.assign(domain_size, true);
+    for (const pair<int, int> &goal : g_goal) {
+        if (goal.first == var) {
+            factor->goal_states.assign(domain_size, false);
+            factor->goal_states[goal.second] = true;
+        }
+    }
+    factor->label_to_group.assign(label_costs.size(), -1);
+    factor->representation.reset(
+        new MergeAndShrinkRepresentation(var, domain_size));
+
+    // Operators that neither mention nor change the variable share a
+    // group with self-loops on all states.
+    int irrelevant_group = -1;
+    vector<const Effect *> effects;
+    for (size_t op_no = 0; op_no < g_operators.size(); ++op_no) {
+        if (!is_active_label(op_no))
+            continue;
+        const Operator &op = g_operators[op_no];
+        int pre = -1;
+        for (const Condition &cond : op.get_preconditions()) {
+            if (cond.var == var)
+                pre = cond.val;
+        }
+        effects.clear();
+        for (const Effect &eff : op.get_effects()) {
+            if (eff.var == var)
+                effects.push_back(&eff);
+        }
+        if (pre == -1 && effects.empty()) {
+            if (irrelevant_group == -1) {
+                irrelevant_group = factor->groups.size();
+                factor->groups.push_back(LabelGroup());
+                for (int value = 0; value < domain_size; ++value)
+                    factor->groups.back().transitions.push_back(
+                        Transition(value, value));
+            }
+            factor->label_to_group[op_no] = irrelevant_group;
+            continue;
+        }
+
+        LabelGroup group;
+        int first_value = pre == -1 ? 0 : pre;
+        int last_value = pre == -1 ? domain_size - 1 : pre;
+        for (int value = first_value; value <= last_value; ++value) {
+            // The value changes for sure if an effect fires whose
+            // conditions only mention this variable.
+            bool changes = false;
+            for (const Effect *eff : effects) {
+                bool possible = true;
+                bool certain = true;
+                for (const Condition &cond : eff->conditions) {
+                    if (cond.var != var)
+                        certain = false;
+                    else if (cond.val != value)
+                        possible = false;
+                }
+                if (possible) {
+                    group.transitions.push_back(Transition(value, eff->val));
+                    if (certain)
+                        changes = true;
+                }
+            }
+            if (!changes)
+                group.transitions.push_back(Transition(value, value));
+        }
+        sort(group.transitions.begin(), group.transitions.end());
+        group.transitions.erase(unique(group.transitions.begin(),
+                                       group.transitions.end()),
+                                group.transitions.end());
+        factor->label_to_group[op_no] = factor->groups.size();
+        factor->groups.push_back(move(group));
+    }
+    normalize(*factor);
+    compute_distances(*factor);
+    factors.push_back(unique_ptr<Factor>(factor));
+    ++num_active_factors;
+}
+
+void FactoredTransitionSystem::normalize(Factor &factor) {
+    int num_labels = label_costs.size();
+    factor.label_to_group.resize(num_labels, -1);
+    for (LabelGroup &group : factor.groups)
+        group.labels.clear();
+    for (int label = 0; label < num_labels; ++label) {
+        if (!is_active_label(label))
+            factor.label_to_group[label] = -1;
+        else if (factor.label_to_group[label] != -1)
+            factor.groups[factor.label_to_group[label]].labels.push_back(label);
+    }
+
+    vector<LabelGroup> groups;
+    unordered_map<size_t, vector<int>> groups_by_hash;
+    for (LabelGroup &group : factor.groups) {
+        if (group.labels.empty())
+            continue;
+        if (group.transitions.empty()) {
+            for (int label : group.labels) {
+                label_costs[label] = -1;
+                factor.label_to_group[label] = -1;
+                --num_active_labels;
+            }
+            continue;
+        }
+        vector<int> &candidates =
+            groups_by_hash[hash_transitions(group.transitions)];
+        int id = -1;
+        for (int candidate : candidates) {
+            if (groups[candidate].transitions == group.transitions) {
+                id = candidate;
+                break;
+            }
+        }
+        if (id == -1) {
+            id = groups.size();
+            candidates.push_back(id);
+            groups.push_back(LabelGroup());
+            groups.back().transitions.swap(group.transitions);
+        }
+        for (int label : group.labels) {
+            factor.label_to_group[label] = id;
+            groups[id].labels.push_back(label);
+        }
+    }
+    for (LabelGroup &group : groups) {
+        group.cost = INF;
+        for (int label : group.labels)
+            group.cost = min(group.cost, label_costs[label]);
+    }
+    factor.groups.swap(groups);
+}
+
+void FactoredTransitionSystem::compute_distances(Factor &factor) {
+    int num_states = factor.num_states;
+    vector<int> forward_starts(num_states + 1, 0);
+    vector<int> backward_starts(num_states + 1, 0);
+    for (const LabelGroup &group : factor.groups) {
+        for (const Transition &transition : group.transitions) {
+            ++forward_starts[transition.src + 1];
+            ++backward_starts[transition.target + 1];
+        }
+    }
+    for (int state = 0; state < num_states; ++state) {
+        forward_starts[state + 1] += forward_starts[state];
+        backward_starts[state + 1] += backward_starts[state];
+    }
+    vector<pair<int, int>> forward_arcs(forward_starts.back());
+    vector<pair<int, int>> backward_arcs(backward_starts.back());
+    vector<int> forward_pos(forward_starts.begin(), forward_starts.end() - 1);
+    vector<int> backward_pos(backward_starts.begin(), backward_starts.end() - 1);
+    for (const LabelGroup &group : factor.groups) {
+        for (const Transition &transition : group.transitions) {
+            forward_arcs[forward_pos[transition.src]++] =
+                make_pair(transition.target, group.cost);
+            backward_arcs[backward_pos[transition.target]++] =
+                make_pair(transition.src, group.cost);
+        }
+    }
+
+    factor.init_distances.assign(num_states, INF);
+    if (factor.init_state != -1) {
+        compute_distances_from(vector<int>(1, factor.init_state),
+                               forward_starts, forward_arcs,
+                               factor.init_distances);
+    }
+    vector<int> goal_states;
+    for (int state = 0; state < num_states; ++state) {
+        if (factor.goal_states[state])
+            goal_states.push_back(state);
+    }
+    factor.goal_distances.assign(num_states, INF);
+    compute_distances_from(goal_states, backward_starts, backward_arcs,
+                           factor.goal_distances);
+}
+
+size_t FactoredTransitionSystem::get_num_transitions() const {
+    size_t num_transitions = 0;
+    for (const unique_ptr<Factor> &factor : factors) {
+        if (factor)
+            num_transitions += factor->get_num_transitions();
+    }
+    return num_transitions;
+}
+
+bool FactoredTransitionSystem::reduce_labels(int index) {
+    // Equivalence classes of the labels with the same cost and the same
+    // group in all other factors.
+    int num_labels = label_costs.size();
+    vector<int> classes(num_labels, -1);
+    unordered_map<int, int> cost_classes;
+    for (int label = 0; label < num_labels; ++label) {
+        if (is_active_label(label)) {
+            classes[label] = cost_classes.insert(
+                make_pair(label_costs[label], cost_classes.size())).first->second;
+        }
+    }
+    for (size_t other = 0; other < factors.size(); ++other) {
+        if (!factors[other] || int(other) == index)
+            continue;
+        const vector<int> &label_to_group = factors[other]->label_to_group;
+        unordered_map<uint64_t, int> refined_classes;
+        for (int label = 0; label < num_labels; ++label) {
+            if (!is_active_label(label))
+                continue;
+            uint64_t key = (uint64_t(classes[label]) << 32) |
+                           uint32_t(label_to_group[label]);
+            classes[label] = refined_classes.insert(
+                make_pair(key, refined_classes.size())).first->second;
+        }
+    }
+
+    vector<vector<int>> members;
+    for (int label = 0; label < num_labels; ++label) {
+        if (!is_active_label(label))
+            continue;
+        if (classes[label] >= static_cast<int>(members.size()))
+            members.resize(classes[label] + 1);
+        members[classes[label]].push_back(label);
+    }
+    int num_new_labels = 0;
+    for (const vector<int> &labels : members) {
+        if (labels.size() > 1)
+            ++num_new_labels;
+    }
+    if (num_new_labels == 0)
+        return false;
+
+    for (unique_ptr<Factor> &factor : factors) {
+        if (factor)
+            factor->label_to_group.resize(num_labels + num_new_labels, -1);
+    }
+    Factor &reduced = *factors[index];
+    vector<int> old_groups;
+    for (const vector<int> &labels : members) {
+        if (labels.size() < 2)
+            continue;
+        int new_label = label_costs.size();
+        label_costs.push_back(label_costs[labels[0]]);
+        for (size_t other = 0; other < factors.size(); ++other) {
+            if (factors[other] && int(other) != index) {
+                vector<int> &label_to_group = factors[other]->label_to_group;
+                label_to_group[new_label] = label_to_group[labels[0]];
+            }
+        }
+        old_groups.clear();
+        for (int label : labels) {
+            old_groups.push_back(reduced.label_to_group[label]);
+            label_costs[label] = -1;
+        }
+        num_active_labels -= labels.size() - 1;
+        sort(old_groups.begin(), old_groups.end());
+        old_groups.erase(unique(old_groups.begin(), old_groups.end()),
+                         old_groups.end());
+        LabelGroup group;
+        for (int old_group : old_groups) {
+            const vector<Transition> &transitions =
+                reduced.groups[old_group].transitions;
+            group.transitions.insert(group.transitions.end(),
+                                     transitions.begin(), transitions.end());
+        }
+        if (old_groups.size() > 1) {
+            sort(group.transitions.begin(), group.transitions.end());
+            group.transitions.erase(unique(group.transitions.begin(),
+                                           group.transitions.end()),
+                                    group.transitions.end());
+        }
+        reduced.label_to_group[new_label] = reduced.groups.size();
+        reduced.groups.push_back(move(group));
+    }
+    // Reduced labels have the same cost, so the distances do not change.
+    for (unique_ptr<Factor> &factor : factors) {
+        if (factor)
+            normalize(*factor);
+    }
+    return true;
+}
+
+void FactoredTransitionSystem::apply_abstraction(
+    int index, const vector<int> &abstraction, int num_abstract_states) {
+    Factor &factor = *factors[index];
+    assert(static_cast<int>(abstraction.size()) == factor.num_states);
+    for (LabelGroup &group : factor.groups) {
+        vector<Transition> &transitions = group.transitions;
+        size_t num_kept = 0;
+        for (const Transition &transition : transitions) {
+            int src = abstraction[transition.src];
+            int target = abstraction[transition.target];
+            if (src != -1 && target != -1)
+                transitions[num_kept++] = Transition(src, target);
+        }
+        transitions.erase(transitions.begin() + num_kept, transitions.end());
+        sort(transitions.begin(), transitions.end());
+        transitions.erase(unique(transitions.begin(), transitions.end()),
+                          transitions.end());
+        transitions.shrink_to_fit();
+    }
+    vector<bool> goal_states(num_abstract_states, false);
+    for (int state = 0; state < factor.num_states; ++state) {
+        if (factor.goal_states[state] && abstraction[state] != -1)
+            goal_states[abstraction[state]] = true;
+    }
+    factor.goal_states.swap(goal_states);
+    if (factor.init_state != -1)
+        factor.init_state = abstraction[factor.init_state];
+    factor.num_states = num_abstract_states;
+    factor.representation->apply_abstraction(abstraction);
+    normalize(factor);
+    compute_distances(factor);
+}
+
+bool FactoredTransitionSystem::prune(int index) {
+    const Factor &factor = *factors[index];
+    vector<int> abstraction(factor.num_states, -1);
+    int num_abstract_states = 0;
+    for (int state = 0; state < factor.num_states; ++state) {
+        if (factor.init_distances[state] != INF &&
+            factor.goal_distances[state] != INF)
+            abstraction[state] = num_abstract_states++;
+    }
+    if (num_abstract_states < factor.num_states)
+        apply_abstraction(index, abstraction, num_abstract_states);
+    return factor.is_solvable();
+}
+
+int FactoredTransitionSystem::merge(int index1, int index2) {
+    Factor &factor1 = *factors[index1];
+    Factor &factor2 = *factors[index2];
+    int size1 = factor1.num_states;
+    int size2 = factor2.num_states;
+    assert(int64_t(size1) * size2 <= numeric_limits<int>::max());
+
+    Factor *product = new Factor;
+    product->num_states = size1 * size2;
+    product->init_state = -1;
+    if (factor1.init_state != -1 && factor2.init_state != -1)
+        product->init_state = factor1.init_state * size2 + factor2.init_state;
+    product->goal_states.assign(product->num_states, false);
+    for (int state1 = 0; state1 < size1; ++state1) {
+        if (!factor1.goal_states[state1])
+            continue;
+        for (int state2 = 0; state2 < size2; ++state2) {
+            if (factor2.goal_states[state2])
+                product->goal_states[state1 * size2 + state2] = true;
+        }
+    }
+
+    // The groups of the product are the pairs of groups of the factors.
+    int num_labels = label_costs.size();
+    product->label_to_group.assign(num_labels, -1);
+    unordered_map<uint64_t, int> group_ids;
+    for (int label = 0; label < num_labels; ++label) {
+        if (!is_active_label(label))
+            continue;
+        int group1 = factor1.label_to_group[label];
+        int group2 = factor2.label_to_group[label];
+        assert(group1 != -1 && group2 != -1);
+        uint64_t key = (uint64_t(group1) << 32) | uint32_t(group2);
+        pair<unordered_map<uint64_t, int>::iterator, bool> inserted =
+            group_ids.insert(make_pair(key, product->groups.size()));
+        if (inserted.second) {
+            const vector<Transition> &transitions1 =
+                factor1.groups[group1].transitions;
+            const vector<Transition> &transitions2 =
+                factor2.groups[group2].transitions;
+            LabelGroup group;
+            group.transitions.reserve(transitions1.size() * transitions2.size());
+            for (const Transition &transition1 : transitions1) {
+                for (const Transition &transition2 : transitions2) {
+                    group.transitions.push_back(Transition(
+                        transition1.src * size2 + transition2.src,
+                        transition1.target * size2 + transition2.target));
+                }
+            }
+            sort(group.transitions.begin(), group.transitions.end());
+            product->groups.push_back(move(group));
+        }
+        product->label_to_group[label] = inserted.first->second;
+    }
+    product->representation.reset(new MergeAndShrinkRepresentation(
+        move(factor1.representation), size1,
+        move(factor2.representation), size2));
+
+    factors[index1].reset();
+    factors[index2].reset();
+    factors.push_back(unique_ptr<Factor>(product));
+    --num_active_factors;
+    normalize(*product);
+    compute_distances(*product);
+    return factors.size() - 1;
+}
+
+void FactoredTransitionSystem::release(
+    int index, unique_ptr<MergeAndShrinkRepresentation> &representation,
+    vector<int> &goal_distances) {
+    representation = move(factors[index]->representation);
+    goal_distances.swap(factors[index]->goal_distances);
+    factors[index].reset();
+    --num_active_factors;
+}
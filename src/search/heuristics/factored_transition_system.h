@@ -0,0 +1,181 @@
+#ifndef HEURISTICS_FACTORED_TRANSITION_SYSTEM_H
+#define HEURISTICS_FACTORED_TRANSITION_SYSTEM_H
+
+#include <cstddef>
+#include <limits>
+#include <memory>
+#include <vector>
+
+/*
+  Cascading tables (Helmert et al., 2014) that map the states of the task
+  to the abstract states of a factor. A leaf maps the values of one
+  variable, an inner node the pairs of abstract states of its children.
+  -1 stands for a pruned abstract state. Only the table of the root
+  changes when the factor is shrunk; the tables of the children are
+  fixed once they are merged.
+*/
+class MergeAndShrinkRepresentation {
+    // -1 for inner nodes.
+    int var;
+    std::unique_ptr<MergeAndShrinkRepresentation> left;
+    std::unique_ptr<MergeAndShrinkRepresentation> right;
+    int right_size;
+    std::vector<int> table;
+public:
+    MergeAndShrinkRepresentation(int var, int domain_size);
+    MergeAndShrinkRepresentation(
+        std::unique_ptr<MergeAndShrinkRepresentation> left, int left_size,
+        std::unique_ptr<MergeAndShrinkRepresentation> right, int right_size);
+
+    void apply_abstraction(const std::vector<int> &abstraction);
+    // Number of table entries of the whole tree.
+    size_t get_num_entries() const;
+
+    // Values can be a State or a vector with one value per variable.
+    template<class Values>
+    int lookup(const Values &values) const {
+        if (var != -1)
+            return table[values[var]];
+        int left_state = left->lookup(values);
+        if (left_state == -1)
+            return -1;
+        int right_state = right->lookup(values);
+        if (right_state == -1)
+            return -1;
+        return table[left_state * right_size + right_state];
+    }
+};
+
+struct Transition {
+    int src;
+    int target;
+
+    Transition(int src_, int target_)
+        : src(src_), target(target_) {
+    }
+    bool operator<(const Transition &other) const {
+        return src < other.src || (src == other.src && target < other.target);
+    }
+    bool operator==(const Transition &other) const {
+        return src == other.src && target == other.target;
+    }
+};
+
+/*
+  Factored transition system of merge-and-shrink: a set of factors, i.e.,
+  abstract transition systems whose synchronized product is an
+  abstraction of the task, over a common set of labels.
+
+  Labels start as the operators (label i is operator i) and are replaced
+  by new labels when they are reduced. In each factor, the labels with
+  the same transitions form a label group that stores the transitions
+  once, so the memory of a factor depends on the number of distinct
+  transition relations rather than on the number of labels. Labels
+  without transitions in a factor can never be applied and are removed
+  from all factors.
+
+  Label reduction is exact (Sievers, Wehrle & Helmert, 2014): labels with
+  the same cost that are in the same group in all factors but one are
+  replaced by a single label, whose transitions in the remaining factor
+  are the union of theirs. This does not change the product.
+
+  Atomic factors are exact projections except for conditional effects
+  whose conditions mention other variables, where both outcomes are
+  kept. Abstract states that are unreachable from the initial state or
+  cannot reach a goal state can be pruned.
+*/
+class FactoredTransitionSystem {
+public:
+    static const int INF = std::numeric_limits<int>::max();
+
+    struct LabelGroup {
+        std::vector<int> labels;
+        // Sorted and without duplicates.
+        std::vector<Transition> transitions;
+        int cost;
+    };
+
+    struct Factor {
+        int num_states;
+        // -1 if the initial state is pruned.
+        int init_state;
+        std::vector<bool> goal_states;
+        std::vector<LabelGroup> groups;
+        // Group of each label, -1 for labels that are no longer used.
+        std::vector<int> label_to_group;
+        std::vector<int> init_distances;
+        std::vector<int> goal_distances;
+        std::unique_ptr<MergeAndShrinkRepresentation> representation;
+
+        size_t get_num_transitions() const;
+        // True if some state is not a goal state.
+        bool is_goal_relevant() const;
+        bool is_solvable() const;
+    };
+private:
+    // Cost of each label, -1 for labels that are no longer used.
+    std::vector<int> label_costs;
+    int num_active_labels;
+    // Merged factors are null.
+    std::vector<std::unique_ptr<Factor>> factors;
+    int num_active_factors;
+
+    void build_atomic_factor(int var);
+    /*
+      Rebuilds the label lists of the groups, removes the labels of groups
+      without transitions from all factors and merges groups with the same
+      transitions.
+    */
+    void normalize(Factor &factor);
+    void compute_distances(Factor &factor);
+public:
+    // Factor i is the atomic factor of variable i.
+    explicit FactoredTransitionSystem(const std::vector<int> &operator_costs);
+
+    int get_num_factors() const {
+        return factors.size();
+    }
+    int get_num_active_factors() const {
+        return num_active_factors;
+    }
+    bool is_active(int index) const {
+        return factors[index] != nullptr;
+    }
+    const Factor &get_factor(int index) const {
+        return *factors[index];
+    }
+    int get_num_labels() const {
+        return label_costs.size();
+    }
+    int get_num_active_labels() const {
+        return num_active_labels;
+    }
+    bool is_active_label(int label) const {
+        return label_costs[label] != -1;
+    }
+    size_t get_num_transitions() const;
+
+    /*
+      Reduces the labels that are combinable with respect to the factor.
+      Returns false if no labels were reduced.
+    */
+    bool reduce_labels(int index);
+    /*
+      Abstraction maps each state of the factor to an abstract state in
+      0, ..., num_abstract_states - 1 or to -1 to prune it.
+    */
+    void apply_abstraction(int index, const std::vector<int> &abstraction,
+                           int num_abstract_states);
+    /*
+      Prunes the states that are unreachable or cannot reach a goal state.
+      Returns false if the initial state is a dead end.
+    */
+    bool prune(int index);
+    // Replaces the factors by their product and returns its index.
+    int merge(int index1, int index2);
+    // Removes the factor and hands over its representation and distances.
+    void release(int index, std::unique_ptr<MergeAndShrinkRepresentation> &
+                 representation, std::vector<int> &goal_distances);
+};
+
+#endif
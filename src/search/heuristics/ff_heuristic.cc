@@ -6,130 +6,109 @@
 #include "../plugin.h"
 #include "../state.h"
 
-
 using namespace std;
 
 FFHeuristic::FFHeuristic(const Options &opts)
-    : Heuristic(opts)
+    : Heuristic(opts),
+      relaxed_task(0),
+      incremental(opts.contains("incremental") &&
+                  opts.get<bool>("incremental"))
 {
 }
 
 void FFHeuristic::initialize()
 {
     cout << "Initializing FF heuristic..." << endl;
+    relaxed_task = &get_relaxed_task();
+    vector<int> operator_costs;
+    for (size_t i = 0; i < g_operators.size(); ++i) {
+        operator_costs.push_back(get_adjusted_cost(g_operators[i]));
+    }
+    // h^max best supporters
+    exploration = RelaxedExploration(*relaxed_task, operator_costs,
+                                     RelaxedExploration::MAX, incremental);
+    fact_marked.resize(relaxed_task->get_num_facts());
+    relaxed_operator_marked.resize(relaxed_task->get_num_operators());
+    operator_marked.resize(g_operators.size());
 }
 
-typedef std::pair<int,int> varVal;
-
+void FFHeuristic::reach_state(const State &parent_state,
+                              const Operator &/*op*/, const State &state)
+{
+    exploration.set_parent(parent_state, state);
+}
 
 int FFHeuristic::compute_heuristic(const State &state)
 {
-    /* Init vector with all the variable values with infinite */
-    std::vector<std::vector<int> > iterative_costs;
-    iterative_costs.resize(g_variable_domain.size());
-    for (unsigned var = 0; var < g_variable_domain.size(); var++) {
-        iterative_costs[var].resize(g_variable_domain[var], DEAD_END);
-        iterative_costs[var][state[var]] = 0;
+    clear_relaxed_plan();
+    exploration.compute(state);
+    if (exploration.get_goal_cost() == -1) {
+        return DEAD_END;
     }
-    /* Init vector with all best-supporter functions */
-    std::vector<std::vector<const Operator *>> supporter_func;
-    supporter_func.resize(g_variable_domain.size());
-    for (unsigned var = 0; var < g_variable_domain.size(); var++) {
-        supporter_func[var].resize(g_variable_domain[var], &g_operators[0]);
+    /*
+      Calculate relaxed plan. Facts of the state are exactly the facts
+      without best supporter. marked_facts serves as the open list: facts
+      are appended when they are marked and processed in that order, so
+      afterwards it contains all marked facts.
+    */
+    for (int goal : relaxed_task->get_goal_facts()) {
+        mark_fact(goal);
     }
-    /* Begin iterations */
-    bool state_changed = true;
-    while (state_changed) {
-        state_changed = false;
-        for (size_t i = 0; i < g_operators.size(); i++) {
-            const vector<Condition> &preconditions = g_operators[i].get_preconditions();
-            bool applicable = true;
-            int previous_cost = 0;
-            for (size_t p = 0; p < preconditions.size(); p++) {
-                if (iterative_costs[preconditions[p].var][preconditions[p].val] == DEAD_END) {
-                    applicable = false;
-                    break;
-                } else {
-                    int cost = iterative_costs[preconditions[p].var][preconditions[p].val];
-                    if (cost > previous_cost) {
-                        previous_cost = cost;
-                    }
-                }
-            }
-            if (applicable) {
-                const vector<Effect> &effects = g_operators[i].get_effects();
-                const Operator &possible_action = g_operators[i];
-                const int &possible_action_cost = possible_action.get_cost() + previous_cost;
-                for (size_t e = 0; e < effects.size(); e++) {
-                    if (iterative_costs[effects[e].var][effects[e].val] == DEAD_END || possible_action_cost < iterative_costs[effects[e].var][effects[e].val]) {
-                        state_changed = true;
-                        iterative_costs[effects[e].var][effects[e].val] = possible_action_cost;
-                        supporter_func[effects[e].var][effects[e].val] = &g_operators[i];
-                    }
-                    
-                }
-            }
-        }
-    }
-    /* Check goals are reached */
-    for (size_t g = 0; g < g_goal.size(); g++) {
-        int cost = iterative_costs[g_goal[g].first][g_goal[g].second];
-        if (cost == DEAD_END){
-            return DEAD_END;
-        }
-    }
-    /* Calculate relaxed plan */
-    std::vector<varVal> open;
-    for (size_t g = 0; g < g_goal.size(); g++) {
-        // add all goals that are not in initial state to the open set
-        if (state[g_goal[g].first] != g_goal[g].second) {
-            open.insert(open.end(), make_pair(g_goal[g].first, g_goal[g].second));
-        }
-    }
-    std::vector<varVal> closed;
-    std::vector<const Operator*> relaxed_plan;
-    /* Iterate over open set */
-    while (open.size() > 0) {
-        varVal const g = open.back();
-        open.pop_back();
-        closed.insert(closed.end(), g);
-        const Operator* &sf = supporter_func[g.first][g.second];
+    for (size_t i = 0; i < marked_facts.size(); ++i) {
+        int supporter = exploration.get_best_supporter(marked_facts[i]);
         // just add the action if it has not been added before
-        auto it = find(relaxed_plan.begin(), relaxed_plan.end(), sf);
-        if (it == relaxed_plan.end()) {
-            relaxed_plan.insert(relaxed_plan.end(), sf);
-            const vector<Condition> &preconditions = (*sf).get_preconditions();
-            // Add effects of action in closed list
-            // commented because causes relaxed plan not to assert to true for the is_relaxed_plan()
-            // const vector<Effect> &effects = (*sf).get_effects();
-            // for (size_t e = 0; e < effects.size(); e++) {
-            //     varVal effect = make_pair(effects[e].var, effects[e].val);
-            //     closed.insert(closed.end(), effect);
-            // }
-            for (size_t p = 0; p < preconditions.size(); p++) {
-                varVal precondition = make_pair(preconditions[p].var, preconditions[p].val);
-                // not in initial state
-                if (state[preconditions[p].var] != preconditions[p].val &&
-                    // nor in closed
-                    (find(closed.begin(), closed.end(), precondition) == closed.end()) &&
-                    // nor in opened already
-                    (find(open.begin(), open.end(), precondition) == open.end())
-                ) 
-                {
-                    // add to open vector at the end.
-                    open.insert(open.end(), precondition);
-                }
+        if (relaxed_operator_marked[supporter]) {
+            continue;
+        }
+        relaxed_operator_marked[supporter] = true;
+        marked_relaxed_operators.push_back(supporter);
+        int op_no = relaxed_task->get_operator_no(supporter);
+        if (!operator_marked[op_no]) {
+            operator_marked[op_no] = true;
+            const Operator *op = &g_operators[op_no];
+            relaxed_plan.push_back(op);
+            if (op->is_applicable(state)) {
+                helpful_actions.push_back(op);
             }
         }
+        for (int pre : relaxed_task->get_preconditions(supporter)) {
+            mark_fact(pre);
+        }
     }
     // assert(is_relaxed_plan(state, relaxed_plan));
     return relaxed_plan.size();
 }
 
-void FFHeuristic::get_helpful_actions(std::vector<const Operator *>
-                                      &/*result*/)
+void FFHeuristic::mark_fact(int fact)
+{
+    // neither in the state nor marked before
+    if (exploration.get_best_supporter(fact) != -1 && !fact_marked[fact]) {
+        fact_marked[fact] = true;
+        marked_facts.push_back(fact);
+    }
+}
+
+void FFHeuristic::clear_relaxed_plan()
+{
+    for (int fact : marked_facts) {
+        fact_marked[fact] = false;
+    }
+    marked_facts.clear();
+    for (int op : marked_relaxed_operators) {
+        relaxed_operator_marked[op] = false;
+    }
+    marked_relaxed_operators.clear();
+    for (const Operator *op : relaxed_plan) {
+        operator_marked[op - &g_operators[0]] = false;
+    }
+    relaxed_plan.clear();
+    helpful_actions.clear();
+}
+
+void FFHeuristic::add_helpful_actions(std::vector<const Operator *> &result)
 {
-    // TODO implementation
+    result.insert(result.end(), helpful_actions.begin(),
+                  helpful_actions.end());
 }
 
 bool FFHeuristic::is_relaxed_plan(const State &state,
@@ -180,6 +159,10 @@ bool FFHeuristic::is_relaxed_plan(const State &state,
 static Heuristic *_parse(OptionParser &parser)
 {
     Heuristic::add_options_to_parser(parser);
+    parser.add_option<bool>(
+        "incremental",
+        "repair the exploration of the parent state instead of exploring "
+        "each successor from scratch", "false");
     Options opts = parser.parse();
     if (parser.dry_run()) {
         return 0;
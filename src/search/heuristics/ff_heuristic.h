@@ -2,6 +2,7 @@
 #define FF_HEURISTIC_H
 
 #include "../heuristic.h"
+#include "relaxed_exploration.h"
 
 // Usage example: the command line option for using the h^{FF} heuristic in astar is
 // ./fast-downward.py [path-to-PDDL-problem-file] --search "wastar(ff())"
@@ -14,7 +15,7 @@
 // implementing h^{FF}, a working implementation of h^{add}/h^{max} is strongly
 // recommended.)
 //
-// Helpful actions: in get_helpful_actions you should only add those
+// Helpful actions: in add_helpful_actions you should only add those
 // operators of the relaxed plan to result that are applicable in the state on which
 // compute_heuristic is called.
 //
@@ -30,6 +31,23 @@
 
 class FFHeuristic : public Heuristic
 {
+    const RelaxedTask *relaxed_task;
+    bool incremental;
+    // Scratch data of compute_heuristic, indexed by fact or relaxed operator.
+    RelaxedExploration exploration;
+    std::vector<bool> fact_marked;
+    std::vector<bool> relaxed_operator_marked;
+    std::vector<bool> operator_marked;
+    std::vector<int> marked_facts;
+    std::vector<int> marked_relaxed_operators;
+    // Relaxed plan of the last evaluated state and its operators that are
+    // applicable in that state.
+    std::vector<const Operator *> relaxed_plan;
+    std::vector<const Operator *> helpful_actions;
+
+    void mark_fact(int fact);
+    // Resets the marks and buffers in time linear in the relaxed plan.
+    void clear_relaxed_plan();
 protected:
     // NOTE: We do not pass a reference to the relaxed plan as relaxed_plan is
     // modified internally. The function does not assume a particular order of actions.
@@ -38,10 +56,12 @@ protected:
 
     virtual void initialize();
     virtual int compute_heuristic(const State &state);
+    virtual void add_helpful_actions(std::vector<const Operator *> &result);
 public:
     FFHeuristic(const Options &options);
     ~FFHeuristic() = default;
-    virtual void get_helpful_actions(std::vector<const Operator *> &result);
+    virtual void reach_state(const State &parent_state, const Operator &op,
+                             const State &state);
 };
 
 #endif
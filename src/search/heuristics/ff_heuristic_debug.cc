@@ -173,7 +173,7 @@ int FFHeuristic::compute_heuristic(const State &state)
 
 }
 
-void FFHeuristic::get_helpful_actions(std::vector<const Operator *>
+void FFHeuristic::add_helpful_actions(std::vector<const Operator *>
                                       &/*result*/)
 {
     // TODO implementation
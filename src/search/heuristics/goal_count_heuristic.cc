@@ -30,6 +30,11 @@ int GoalCountHeuristic::compute_heuristic(const State &state)
     return unachieved_goals;
 }
 
+Heuristic *GoalCountHeuristic::clone() const
+{
+    return new GoalCountHeuristic(*this);
+}
+
 static Heuristic *_parse(OptionParser &parser)
 {
     Heuristic::add_options_to_parser(parser);
@@ -17,6 +17,7 @@ class GoalCountHeuristic : public Heuristic
 protected:
     virtual void initialize();
     virtual int compute_heuristic(const State &state);
+    virtual Heuristic *clone() const;
 public:
     GoalCountHeuristic(const Options &options);
     ~GoalCountHeuristic() = default;
@@ -0,0 +1,131 @@
+#include "hm_heuristic.h"
+
+#include "../globals.h"
+#include "../operator.h"
+#include "../option_parser.h"
+#include "../plugin.h"
+#include "../state.h"
+
+using namespace std;
+
+HMHeuristic::HMHeuristic(const Options &opts)
+    : Heuristic(opts),
+      requested_m(opts.get<int>("m")),
+      memory_limit(opts.get<int>("memory_limit")),
+      relaxed_task(0) {
+}
+
+void HMHeuristic::compute_mutexes() {
+    if (has_axioms()) {
+        cout << "Task has axioms: no h^m mutexes are computed." << endl;
+        return;
+    }
+    const State &initial_state = g_initial_state();
+    state_facts.clear();
+    for (size_t var = 0; var < g_variable_domain.size(); ++var)
+        state_facts.push_back(relaxed_task->get_fact_id(var, initial_state[var]));
+    meta_state_facts.clear();
+    compilation->collect_all_meta_facts(state_facts, meta_state_facts);
+    exploration.compute(meta_state_facts, false);
+
+    int num_pairs = 0;
+    vector<int> facts;
+    vector<int> subset;
+    for (int id = 0; id < compilation->get_num_meta_facts(); ++id) {
+        if (exploration.get_fact_cost(id) != -1)
+            continue;
+        compilation->get_facts(id, facts);
+        if (facts.size() < 2)
+            continue;
+        // Only minimal mutexes: all subsets that omit one fact are reached.
+        bool minimal = true;
+        for (size_t i = 0; i < facts.size() && minimal; ++i) {
+            subset = facts;
+            subset.erase(subset.begin() + i);
+            int subset_id = compilation->get_meta_fact_id(subset);
+            if (subset_id == -1 || exploration.get_fact_cost(subset_id) == -1)
+                minimal = false;
+        }
+        if (!minimal)
+            continue;
+        Mutex mutex;
+        for (int fact : facts) {
+            mutex.push_back(make_pair(relaxed_task->get_fact_var(fact),
+                                      relaxed_task->get_fact_value(fact)));
+        }
+        if (mutex.size() == 2)
+            ++num_pairs;
+        mutexes.push_back(mutex);
+    }
+    cout << "h^m mutexes: " << num_pairs << " pairs, "
+         << mutexes.size() - num_pairs << " larger sets" << endl;
+    PmCompilation::publish_mutexes(mutexes);
+}
+
+void HMHeuristic::initialize() {
+    cout << "Initializing h^m heuristic..." << endl;
+    relaxed_task = &get_relaxed_task();
+    PmCompilation *comp = 0;
+    for (int m = requested_m; !comp; --m) {
+        comp = PmCompilation::build(*relaxed_task, m,
+                                    size_t(memory_limit) << 20);
+        if (!comp)
+            cout << "P^" << m << " compilation exceeds the memory limit" << endl;
+    }
+    compilation.reset(comp);
+    cout << "P^" << comp->get_m() << " compilation: "
+         << comp->get_num_meta_facts() << " meta-facts, "
+         << comp->get_task().get_num_operators() << " meta-operators, "
+         << comp->get_task().get_num_entries() << " entries" << endl;
+
+    vector<int> operator_costs;
+    for (size_t i = 0; i < g_operators.size(); ++i)
+        operator_costs.push_back(get_adjusted_cost(g_operators[i]));
+    exploration = RelaxedExploration(comp->get_task(), operator_costs,
+                                     RelaxedExploration::MAX);
+    compute_mutexes();
+}
+
+Heuristic *HMHeuristic::clone() const {
+    // Shares the compilation; the scratch data is copied.
+    return new HMHeuristic(*this);
+}
+
+int HMHeuristic::compute_heuristic(const State &state) {
+    if (compilation->is_unsolvable())
+        return DEAD_END;
+    state_facts.clear();
+    for (size_t var = 0; var < g_variable_domain.size(); ++var)
+        state_facts.push_back(relaxed_task->get_fact_id(var, state[var]));
+    meta_state_facts.clear();
+    compilation->collect_all_meta_facts(state_facts, meta_state_facts);
+    exploration.compute(meta_state_facts);
+    int goal_cost = exploration.get_goal_cost();
+    if (goal_cost == -1)
+        return DEAD_END;
+    return goal_cost;
+}
+
+static Heuristic *_parse(OptionParser &parser) {
+    parser.document_synopsis(
+        "h^m heuristic",
+        "h^max of the P^m compilation; reports the h^m mutexes of the "
+        "initial state");
+    Heuristic::add_options_to_parser(parser);
+    parser.add_option<int>("m", "size of the fact sets (1 to 4)", "2");
+    parser.add_option<int>(
+        "memory_limit",
+        "memory limit of the compilation in MiB; m is reduced until the "
+        "compilation fits", "1024");
+    Options opts = parser.parse();
+    if (opts.get<int>("m") < 1 || opts.get<int>("m") > 4)
+        parser.error("m must be between 1 and 4");
+    if (opts.get<int>("memory_limit") < 1)
+        parser.error("memory_limit must be positive");
+    if (parser.dry_run())
+        return 0;
+    else
+        return new HMHeuristic(opts);
+}
+
+static Plugin<Heuristic> _plugin("hm", _parse);
@@ -0,0 +1,67 @@
+#ifndef HM_HEURISTIC_H
+#define HM_HEURISTIC_H
+
+#include "../heuristic.h"
+#include "pm_compilation.h"
+#include "relaxed_exploration.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Usage example: the command line option for using the h^{m} heuristic
+// (here with m = 3) in astar is
+// ./fast-downward.py [path-to-PDDL-problem-file] --search "wastar(hm(m=3))"
+// Obviously, [path-to-PDDL-problem-file] has to be replaced by the actual path
+// to the PDDL problem file.
+
+/*
+  h^m (Haslum & Geffner, 2000) for m = 1, ..., 4, computed as h^max of the
+  P^m compilation of the relaxed task (see pm_compilation.h) with the
+  Dijkstra exploration of the relaxed task. h^m of a state is the h^max
+  cost of the goal meta-facts from the meta-facts contained in the state.
+
+  The compilation is built once. If its estimated size exceeds the
+  memory limit, it is rebuilt with a smaller m. Clones share it.
+
+  After building the compilation, the initial state is explored
+  completely, and the unreachable meta-facts whose proper subsets are
+  reachable are the h^m mutexes. They are available with get_mutexes()
+  and published with PmCompilation::publish_mutexes(), so that the P^m
+  compilations built afterwards (of other h^m heuristics or of the h^m
+  landmarks) leave out the meta-facts with an h^m mutex pair. Later h^m
+  heuristics therefore do not list such pairs again. The global mutexes of
+  the translator (see are_mutex() in globals.h) are not changed, since the
+  globals are read-only after the task is read. Since axioms are ignored,
+  no mutexes are computed for tasks with axioms.
+*/
+class HMHeuristic : public Heuristic
+{
+public:
+    typedef PmCompilation::Mutex Mutex;
+private:
+    int requested_m;
+    int memory_limit;
+    const RelaxedTask *relaxed_task;
+    std::shared_ptr<const PmCompilation> compilation;
+    std::vector<Mutex> mutexes;
+    // Scratch data.
+    RelaxedExploration exploration;
+    std::vector<int> state_facts;
+    std::vector<int> meta_state_facts;
+
+    void compute_mutexes();
+protected:
+    virtual void initialize();
+    virtual int compute_heuristic(const State &state);
+    virtual Heuristic *clone() const;
+public:
+    HMHeuristic(const Options &options);
+    ~HMHeuristic() = default;
+
+    const std::vector<Mutex> &get_mutexes() const {
+        return mutexes;
+    }
+};
+
+#endif
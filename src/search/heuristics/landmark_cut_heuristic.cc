@@ -6,23 +6,282 @@
 #include "../plugin.h"
 #include "../state.h"
 
+#include <cassert>
+#include <limits>
 
 using namespace std;
 
 LMCutHeuristic::LMCutHeuristic(const Options &opts)
-    : Heuristic(opts)
+    : Heuristic(opts),
+      relaxed_task(0),
+      init_fact(-1),
+      goal_fact(-1)
 {
 }
 
 void LMCutHeuristic::initialize()
 {
     cout << "Initializing LM-cut heuristic..." << endl;
+    relaxed_task = &get_relaxed_task();
+    int num_facts = relaxed_task->get_num_facts();
+    int num_relaxed_operators = relaxed_task->get_num_operators();
+    int goal_operator_no = g_operators.size();
+    init_fact = num_facts;
+    goal_fact = num_facts + 1;
+
+    RelaxedTask *lm_cut_task = new RelaxedTask(num_facts + 2);
+    vector<int> pre_facts;
+    vector<int> eff_facts;
+    relaxed_operator_starts.assign(g_operators.size() + 2, 0);
+    for (int op = 0; op < num_relaxed_operators; ++op) {
+        RelaxedTask::IdRange pre = relaxed_task->get_preconditions(op);
+        RelaxedTask::IdRange eff = relaxed_task->get_effects(op);
+        pre_facts.assign(pre.begin(), pre.end());
+        if (pre_facts.empty())
+            pre_facts.push_back(init_fact);
+        eff_facts.assign(eff.begin(), eff.end());
+        int op_no = relaxed_task->get_operator_no(op);
+        lm_cut_task->add_operator(op_no, pre_facts, eff_facts);
+        ++relaxed_operator_starts[op_no + 1];
+    }
+    pre_facts = relaxed_task->get_goal_facts();
+    if (pre_facts.empty())
+        pre_facts.push_back(init_fact);
+    eff_facts.assign(1, goal_fact);
+    lm_cut_task->add_operator(goal_operator_no, pre_facts, eff_facts);
+    ++relaxed_operator_starts[goal_operator_no + 1];
+    lm_cut_task->finish(vector<int>(1, goal_fact));
+    task.reset(lm_cut_task);
+    // The relaxed operators are ordered by operator number.
+    for (size_t i = 1; i < relaxed_operator_starts.size(); ++i)
+        relaxed_operator_starts[i] += relaxed_operator_starts[i - 1];
+
+    for (size_t i = 0; i < g_operators.size(); ++i)
+        base_operator_costs.push_back(get_adjusted_cost(g_operators[i]));
+    base_operator_costs.push_back(0);
+    for (int op = 0; op < task->get_num_operators(); ++op) {
+        OperatorInfo info = {task->get_num_preconditions(op), -1, -1};
+        initial_operators.push_back(info);
+    }
+    FactInfo unreached = {-1, NO_ZONE};
+    facts.resize(task->get_num_facts(), unreached);
+    operators = initial_operators;
+    reduced.resize(base_operator_costs.size(), false);
+}
+
+Heuristic *LMCutHeuristic::clone() const
+{
+    // Shares the task; the scratch data is copied.
+    return new LMCutHeuristic(*this);
+}
+
+void LMCutHeuristic::enqueue_if_cheaper(int fact, int cost)
+{
+    FactInfo &info = facts[fact];
+    if (info.cost == -1 || info.cost > cost) {
+        if (info.cost == -1)
+            reached_facts.push_back(fact);
+        info.cost = cost;
+        queue.push(cost, fact);
+    }
+}
+
+/*
+  Only the facts and relaxed operators reached by the previous call can
+  differ from their initial values (the incremental explorations never
+  reach new ones), so only they are reset.
+*/
+void LMCutHeuristic::first_exploration()
+{
+    for (int fact : reached_facts)
+        facts[fact].cost = -1;
+    reached_facts.clear();
+    for (int op : reached_operators)
+        operators[op] = initial_operators[op];
+    reached_operators.clear();
+    queue.clear();
+    for (int fact : state_facts)
+        enqueue_if_cheaper(fact, 0);
+    while (!queue.empty()) {
+        pair<int, int> top = queue.pop();
+        int cost = top.first;
+        int fact = top.second;
+        if (facts[fact].cost < cost)
+            continue;
+        for (int op : task->get_precondition_of(fact)) {
+            OperatorInfo &info = operators[op];
+            if (info.unsatisfied_preconditions ==
+                initial_operators[op].unsatisfied_preconditions)
+                reached_operators.push_back(op);
+            // Facts are popped in order of their cost, so the last
+            // precondition is the supporter.
+            if (--info.unsatisfied_preconditions == 0) {
+                info.supporter = fact;
+                info.supporter_cost = cost;
+                int op_cost = cost + operator_costs[task->get_operator_no(op)];
+                for (int eff : task->get_effects(op))
+                    enqueue_if_cheaper(eff, op_cost);
+            }
+        }
+    }
+}
+
+void LMCutHeuristic::update_supporter(int op)
+{
+    OperatorInfo &info = operators[op];
+    RelaxedTask::IdRange pre = task->get_preconditions(op);
+    info.supporter = *pre.begin();
+    info.supporter_cost = facts[info.supporter].cost;
+    for (int fact : pre) {
+        if (facts[fact].cost > info.supporter_cost) {
+            info.supporter = fact;
+            info.supporter_cost = facts[fact].cost;
+        }
+    }
 }
 
-int LMCutHeuristic::compute_heuristic(const State &/*state*/)
+/*
+  Propagates the cost reductions of the operators in reduced_operator_nos.
+  Costs only decrease, so only the relaxed operators whose supporter gets
+  cheaper have to be looked at.
+*/
+void LMCutHeuristic::incremental_exploration()
 {
-    // TODO implementation
-    return -1;
+    queue.clear();
+    for (int op_no : reduced_operator_nos) {
+        for (int op = relaxed_operator_starts[op_no];
+             op < relaxed_operator_starts[op_no + 1]; ++op) {
+            const OperatorInfo &info = operators[op];
+            if (info.supporter == -1)
+                continue;
+            int op_cost = info.supporter_cost + operator_costs[op_no];
+            for (int eff : task->get_effects(op))
+                enqueue_if_cheaper(eff, op_cost);
+        }
+    }
+    while (!queue.empty()) {
+        pair<int, int> top = queue.pop();
+        int cost = top.first;
+        int fact = top.second;
+        if (facts[fact].cost < cost)
+            continue;
+        for (int op : task->get_precondition_of(fact)) {
+            OperatorInfo &info = operators[op];
+            if (info.supporter != fact || info.supporter_cost <= cost)
+                continue;
+            int old_supporter_cost = info.supporter_cost;
+            update_supporter(op);
+            if (info.supporter_cost != old_supporter_cost) {
+                int op_cost = info.supporter_cost +
+                              operator_costs[task->get_operator_no(op)];
+                for (int eff : task->get_effects(op))
+                    enqueue_if_cheaper(eff, op_cost);
+            }
+        }
+    }
+}
+
+void LMCutHeuristic::mark_goal_plateau()
+{
+    facts[goal_fact].zone = GOAL_ZONE;
+    zone_facts.push_back(goal_fact);
+    stack.assign(1, goal_fact);
+    while (!stack.empty()) {
+        int fact = stack.back();
+        stack.pop_back();
+        for (int op : task->get_achievers(fact)) {
+            int supporter = operators[op].supporter;
+            if (supporter != -1 &&
+                operator_costs[task->get_operator_no(op)] == 0 &&
+                facts[supporter].zone != GOAL_ZONE) {
+                facts[supporter].zone = GOAL_ZONE;
+                zone_facts.push_back(supporter);
+                stack.push_back(supporter);
+            }
+        }
+    }
+}
+
+void LMCutHeuristic::find_cut()
+{
+    stack.clear();
+    for (int fact : state_facts) {
+        assert(facts[fact].zone == NO_ZONE);
+        facts[fact].zone = BEFORE_GOAL_ZONE;
+        zone_facts.push_back(fact);
+        stack.push_back(fact);
+    }
+    while (!stack.empty()) {
+        int fact = stack.back();
+        stack.pop_back();
+        for (int op : task->get_precondition_of(fact)) {
+            if (operators[op].supporter != fact)
+                continue;
+            bool reaches_goal_zone = false;
+            for (int eff : task->get_effects(op)) {
+                if (facts[eff].zone == GOAL_ZONE) {
+                    reaches_goal_zone = true;
+                    break;
+                }
+            }
+            if (reaches_goal_zone) {
+                cut.push_back(op);
+                continue;
+            }
+            for (int eff : task->get_effects(op)) {
+                if (facts[eff].zone == NO_ZONE) {
+                    facts[eff].zone = BEFORE_GOAL_ZONE;
+                    zone_facts.push_back(eff);
+                    stack.push_back(eff);
+                }
+            }
+        }
+    }
+}
+
+int LMCutHeuristic::compute_heuristic(const State &state)
+{
+    state_facts.clear();
+    for (size_t var = 0; var < g_variable_domain.size(); ++var)
+        state_facts.push_back(relaxed_task->get_fact_id(var, state[var]));
+    state_facts.push_back(init_fact);
+    operator_costs = base_operator_costs;
+
+    first_exploration();
+    if (facts[goal_fact].cost == -1)
+        return DEAD_END;
+
+    int total_cost = 0;
+    while (facts[goal_fact].cost != 0) {
+        mark_goal_plateau();
+        find_cut();
+        // Operators of cost 0 into the goal zone belong to the plateau.
+        assert(!cut.empty());
+        int cut_cost = numeric_limits<int>::max();
+        for (int op : cut) {
+            int op_no = task->get_operator_no(op);
+            cut_cost = min(cut_cost, operator_costs[op_no]);
+            if (!reduced[op_no]) {
+                reduced[op_no] = true;
+                reduced_operator_nos.push_back(op_no);
+            }
+        }
+        assert(cut_cost > 0);
+        for (int op_no : reduced_operator_nos)
+            operator_costs[op_no] -= cut_cost;
+        total_cost += cut_cost;
+
+        incremental_exploration();
+
+        for (int fact : zone_facts)
+            facts[fact].zone = NO_ZONE;
+        zone_facts.clear();
+        for (int op_no : reduced_operator_nos)
+            reduced[op_no] = false;
+        reduced_operator_nos.clear();
+        cut.clear();
+    }
+    return total_cost;
 }
 
 static Heuristic *_parse(OptionParser &parser)
@@ -2,6 +2,11 @@
 #define LM_CUT_HEURISTIC_H
 
 #include "../heuristic.h"
+#include "../priority_queue.h"
+#include "relaxed_task.h"
+
+#include <memory>
+#include <vector>
 
 // Usage example: the command line option for using the LM-cut heuristic in astar is
 // ./fast-downward.py [path-to-PDDL-problem-file] --search "wastar(lmcut())"
@@ -16,11 +21,86 @@
 // support action costs 0 and 1! (It is up to you to reuse/adapt the code
 // in max_heuristic.h, or to (re-)implement h^{max} from scratch.)
 
+/*
+  LM-cut (Helmert & Domshlak, 2009) on the relaxed task (see
+  relaxed_task.h), following the implementation of Fast Downward.
+
+  The heuristic works on a copy of the relaxed task with an artificial
+  fact that is true in all states (the precondition of the operators
+  without preconditions) and an artificial goal operator with cost 0 from
+  the goal facts to an artificial goal fact. It is built once and shared
+  by all clones.
+
+  A state is evaluated in rounds. The first h^max exploration (Dijkstra
+  with a radix queue) records for each relaxed operator a precondition
+  choice pointer, its supporter, i.e., the precondition popped last. Each
+  round collects the goal zone, the facts from which the artificial goal
+  is reached with operators of cost 0 in the justification graph, and
+  then searches the justification graph from the state facts with an
+  explicit stack without entering the goal zone. The operators that
+  enter it form the cut, a disjunctive action landmark. The minimum cost
+  of the cut is added to the heuristic value and subtracted from the
+  costs of its operators in place, and an incremental h^max exploration
+  propagates the cheaper effects, updating the supporters of the
+  operators whose supporter got cheaper. The rounds end when the h^max
+  value of the goal is 0.
+
+  The relaxed operators of the conditional effects of an operator share
+  its cost, so a cut through one of them reduces the costs of all, which
+  keeps the heuristic admissible.
+*/
 class LMCutHeuristic : public Heuristic
 {
+    enum Zone {NO_ZONE, GOAL_ZONE, BEFORE_GOAL_ZONE};
+    struct FactInfo {
+        int cost;
+        int zone;
+    };
+    struct OperatorInfo {
+        int unsatisfied_preconditions;
+        // -1 if the relaxed operator is not reached.
+        int supporter;
+        int supporter_cost;
+    };
+
+    const RelaxedTask *relaxed_task;
+    // Relaxed task with the artificial facts and the goal operator, whose
+    // operator number is g_operators.size().
+    std::shared_ptr<const RelaxedTask> task;
+    int init_fact;
+    int goal_fact;
+    std::vector<int> base_operator_costs;
+    std::vector<OperatorInfo> initial_operators;
+    // Relaxed operators of operator i are the ones from
+    // relaxed_operator_starts[i] to relaxed_operator_starts[i + 1] - 1.
+    std::vector<int> relaxed_operator_starts;
+
+    // Scratch data of compute_heuristic. Costs are indexed by operator
+    // number, the other data by fact and relaxed operator.
+    std::vector<int> operator_costs;
+    std::vector<FactInfo> facts;
+    std::vector<OperatorInfo> operators;
+    // Facts and relaxed operators reached by the last first exploration.
+    std::vector<int> reached_facts;
+    std::vector<int> reached_operators;
+    RadixQueue<int> queue;
+    std::vector<int> state_facts;
+    std::vector<int> stack;
+    std::vector<int> zone_facts;
+    std::vector<int> cut;
+    std::vector<bool> reduced;
+    std::vector<int> reduced_operator_nos;
+
+    void enqueue_if_cheaper(int fact, int cost);
+    void first_exploration();
+    void update_supporter(int op);
+    void incremental_exploration();
+    void mark_goal_plateau();
+    void find_cut();
 protected:
     virtual void initialize();
     virtual int compute_heuristic(const State &state);
+    virtual Heuristic *clone() const;
 public:
     LMCutHeuristic(const Options &options);
     ~LMCutHeuristic() = default;
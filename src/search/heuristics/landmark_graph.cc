@@ -0,0 +1,399 @@
+#include "landmark_graph.h"
+
+#include "../globals.h"
+#include "../state.h"
+#include "pm_compilation.h"
+
+#include <algorithm>
+#include <cassert>
+#include <deque>
+#include <iostream>
+#include <iterator>
+#include <memory>
+
+using namespace std;
+
+bool LandmarkGraph::Landmark::is_true_in_state(const State &state) const {
+    for (const pair<int, int> &fact : facts) {
+        bool holds = state[fact.first] == fact.second;
+        if (holds && disjunctive)
+            return true;
+        if (!holds && !disjunctive)
+            return false;
+    }
+    return !disjunctive;
+}
+
+LandmarkGraph::LandmarkGraph(const RelaxedTask &relaxed_task_)
+    : relaxed_task(relaxed_task_),
+      simple_landmarks(relaxed_task.get_num_facts(), -1),
+      num_orderings(0) {
+}
+
+int LandmarkGraph::add_landmark(const vector<int> &facts, bool disjunctive,
+                                bool &is_new) {
+    assert(!facts.empty());
+    disjunctive = disjunctive && facts.size() > 1;
+    vector<pair<int, int>> var_values;
+    for (int fact : facts) {
+        var_values.push_back(make_pair(relaxed_task.get_fact_var(fact),
+                                       relaxed_task.get_fact_value(fact)));
+    }
+    pair<bool, vector<pair<int, int>>> key(disjunctive, var_values);
+    map<pair<bool, vector<pair<int, int>>>, int>::const_iterator it =
+        landmark_ids.find(key);
+    if (it != landmark_ids.end()) {
+        is_new = false;
+        return it->second;
+    }
+    is_new = true;
+    int id = landmarks.size();
+    landmark_ids[key] = id;
+    Landmark landmark;
+    landmark.facts = var_values;
+    landmark.disjunctive = disjunctive;
+    landmark.is_goal = false;
+    landmark.true_in_initial_state =
+        landmark.is_true_in_state(g_initial_state());
+    landmarks.push_back(landmark);
+    if (facts.size() == 1)
+        simple_landmarks[facts[0]] = id;
+    return id;
+}
+
+void LandmarkGraph::add_ordering(int from, int to, bool greedy_necessary) {
+    if (from == to)
+        return;
+    vector<int> &parents = landmarks[to].parents;
+    if (find(parents.begin(), parents.end(), from) == parents.end()) {
+        parents.push_back(from);
+        ++num_orderings;
+    }
+    vector<int> &children = landmarks[from].greedy_necessary_children;
+    if (greedy_necessary &&
+        find(children.begin(), children.end(), to) == children.end())
+        children.push_back(to);
+}
+
+void LandmarkGraph::get_initial_facts(vector<int> &facts) const {
+    const State &initial_state = g_initial_state();
+    facts.clear();
+    for (size_t var = 0; var < g_variable_domain.size(); ++var)
+        facts.push_back(relaxed_task.get_fact_id(var, initial_state[var]));
+}
+
+void LandmarkGraph::compute_reachable_facts(const vector<int> &landmark_facts,
+                                            vector<bool> &reached) const {
+    reached.assign(relaxed_task.get_num_facts(), false);
+    vector<int> unsatisfied_preconditions;
+    for (int op = 0; op < relaxed_task.get_num_operators(); ++op)
+        unsatisfied_preconditions.push_back(
+            relaxed_task.get_num_preconditions(op));
+    vector<int> queue;
+    get_initial_facts(queue);
+    for (int fact : queue)
+        reached[fact] = true;
+    // Operators achieving the landmark are never applied.
+    vector<int> applicable(relaxed_task.get_operators_without_preconditions());
+    size_t next = 0;
+    while (true) {
+        for (int op : applicable) {
+            bool achieves_landmark = false;
+            for (int eff : relaxed_task.get_effects(op)) {
+                if (find(landmark_facts.begin(), landmark_facts.end(), eff) !=
+                    landmark_facts.end())
+                    achieves_landmark = true;
+            }
+            if (achieves_landmark)
+                continue;
+            for (int eff : relaxed_task.get_effects(op)) {
+                if (!reached[eff]) {
+                    reached[eff] = true;
+                    queue.push_back(eff);
+                }
+            }
+        }
+        applicable.clear();
+        if (next == queue.size())
+            break;
+        int fact = queue[next++];
+        for (int op : relaxed_task.get_precondition_of(fact)) {
+            if (--unsatisfied_preconditions[op] == 0)
+                applicable.push_back(op);
+        }
+    }
+}
+
+void LandmarkGraph::generate_rhw_landmarks() {
+    vector<int> open;
+    for (int goal : relaxed_task.get_goal_facts()) {
+        bool is_new;
+        int id = add_landmark(vector<int>(1, goal), false, is_new);
+        landmarks[id].is_goal = true;
+        if (is_new)
+            open.push_back(id);
+    }
+
+    vector<bool> reached;
+    vector<int> landmark_facts;
+    vector<int> first_achievers;
+    vector<int> shared_preconditions;
+    vector<int> intersection;
+    vector<vector<int>> values_by_var(g_variable_domain.size());
+    vector<int> vars;
+    int num_unreachable = 0;
+    while (!open.empty()) {
+        int id = open.back();
+        open.pop_back();
+        if (landmarks[id].true_in_initial_state)
+            continue;
+        landmark_facts.clear();
+        for (const pair<int, int> &fact : landmarks[id].facts) {
+            landmark_facts.push_back(
+                relaxed_task.get_fact_id(fact.first, fact.second));
+        }
+        compute_reachable_facts(landmark_facts, reached);
+        first_achievers.clear();
+        for (int fact : landmark_facts) {
+            for (int op : relaxed_task.get_achievers(fact)) {
+                bool reachable = true;
+                for (int pre : relaxed_task.get_preconditions(op)) {
+                    if (!reached[pre]) {
+                        reachable = false;
+                        break;
+                    }
+                }
+                if (reachable)
+                    first_achievers.push_back(op);
+            }
+        }
+        sort(first_achievers.begin(), first_achievers.end());
+        first_achievers.erase(unique(first_achievers.begin(),
+                                     first_achievers.end()),
+                              first_achievers.end());
+        if (first_achievers.empty()) {
+            ++num_unreachable;
+            continue;
+        }
+
+        // Shared preconditions of the first achievers.
+        RelaxedTask::IdRange pre = relaxed_task.get_preconditions(
+            first_achievers[0]);
+        shared_preconditions.assign(pre.begin(), pre.end());
+        for (size_t i = 1; i < first_achievers.size(); ++i) {
+            pre = relaxed_task.get_preconditions(first_achievers[i]);
+            intersection.clear();
+            set_intersection(shared_preconditions.begin(),
+                             shared_preconditions.end(), pre.begin(),
+                             pre.end(), back_inserter(intersection));
+            shared_preconditions.swap(intersection);
+        }
+        for (int fact : shared_preconditions) {
+            bool is_new;
+            int pre_id = add_landmark(vector<int>(1, fact), false, is_new);
+            add_ordering(pre_id, id, true);
+            if (is_new)
+                open.push_back(pre_id);
+        }
+
+        // Disjunctions of the values of a variable that all first
+        // achievers need.
+        for (int op : first_achievers) {
+            for (int fact : relaxed_task.get_preconditions(op)) {
+                int var = relaxed_task.get_fact_var(fact);
+                if (values_by_var[var].empty())
+                    vars.push_back(var);
+                values_by_var[var].push_back(fact);
+            }
+        }
+        for (int var : vars) {
+            vector<int> &values = values_by_var[var];
+            if (values.size() == first_achievers.size()) {
+                sort(values.begin(), values.end());
+                values.erase(unique(values.begin(), values.end()),
+                             values.end());
+                bool useful = values.size() > 1 &&
+                              values.size() <= MAX_DISJUNCTION_SIZE;
+                for (size_t i = 0; i < values.size() && useful; ++i) {
+                    int value = relaxed_task.get_fact_value(values[i]);
+                    if (simple_landmarks[values[i]] != -1 ||
+                        g_initial_state()[var] == value)
+                        useful = false;
+                }
+                if (useful) {
+                    bool is_new;
+                    int disjunctive_id = add_landmark(values, true, is_new);
+                    add_ordering(disjunctive_id, id, true);
+                    if (is_new)
+                        open.push_back(disjunctive_id);
+                }
+            }
+            values.clear();
+        }
+        vars.clear();
+    }
+    if (num_unreachable > 0) {
+        cout << num_unreachable << " landmarks are unreachable in the "
+             << "relaxation" << endl;
+    }
+}
+
+void LandmarkGraph::generate_hm_landmarks(int m, size_t memory_limit) {
+    for (int goal : relaxed_task.get_goal_facts()) {
+        bool is_new;
+        int id = add_landmark(vector<int>(1, goal), false, is_new);
+        landmarks[id].is_goal = true;
+    }
+
+    PmCompilation *comp = 0;
+    for (; !comp; --m) {
+        comp = PmCompilation::build(relaxed_task, m, memory_limit);
+        if (!comp)
+            cout << "P^" << m << " compilation exceeds the memory limit" << endl;
+    }
+    unique_ptr<PmCompilation> compilation(comp);
+    const RelaxedTask &task = compilation->get_task();
+    int num_meta_facts = task.get_num_facts();
+    cout << "h^m landmarks with m = " << compilation->get_m() << endl;
+
+    /*
+      Label propagation: labels only shrink, and an operator is queued
+      again whenever the label of one of its preconditions shrinks.
+    */
+    vector<vector<int>> labels(num_meta_facts);
+    vector<bool> reached(num_meta_facts, false);
+    vector<bool> initial(num_meta_facts, false);
+    vector<int> unsatisfied_preconditions;
+    for (int op = 0; op < task.get_num_operators(); ++op)
+        unsatisfied_preconditions.push_back(task.get_num_preconditions(op));
+    vector<bool> queued(task.get_num_operators(), false);
+    deque<int> queue(task.get_operators_without_preconditions().begin(),
+                     task.get_operators_without_preconditions().end());
+    for (int op : queue)
+        queued[op] = true;
+
+    vector<int> facts;
+    get_initial_facts(facts);
+    vector<int> initial_meta_facts;
+    compilation->collect_all_meta_facts(facts, initial_meta_facts);
+    for (int meta_fact : initial_meta_facts) {
+        reached[meta_fact] = true;
+        initial[meta_fact] = true;
+        labels[meta_fact].assign(1, meta_fact);
+    }
+    for (int meta_fact : initial_meta_facts) {
+        for (int op : task.get_precondition_of(meta_fact)) {
+            if (--unsatisfied_preconditions[op] == 0) {
+                queued[op] = true;
+                queue.push_back(op);
+            }
+        }
+    }
+
+    vector<int> label;
+    vector<int> new_label;
+    vector<int> merged;
+    while (!queue.empty()) {
+        int op = queue.front();
+        queue.pop_front();
+        queued[op] = false;
+        label.clear();
+        for (int pre : task.get_preconditions(op)) {
+            merged.clear();
+            set_union(label.begin(), label.end(), labels[pre].begin(),
+                      labels[pre].end(), back_inserter(merged));
+            label.swap(merged);
+        }
+        for (int eff : task.get_effects(op)) {
+            new_label = label;
+            new_label.insert(lower_bound(new_label.begin(), new_label.end(),
+                                         eff), eff);
+            new_label.erase(unique(new_label.begin(), new_label.end()),
+                            new_label.end());
+            bool changed = false;
+            if (!reached[eff]) {
+                reached[eff] = true;
+                labels[eff].swap(new_label);
+                for (int next_op : task.get_precondition_of(eff)) {
+                    if (--unsatisfied_preconditions[next_op] == 0 &&
+                        !queued[next_op]) {
+                        queued[next_op] = true;
+                        queue.push_back(next_op);
+                    }
+                }
+            } else {
+                merged.clear();
+                set_intersection(labels[eff].begin(), labels[eff].end(),
+                                 new_label.begin(), new_label.end(),
+                                 back_inserter(merged));
+                if (merged.size() < labels[eff].size()) {
+                    labels[eff].swap(merged);
+                    changed = true;
+                }
+            }
+            if (changed) {
+                for (int next_op : task.get_precondition_of(eff)) {
+                    if (unsatisfied_preconditions[next_op] == 0 &&
+                        !queued[next_op]) {
+                        queued[next_op] = true;
+                        queue.push_back(next_op);
+                    }
+                }
+            }
+        }
+    }
+
+    const vector<int> &goal = task.get_goal_facts();
+    bool goal_reached = !compilation->is_unsolvable();
+    for (int meta_fact : goal) {
+        if (!reached[meta_fact])
+            goal_reached = false;
+    }
+    if (!goal_reached) {
+        cout << "The goal is unreachable in the relaxation" << endl;
+        return;
+    }
+
+    // Labels of the goal and the facts of conjunctive landmarks.
+    vector<bool> is_landmark(num_meta_facts, false);
+    vector<int> stack(goal.begin(), goal.end());
+    vector<int> subset(1);
+    while (!stack.empty()) {
+        int meta_fact = stack.back();
+        stack.pop_back();
+        if (is_landmark[meta_fact])
+            continue;
+        is_landmark[meta_fact] = true;
+        stack.insert(stack.end(), labels[meta_fact].begin(),
+                     labels[meta_fact].end());
+        compilation->get_facts(meta_fact, facts);
+        if (facts.size() > 1) {
+            for (int fact : facts) {
+                subset[0] = fact;
+                stack.push_back(compilation->get_meta_fact_id(subset));
+            }
+        }
+    }
+
+    // Landmarks true in the initial state are only kept for the goal.
+    vector<int> landmark_of_meta_fact(num_meta_facts, -1);
+    for (int meta_fact = 0; meta_fact < num_meta_facts; ++meta_fact) {
+        if (!is_landmark[meta_fact])
+            continue;
+        compilation->get_facts(meta_fact, facts);
+        if (initial[meta_fact] &&
+            !(facts.size() == 1 && relaxed_task.is_goal_fact(facts[0])))
+            continue;
+        bool is_new;
+        landmark_of_meta_fact[meta_fact] = add_landmark(facts, false, is_new);
+    }
+    for (int meta_fact = 0; meta_fact < num_meta_facts; ++meta_fact) {
+        int id = landmark_of_meta_fact[meta_fact];
+        if (id == -1)
+            continue;
+        for (int before : labels[meta_fact]) {
+            if (landmark_of_meta_fact[before] != -1)
+                add_ordering(landmark_of_meta_fact[before], id, false);
+        }
+    }
+}
@@ -0,0 +1,94 @@
+#ifndef HEURISTICS_LANDMARK_GRAPH_H
+#define HEURISTICS_LANDMARK_GRAPH_H
+
+#include "relaxed_task.h"
+
+#include <cstddef>
+#include <map>
+#include <utility>
+#include <vector>
+
+class State;
+
+/*
+  Fact landmarks of the task and orderings between them, for the landmark
+  count heuristic. A landmark is a fact, a disjunction of facts that must
+  hold at some point of every plan, or a conjunction of facts that must
+  hold together at some point of every plan. Two generators are
+  available; both work on the relaxed task, so all landmarks are
+  landmarks of the delete relaxation.
+
+  RHW landmarks (Richter, Helmert & Westphal, 2008) are found by
+  backchaining from the goals. The first achievers of a landmark L are
+  the relaxed operators achieving L whose preconditions can be reached
+  without achieving L. Their shared preconditions are landmarks that are
+  greedy-necessarily ordered before L, and for a variable on which all of
+  them have a precondition, the set of values they need (at most
+  MAX_DISJUNCTION_SIZE) is a disjunctive landmark. RHW groups the
+  preconditions by predicate; variables play that role here. Landmarks
+  true in the initial state are kept but not backchained from.
+
+  h^m landmarks (Keyder, Richter & Helmert, 2010) are computed by label
+  propagation on the P^m compilation (see pm_compilation.h): the label of
+  a meta-fact is the set of meta-facts that every relaxed path from the
+  initial state to it achieves, and the labels of the goal meta-facts
+  together with the facts of conjunctive landmarks are the landmarks. A
+  meta-fact in the label of another is naturally ordered before it. For
+  m = 1, these are all fact landmarks of the delete relaxation.
+*/
+class LandmarkGraph {
+public:
+    struct Landmark {
+        // Facts (var, value) sorted by variable.
+        std::vector<std::pair<int, int>> facts;
+        // Several facts form a disjunction if this is true and a
+        // conjunction otherwise.
+        bool disjunctive;
+        bool is_goal;
+        bool true_in_initial_state;
+        // Landmarks ordered before this one.
+        std::vector<int> parents;
+        // Landmarks that this one must hold right before when they are
+        // first achieved (greedy-necessary orderings).
+        std::vector<int> greedy_necessary_children;
+
+        bool is_true_in_state(const State &state) const;
+    };
+    static const size_t MAX_DISJUNCTION_SIZE = 4;
+private:
+    const RelaxedTask &relaxed_task;
+    std::vector<Landmark> landmarks;
+    std::map<std::pair<bool, std::vector<std::pair<int, int>>>, int>
+    landmark_ids;
+    // Simple landmark of each fact of the relaxed task, or -1.
+    std::vector<int> simple_landmarks;
+    int num_orderings;
+
+    // Facts are IDs of the relaxed task.
+    int add_landmark(const std::vector<int> &facts, bool disjunctive,
+                     bool &is_new);
+    void add_ordering(int from, int to, bool greedy_necessary);
+    void get_initial_facts(std::vector<int> &facts) const;
+    // Facts reachable from the initial state without achieving a fact of
+    // the landmark.
+    void compute_reachable_facts(const std::vector<int> &landmark_facts,
+                                 std::vector<bool> &reached) const;
+public:
+    explicit LandmarkGraph(const RelaxedTask &relaxed_task);
+
+    void generate_rhw_landmarks();
+    // Reduces m until the compilation fits into the memory limit (bytes).
+    void generate_hm_landmarks(int m, size_t memory_limit);
+
+    int get_num_landmarks() const {
+        return landmarks.size();
+    }
+    const Landmark &get_landmark(int id) const {
+        return landmarks[id];
+    }
+    int get_num_orderings() const {
+        return num_orderings;
+    }
+};
+
+#endif
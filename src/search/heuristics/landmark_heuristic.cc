@@ -5,43 +5,272 @@
 #include "../option_parser.h"
 #include "../plugin.h"
 #include "../state.h"
+#include "../successor_generator.h"
+#include "../timer.h"
 
+#include <cmath>
+#include <limits>
 
 using namespace std;
 
+// Memory limit of the P^m compilation of the h^m landmarks.
+static const size_t HM_MEMORY_LIMIT = size_t(1) << 30;
+
 LandmarkHeuristic::LandmarkHeuristic(const Options &opts)
-    : Heuristic(opts)
+    : Heuristic(opts),
+      generator(LandmarkGenerator(opts.get_enum("landmarks"))),
+      m(opts.get<int>("m")),
+      admissible(opts.get<bool>("admissible")),
+      num_words(0)
 {
 }
 
 void LandmarkHeuristic::initialize()
 {
     cout << "Initializing landmark heuristic..." << endl;
+    Timer timer;
+    landmark_graph.reset(new LandmarkGraph(get_relaxed_task()));
+    if (generator == RHW) {
+        landmark_graph->generate_rhw_landmarks();
+    } else {
+        landmark_graph->generate_hm_landmarks(m, HM_MEMORY_LIMIT);
+    }
+    int num_landmarks = landmark_graph->get_num_landmarks();
+    int num_disjunctive = 0;
+    int num_conjunctive = 0;
+
+    landmarks_by_fact.resize(g_variable_domain.size());
+    for (size_t var = 0; var < g_variable_domain.size(); ++var) {
+        landmarks_by_fact[var].resize(g_variable_domain[var]);
+    }
+    for (int id = 0; id < num_landmarks; ++id) {
+        const LandmarkGraph::Landmark &landmark =
+            landmark_graph->get_landmark(id);
+        if (landmark.facts.size() > 1) {
+            if (landmark.disjunctive) {
+                ++num_disjunctive;
+            } else {
+                ++num_conjunctive;
+            }
+        }
+        for (const pair<int, int> &fact : landmark.facts) {
+            landmarks_by_fact[fact.first][fact.second].push_back(id);
+        }
+    }
+
+    // Achievers: operators with an effect on a fact of the landmark.
+    achievers.resize(num_landmarks);
+    min_achiever_costs.assign(num_landmarks, numeric_limits<int>::max());
+    for (size_t op_no = 0; op_no < g_operators.size(); ++op_no) {
+        const Operator &op = g_operators[op_no];
+        for (const Effect &eff : op.get_effects()) {
+            for (int id : landmarks_by_fact[eff.var][eff.val]) {
+                if (achievers[id].empty() || achievers[id].back() != int(op_no)) {
+                    achievers[id].push_back(op_no);
+                    min_achiever_costs[id] = min(min_achiever_costs[id],
+                                                 get_adjusted_cost(op));
+                }
+            }
+        }
+    }
+
+    num_words = (num_landmarks + 63) / 64;
+    num_required_achieved.resize(g_operators.size(), 0);
+    operator_marked.resize(g_operators.size(), false);
+    cout << "Landmarks: " << num_landmarks << " (" << num_disjunctive
+         << " disjunctive, " << num_conjunctive << " conjunctive), "
+         << landmark_graph->get_num_orderings() << " orderings" << endl;
+    cout << "Landmark generation time: " << timer << endl;
+    cout << "Accepted landmarks per state: " << num_words << " words ("
+         << num_words * sizeof(uint64_t) + sizeof(vector<uint64_t>)
+         << " bytes)" << endl;
 }
 
-int LandmarkHeuristic::compute_heuristic(const State &/*state*/)
+void LandmarkHeuristic::accept_true_landmarks(const State &state,
+                                              vector<uint64_t> &bits) const
 {
-    // TODO implementation
-    return -1;
+    bits.assign(num_words, 0);
+    for (int id = 0; id < landmark_graph->get_num_landmarks(); ++id) {
+        if (landmark_graph->get_landmark(id).is_true_in_state(state)) {
+            accept(bits, id);
+        }
+    }
 }
 
-void LandmarkHeuristic::reach_state(const State &/*parent_state*/,
-                                    const Operator &/*op*/,
-                                    const State &/*state*/)
+const vector<uint64_t> &LandmarkHeuristic::get_accepted_landmarks(
+    const State &state)
 {
-    // TODO implementation
+    if (state.get_id() == StateID::no_state) {
+        accept_true_landmarks(state, unregistered_accepted);
+        return unregistered_accepted;
+    }
+    vector<uint64_t> &bits = accepted_landmarks[state];
+    if (bits.empty()) {
+        accept_true_landmarks(state, bits);
+    }
+    return bits;
 }
 
-void LandmarkHeuristic::get_helpful_actions(std::vector<const Operator *>
-        &/*result*/)
+int LandmarkHeuristic::compute_heuristic(const State &state)
 {
-    // TODO implementation
+    const vector<uint64_t> &bits = get_accepted_landmarks(state);
+
+    required_landmarks.clear();
+    for (int id = 0; id < landmark_graph->get_num_landmarks(); ++id) {
+        const LandmarkGraph::Landmark &landmark =
+            landmark_graph->get_landmark(id);
+        bool required = !is_accepted(bits, id);
+        if (!required && !landmark.is_true_in_state(state)) {
+            required = landmark.is_goal;
+            for (int child : landmark.greedy_necessary_children) {
+                if (!is_accepted(bits, child)) {
+                    required = true;
+                    break;
+                }
+            }
+        }
+        if (required) {
+            if (achievers[id].empty() && !landmark.is_true_in_state(state)) {
+                return DEAD_END;
+            }
+            required_landmarks.push_back(id);
+        }
+    }
+
+    compute_helpful_actions(state, bits);
+
+    if (!admissible) {
+        int h = 0;
+        for (int id : required_landmarks) {
+            h += min_achiever_costs[id];
+        }
+        return h;
+    }
+
+    // Uniform cost partitioning among the required landmarks.
+    for (int id : required_landmarks) {
+        for (int op_no : achievers[id]) {
+            ++num_required_achieved[op_no];
+        }
+    }
+    double h = 0;
+    for (int id : required_landmarks) {
+        double cost = numeric_limits<double>::max();
+        for (int op_no : achievers[id]) {
+            double share = double(get_adjusted_cost(g_operators[op_no])) /
+                           num_required_achieved[op_no];
+            cost = min(cost, share);
+        }
+        if (!achievers[id].empty()) {
+            h += cost;
+        }
+    }
+    for (int id : required_landmarks) {
+        for (int op_no : achievers[id]) {
+            num_required_achieved[op_no] = 0;
+        }
+    }
+    // Rounding errors must not make the value inadmissible.
+    return int(ceil(h - 0.01));
+}
+
+void LandmarkHeuristic::compute_helpful_actions(const State &state,
+                                                const vector<uint64_t> &bits)
+{
+    helpful_actions.clear();
+    // First the landmarks whose parents are all accepted.
+    for (int pass = 0; pass < 2 && helpful_actions.empty(); ++pass) {
+        for (int id : required_landmarks) {
+            const LandmarkGraph::Landmark &landmark =
+                landmark_graph->get_landmark(id);
+            if (landmark.is_true_in_state(state)) {
+                continue;
+            }
+            bool parents_accepted = true;
+            for (int parent : landmark.parents) {
+                if (!is_accepted(bits, parent)) {
+                    parents_accepted = false;
+                    break;
+                }
+            }
+            if (pass == 0 && !parents_accepted) {
+                continue;
+            }
+            for (int op_no : achievers[id]) {
+                const Operator &op = g_operators[op_no];
+                if (!operator_marked[op_no] && op.is_applicable(state)) {
+                    operator_marked[op_no] = true;
+                    helpful_actions.push_back(&op);
+                }
+            }
+        }
+    }
+    for (const Operator *op : helpful_actions) {
+        operator_marked[op - &g_operators[0]] = false;
+    }
+}
+
+void LandmarkHeuristic::reach_state(const State &parent_state,
+                                    const Operator &op,
+                                    const State &state)
+{
+    // Nothing is stored for unregistered states.
+    if (!landmark_graph || state.get_id() == StateID::no_state) {
+        return;
+    }
+    new_accepted = get_accepted_landmarks(parent_state);
+    // Landmarks that become true must contain a fact added by op.
+    for (const Effect &eff : op.get_effects()) {
+        if (state[eff.var] != eff.val || parent_state[eff.var] == eff.val) {
+            continue;
+        }
+        for (int id : landmarks_by_fact[eff.var][eff.val]) {
+            if (landmark_graph->get_landmark(id).is_true_in_state(state)) {
+                accept(new_accepted, id);
+            }
+        }
+    }
+    vector<uint64_t> &bits = accepted_landmarks[state];
+    if (bits.empty()) {
+        bits.swap(new_accepted);
+    } else {
+        for (int i = 0; i < num_words; ++i) {
+            bits[i] &= new_accepted[i];
+        }
+    }
+}
+
+void LandmarkHeuristic::add_helpful_actions(std::vector<const Operator *>
+        &result)
+{
+    result.insert(result.end(), helpful_actions.begin(),
+                  helpful_actions.end());
 }
 
 static Heuristic *_parse(OptionParser &parser)
 {
+    parser.document_synopsis(
+        "Landmark count heuristic",
+        "Counts the landmarks that are not accepted or required again. The "
+        "value depends on the path to a state, so estimates are not cached.");
     Heuristic::add_options_to_parser(parser);
+    vector<string> generators;
+    generators.push_back("RHW");
+    generators.push_back("HM");
+    parser.add_enum_option(
+        "landmarks", generators,
+        "landmark generation: backchaining from the goals (RHW) or h^m "
+        "landmarks (HM)", "RHW");
+    parser.add_option<int>(
+        "m", "size of the fact sets of the h^m landmarks (1 to 4)", "2");
+    parser.add_option<bool>(
+        "admissible",
+        "partition the operator costs uniformly among the landmarks", "false");
     Options opts = parser.parse();
+    if (opts.get<int>("m") < 1 || opts.get<int>("m") > 4) {
+        parser.error("m must be between 1 and 4");
+    }
+    opts.set<bool>("cache_estimates", false);
     if (parser.dry_run()) {
         return 0;
     } else {
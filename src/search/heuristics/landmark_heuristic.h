@@ -2,6 +2,12 @@
 #define LANDMARK_HEURISTIC_H
 
 #include "../heuristic.h"
+#include "../per_state_information.h"
+#include "landmark_graph.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
 
 // Usage example: the command line option for using the LM count heuristic in astar is
 // ./fast-downward.py [path-to-PDDL-problem-file] --search "wastar(lm())" Obviously,
@@ -35,17 +41,83 @@
 // enough to get full points. But we will give bonus points for more sophisticated
 // strategies.
 
+/*
+  Landmark count heuristic (LAMA, Richter & Westphal, 2010) on the
+  landmarks of landmark_graph.h, generated once for the initial state.
+
+  The accepted landmarks of each state are stored as a packed bitset in a
+  PerStateInformation. A landmark is accepted in a state if it held in
+  some state on the path to it: the successor of a state gets the bitset
+  of its parent plus the landmarks that become true through the effects
+  of the operator, so reach_state() takes O(|landmarks| / 64) time plus
+  the landmarks of the added facts. If a state is reached again on
+  another path, its bitset is intersected with the new one. States
+  without a bitset (the initial state) accept the landmarks that are true
+  in them.
+
+  A landmark is required in a state if it is not accepted, or if it is
+  accepted but false and it is a goal or greedy-necessarily ordered
+  before a landmark that is not accepted. The inadmissible value is the
+  sum of the minimum achiever costs of the required landmarks. With
+  admissible=true, the cost of each operator is partitioned uniformly
+  among the required landmarks it achieves (Karpas & Domshlak, 2009),
+  which is admissible with both landmark generators; use the h^m
+  landmarks for optimal planning. The preferred operators are the
+  applicable achievers of required landmarks whose parents are all
+  accepted, or of all required landmarks if there are none.
+
+  The value of a state depends on the path to it, so estimates are never
+  cached. Unregistered states (e.g. of IDA* or beam search) have no path
+  information; only the landmarks that are true in them are accepted.
+*/
 class LandmarkHeuristic : public Heuristic
 {
+    enum LandmarkGenerator {RHW, HM};
+    LandmarkGenerator generator;
+    int m;
+    bool admissible;
+    std::unique_ptr<LandmarkGraph> landmark_graph;
+    // Operator numbers of the achievers of each landmark and their
+    // minimum cost.
+    std::vector<std::vector<int>> achievers;
+    std::vector<int> min_achiever_costs;
+    // Landmarks that contain each fact, indexed by variable and value.
+    std::vector<std::vector<std::vector<int>>> landmarks_by_fact;
+    int num_words;
+    PerStateInformation<std::vector<uint64_t>> accepted_landmarks;
+
+    // Scratch data.
+    std::vector<uint64_t> new_accepted;
+    std::vector<uint64_t> unregistered_accepted;
+    std::vector<int> required_landmarks;
+    std::vector<int> num_required_achieved;
+    std::vector<bool> operator_marked;
+    std::vector<const Operator *> helpful_actions;
+
+    static bool is_accepted(const std::vector<uint64_t> &bits, int id) {
+        return (bits[id / 64] >> (id % 64)) & 1;
+    }
+    static void accept(std::vector<uint64_t> &bits, int id) {
+        bits[id / 64] |= uint64_t(1) << (id % 64);
+    }
+    void accept_true_landmarks(const State &state,
+                               std::vector<uint64_t> &bits) const;
+    // Initializes the accepted landmarks of states that are reached first.
+    const std::vector<uint64_t> &get_accepted_landmarks(const State &state);
+    void compute_helpful_actions(const State &state,
+                                 const std::vector<uint64_t> &bits);
 protected:
     virtual void initialize();
     virtual int compute_heuristic(const State &state);
+    virtual void add_helpful_actions(std::vector<const Operator *> &result);
 public:
     LandmarkHeuristic(const Options &options);
     ~LandmarkHeuristic() = default;
     virtual void reach_state(const State &parent_state, const Operator &op,
                              const State &state);
-    virtual void get_helpful_actions(std::vector<const Operator *> &result);
+    virtual bool is_path_dependent() const {
+        return true;
+    }
 };
 
 #endif
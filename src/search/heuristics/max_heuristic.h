@@ -2,11 +2,9 @@
 #define MAX_HEURISTIC_H
 
 #include "../heuristic.h"
+#include "bit_parallel_exploration.h"
+#include "relaxed_exploration.h"
 #include <vector>
-#include <unordered_set>
-#include <unordered_map>
-#include <queue>
-#include "../operator.h"
 
 // Usage example: the command line option for using the h^{max} heuristic in astar is
 // ./fast-downward.py [path-to-PDDL-problem-file] --search "wastar(hmax())"
@@ -28,27 +26,26 @@ class MaxHeuristic : public Heuristic
 protected:
     virtual void initialize();
     virtual int compute_heuristic(const State& state);
+    virtual void compute_heuristic_batch(const std::vector<State> &states,
+                                         std::vector<int> &values);
+    virtual Heuristic *clone() const;
+    virtual void reach_state(const State &parent_state, const Operator &op,
+                             const State &state);
+    virtual bool supports_batch_evaluation() const;
 
 public:
     MaxHeuristic(const Options& options);
     ~MaxHeuristic() = default;
 private:
-    std::vector<int> hash_arr;
-    int compute_hash(std::pair<int, int>& x);
-    void init_layers_and_counter(const State& state);
-    void achieve_facts(int& pos);
-    void small_iteration();
-    bool doStep();
-    void queue_clear(std::queue<std::pair<int, int>>& q);
-    std::vector<int> counter;
-    std::queue <std::pair<int, int>> fact_schedule;
-    int timestep;
-    int req_goal;
-    std::vector <std::pair<int, std::unordered_set<int>>> fact_set;
-
-
-    std::vector <int> goal_set;
-
+    bool incremental;
+    // Scratch data; shares the relaxed task with all other heuristics.
+    RelaxedExploration exploration;
+    // Cost of all operators, or -1 if the costs differ.
+    int uniform_cost;
+    // Used for batches of at least MIN_BATCH_SIZE states if the costs are
+    // uniform.
+    static const size_t MIN_BATCH_SIZE = 8;
+    BitParallelExploration batch_exploration;
 };
 
 #endif
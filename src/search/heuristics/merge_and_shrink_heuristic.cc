@@ -1,34 +1,435 @@
 #include "merge_and_shrink_heuristic.h"
 
+#include "../countdown_timer.h"
 #include "../globals.h"
 #include "../operator.h"
 #include "../option_parser.h"
 #include "../plugin.h"
+#include "../rng.h"
 #include "../state.h"
+#include "../timer.h"
 
+#include <cmath>
+#include <cstdint>
+#include <limits>
 
 using namespace std;
 
+static const int INF = FactoredTransitionSystem::INF;
+
 MASHeuristic::MASHeuristic(const Options &opts)
-    : Heuristic(opts)
+    : Heuristic(opts),
+      merge_strategy(MergeStrategy(opts.get_enum("merge_strategy"))),
+      max_states(opts.get<int>("max_states")),
+      label_reduction(opts.get<bool>("label_reduction")),
+      max_time(opts.get<double>("max_time")),
+      unsolvable(false)
+{
+}
+
+void MASHeuristic::compute_linear_order()
+{
+    int num_vars = g_variable_domain.size();
+    // Causal graph predecessors: variables that occur in a condition or an
+    // effect of an operator with an effect on the variable.
+    vector<vector<int>> predecessors(num_vars);
+    for (const Operator &op : g_operators) {
+        for (const Effect &eff : op.get_effects()) {
+            for (const Condition &cond : op.get_preconditions())
+                predecessors[eff.var].push_back(cond.var);
+            for (const Condition &cond : eff.conditions)
+                predecessors[eff.var].push_back(cond.var);
+            for (const Effect &other : op.get_effects())
+                predecessors[eff.var].push_back(other.var);
+        }
+    }
+    vector<bool> is_goal(num_vars, false);
+    for (const pair<int, int> &goal : g_goal)
+        is_goal[goal.first] = true;
+
+    vector<bool> merged(num_vars, false);
+    vector<bool> is_predecessor(num_vars, false);
+    linear_order.clear();
+    for (int i = 0; i < num_vars; ++i) {
+        int best = -1;
+        for (int var = num_vars - 1; var >= 0; --var) {
+            if (merged[var])
+                continue;
+            if (best == -1 ||
+                make_pair(is_predecessor[var], is_goal[var]) >
+                make_pair(is_predecessor[best], is_goal[best]))
+                best = var;
+        }
+        merged[best] = true;
+        linear_order.push_back(best);
+        for (int var : predecessors[best])
+            is_predecessor[var] = true;
+    }
+}
+
+pair<int, int> MASHeuristic::select_linear(int composite, int num_merges) const
+{
+    if (composite == -1)
+        return make_pair(linear_order[0], linear_order[1]);
+    // The atomic factor of a variable has the number of the variable.
+    return make_pair(composite, linear_order[num_merges + 1]);
+}
+
+pair<int, int> MASHeuristic::select_dfp(const FactoredTransitionSystem &fts) const
+{
+    vector<int> active;
+    for (int index = 0; index < fts.get_num_factors(); ++index) {
+        if (fts.is_active(index))
+            active.push_back(index);
+    }
+    // Rank of each label in each factor, -1 for irrelevant labels.
+    int num_labels = fts.get_num_labels();
+    vector<vector<int>> ranks(active.size(), vector<int>(num_labels, -1));
+    vector<vector<int>> relevant_labels(active.size());
+    for (size_t i = 0; i < active.size(); ++i) {
+        const FactoredTransitionSystem::Factor &factor =
+            fts.get_factor(active[i]);
+        for (const FactoredTransitionSystem::LabelGroup &group : factor.groups) {
+            bool irrelevant =
+                static_cast<int>(group.transitions.size()) == factor.num_states;
+            int rank = INF;
+            for (const Transition &transition : group.transitions) {
+                if (transition.src != transition.target)
+                    irrelevant = false;
+                rank = min(rank, factor.goal_distances[transition.target]);
+            }
+            if (irrelevant)
+                continue;
+            for (int label : group.labels) {
+                if (fts.is_active_label(label)) {
+                    ranks[i][label] = rank;
+                    relevant_labels[i].push_back(label);
+                }
+            }
+        }
+    }
+
+    pair<int, int> best_pair(-1, -1);
+    int best_score = INF;
+    for (size_t i = 0; i < active.size(); ++i) {
+        for (size_t j = i + 1; j < active.size(); ++j) {
+            int score = INF;
+            for (int label : relevant_labels[i]) {
+                if (ranks[j][label] != -1)
+                    score = min(score, max(ranks[i][label], ranks[j][label]));
+            }
+            if (score < best_score) {
+                best_score = score;
+                best_pair = make_pair(active[i], active[j]);
+            }
+        }
+    }
+    if (best_pair.first != -1)
+        return best_pair;
+    // No pair synchronizes on a relevant label: prefer goal variables.
+    for (size_t i = 0; i < active.size(); ++i) {
+        if (!fts.get_factor(active[i]).is_goal_relevant())
+            continue;
+        for (size_t j = i + 1; j < active.size(); ++j) {
+            if (fts.get_factor(active[j]).is_goal_relevant())
+                return make_pair(active[i], active[j]);
+        }
+    }
+    return make_pair(active[0], active[1]);
+}
+
+int MASHeuristic::compute_bisimulation(
+    const FactoredTransitionSystem::Factor &factor, int max_size,
+    vector<int> &abstraction) const
+{
+    int num_states = factor.num_states;
+    // Outgoing transitions (group, target) of each state.
+    vector<int> starts(num_states + 1, 0);
+    for (const FactoredTransitionSystem::LabelGroup &group : factor.groups) {
+        for (const Transition &transition : group.transitions)
+            ++starts[transition.src + 1];
+    }
+    for (int state = 0; state < num_states; ++state)
+        starts[state + 1] += starts[state];
+    vector<pair<int, int>> successors(starts.back());
+    vector<int> pos(starts.begin(), starts.end() - 1);
+    for (size_t group = 0; group < factor.groups.size(); ++group) {
+        for (const Transition &transition : factor.groups[group].transitions)
+            successors[pos[transition.src]++] = make_pair(group, transition.target);
+    }
+
+    // Initial partition by goal distance and goal status, in increasing
+    // order of goal distance.
+    vector<pair<int, bool>> keys;
+    for (int state = 0; state < num_states; ++state)
+        keys.push_back(make_pair(factor.goal_distances[state],
+                                 !factor.goal_states[state]));
+    vector<pair<int, bool>> sorted_keys(keys);
+    sort(sorted_keys.begin(), sorted_keys.end());
+    sorted_keys.erase(unique(sorted_keys.begin(), sorted_keys.end()),
+                      sorted_keys.end());
+    int num_blocks = min(static_cast<int>(sorted_keys.size()), max_size);
+    vector<int> &blocks = abstraction;
+    blocks.resize(num_states);
+    for (int state = 0; state < num_states; ++state) {
+        int block = lower_bound(sorted_keys.begin(), sorted_keys.end(),
+                                keys[state]) - sorted_keys.begin();
+        blocks[state] = min(block, max_size - 1);
+    }
+
+    // Signatures: sorted pairs (group, block of the target).
+    vector<pair<int, int>> signatures(successors.size());
+    vector<int> signature_ends(num_states);
+    vector<int> states(num_states);
+    for (int state = 0; state < num_states; ++state)
+        states[state] = state;
+    vector<int> num_sub_blocks;
+    vector<int> new_blocks;
+    while (true) {
+        for (int state = 0; state < num_states; ++state) {
+            for (int i = starts[state]; i < starts[state + 1]; ++i)
+                signatures[i] = make_pair(successors[i].first,
+                                          blocks[successors[i].second]);
+            vector<pair<int, int>>::iterator begin =
+                signatures.begin() + starts[state];
+            sort(begin, signatures.begin() + starts[state + 1]);
+            signature_ends[state] =
+                unique(begin, signatures.begin() + starts[state + 1]) -
+                signatures.begin();
+        }
+        auto less_than = [&](int s1, int s2) {
+                             if (blocks[s1] != blocks[s2])
+                                 return blocks[s1] < blocks[s2];
+                             return lexicographical_compare(
+                                 signatures.begin() + starts[s1],
+                                 signatures.begin() + signature_ends[s1],
+                                 signatures.begin() + starts[s2],
+                                 signatures.begin() + signature_ends[s2]);
+                         };
+        sort(states.begin(), states.end(), less_than);
+
+        num_sub_blocks.assign(num_blocks, 1);
+        for (int i = 1; i < num_states; ++i) {
+            if (less_than(states[i - 1], states[i]) &&
+                blocks[states[i - 1]] == blocks[states[i]])
+                ++num_sub_blocks[blocks[states[i]]];
+        }
+        /*
+          Split the blocks with small goal distances first. If the limit
+          does not allow to split a block completely, the states with the
+          last signatures stay together.
+        */
+        int new_num_blocks = num_blocks;
+        for (int block = 0; block < num_blocks; ++block) {
+            int max_sub_blocks = max_size - new_num_blocks + 1;
+            num_sub_blocks[block] = min(num_sub_blocks[block], max_sub_blocks);
+            new_num_blocks += num_sub_blocks[block] - 1;
+        }
+        if (new_num_blocks == num_blocks)
+            break;
+
+        // The first sub-block of a split block keeps its number.
+        new_blocks.resize(num_states);
+        int next_block = num_blocks;
+        int current_block = -1;
+        int sub_block = 0;
+        for (int i = 0; i < num_states; ++i) {
+            int state = states[i];
+            int block = blocks[state];
+            if (i == 0 || block != blocks[states[i - 1]]) {
+                current_block = block;
+                sub_block = 0;
+            } else if (sub_block + 1 < num_sub_blocks[block] &&
+                       less_than(states[i - 1], state)) {
+                current_block = next_block++;
+                ++sub_block;
+            }
+            new_blocks[state] = current_block;
+        }
+        assert(next_block == new_num_blocks);
+        blocks.swap(new_blocks);
+        num_blocks = new_num_blocks;
+    }
+    return num_blocks;
+}
+
+void MASHeuristic::shrink(FactoredTransitionSystem &fts, int index,
+                          int max_size) const
 {
+    const FactoredTransitionSystem::Factor &factor = fts.get_factor(index);
+    vector<int> abstraction;
+    int num_abstract_states = compute_bisimulation(factor, max_size,
+                                                   abstraction);
+    if (num_abstract_states < factor.num_states)
+        fts.apply_abstraction(index, abstraction, num_abstract_states);
 }
 
 void MASHeuristic::initialize()
 {
     cout << "Initializing merge-and-shrink heuristic..." << endl;
+    if (has_axioms()) {
+        cerr << "merge-and-shrink does not support axioms!" << endl
+             << "Terminating." << endl;
+        exit_with(EXIT_UNSUPPORTED);
+    }
+    Timer timer;
+    CountdownTimer countdown(max_time);
+    vector<int> operator_costs;
+    for (const Operator &op : g_operators)
+        operator_costs.push_back(get_adjusted_cost(op));
+    FactoredTransitionSystem fts(operator_costs);
+    int num_labels = fts.get_num_active_labels();
+    size_t peak_transitions = fts.get_num_transitions();
+    size_t peak_factor_transitions = 0;
+    for (int var = 0; var < fts.get_num_factors(); ++var) {
+        peak_factor_transitions = max(peak_factor_transitions,
+                                      fts.get_factor(var).get_num_transitions());
+        if (!fts.prune(var))
+            unsolvable = true;
+    }
+    if (merge_strategy == LINEAR)
+        compute_linear_order();
+
+    int composite = -1;
+    int num_merges = 0;
+    while (!unsolvable && fts.get_num_active_factors() > 1) {
+        if (countdown.is_expired()) {
+            cout << "Merge-and-shrink time limit reached after " << num_merges
+                 << " merges." << endl;
+            break;
+        }
+        pair<int, int> factors = merge_strategy == LINEAR ?
+            select_linear(composite, num_merges) : select_dfp(fts);
+        if (label_reduction) {
+            fts.reduce_labels(factors.first);
+            fts.reduce_labels(factors.second);
+        }
+        shrink(fts, factors.first, INF);
+        shrink(fts, factors.second, INF);
+        int size1 = fts.get_factor(factors.first).num_states;
+        int size2 = fts.get_factor(factors.second).num_states;
+        if (int64_t(size1) * size2 > max_states) {
+            // Balance the sizes, keeping a small factor as it is.
+            int balanced_size = max(1, int(sqrt(double(max_states))));
+            int max_size1 = balanced_size;
+            int max_size2 = balanced_size;
+            if (size1 <= balanced_size) {
+                max_size1 = size1;
+                max_size2 = max_states / size1;
+            } else if (size2 <= balanced_size) {
+                max_size1 = max_states / size2;
+                max_size2 = size2;
+            }
+            if (size1 > max_size1)
+                shrink(fts, factors.first, max_size1);
+            if (size2 > max_size2)
+                shrink(fts, factors.second, max_size2);
+        }
+        composite = fts.merge(factors.first, factors.second);
+        ++num_merges;
+        peak_transitions = max(peak_transitions, fts.get_num_transitions());
+        peak_factor_transitions = max(
+            peak_factor_transitions,
+            fts.get_factor(composite).get_num_transitions());
+        if (!fts.prune(composite))
+            unsolvable = true;
+    }
+
+    size_t num_entries = 0;
+    if (unsolvable) {
+        cout << "The initial state is a dead end in an abstraction." << endl;
+    } else {
+        // Factors without positive goal distances do not contribute.
+        for (int index = 0; index < fts.get_num_factors(); ++index) {
+            if (!fts.is_active(index))
+                continue;
+            const vector<int> &goal_distances =
+                fts.get_factor(index).goal_distances;
+            if (*max_element(goal_distances.begin(), goal_distances.end()) == 0)
+                continue;
+            representations.push_back(nullptr);
+            distances.push_back(vector<int>());
+            fts.release(index, representations.back(), distances.back());
+            num_entries += representations.back()->get_num_entries() +
+                           distances.back().size();
+        }
+    }
+    cout << "Merge-and-shrink construction time: " << timer << endl;
+    cout << "Merges: " << num_merges << ", factors in the heuristic: "
+         << representations.size() << endl;
+    cout << "Labels: " << num_labels << " initially, "
+         << fts.get_num_active_labels() << " after label reduction" << endl;
+    cout << "Peak transitions: " << peak_transitions << " in all factors, "
+         << peak_factor_transitions << " in a single factor" << endl;
+    cout << "Lookup tables: " << num_entries << " entries ("
+         << num_entries * sizeof(int) / 1024 << " KB)" << endl;
+    if (!unsolvable)
+        report_lookup_throughput();
+}
+
+void MASHeuristic::report_lookup_throughput() const
+{
+    // Lookups of random assignments to the variables, which may include
+    // unreachable and pruned ones.
+    const int NUM_SAMPLES = 1000;
+    // The timer is coarse, so the lookups are repeated for a while.
+    const double MIN_TIME = 0.1;
+    RandomNumberGenerator rng(2011);
+    vector<vector<int>> samples(NUM_SAMPLES,
+                                vector<int>(g_variable_domain.size()));
+    for (vector<int> &sample : samples) {
+        for (size_t var = 0; var < g_variable_domain.size(); ++var)
+            sample[var] = rng(g_variable_domain[var]);
+    }
+    Timer timer;
+    int64_t num_lookups = 0;
+    int64_t num_dead_ends = 0;
+    while (timer() < MIN_TIME) {
+        for (const vector<int> &sample : samples) {
+            if (lookup(sample) == DEAD_END)
+                ++num_dead_ends;
+        }
+        num_lookups += NUM_SAMPLES;
+    }
+    cout << "Lookup throughput: " << int64_t(num_lookups / timer())
+         << " lookups/s on random assignments ("
+         << 100.0 * num_dead_ends / num_lookups << "% pruned)" << endl;
 }
 
-int MASHeuristic::compute_heuristic(const State &/*state*/)
+int MASHeuristic::compute_heuristic(const State &state)
 {
-    // TODO implementation
-    return -1;
+    if (unsolvable)
+        return DEAD_END;
+    return lookup(state);
 }
 
 static Heuristic *_parse(OptionParser &parser)
 {
+    parser.document_synopsis(
+        "Merge-and-shrink heuristic",
+        "Merge-and-shrink with exact label reduction and bisimulation "
+        "shrinking.");
     Heuristic::add_options_to_parser(parser);
+    vector<string> merge_strategies;
+    merge_strategies.push_back("LINEAR");
+    merge_strategies.push_back("DFP");
+    parser.add_enum_option(
+        "merge_strategy", merge_strategies,
+        "merge the variables in cg-goal-level order (LINEAR) or the pair of "
+        "factors with the lowest DFP score (DFP)", "DFP");
+    parser.add_option<int>(
+        "max_states", "maximum number of states of a factor", "50000");
+    parser.add_option<bool>(
+        "label_reduction", "reduce the labels exactly before each merge",
+        "true");
+    parser.add_option<double>(
+        "max_time",
+        "time limit in seconds for the construction, checked before each "
+        "merge. The heuristic then uses the factors built so far.",
+        "infinity");
     Options opts = parser.parse();
+    if (opts.get<int>("max_states") < 1)
+        parser.error("max_states must be at least 1");
     if (parser.dry_run()) {
         return 0;
     } else {
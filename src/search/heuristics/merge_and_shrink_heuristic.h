@@ -2,6 +2,12 @@
 #define MAS_HEURISTIC_H
 
 #include "../heuristic.h"
+#include "factored_transition_system.h"
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+#include <vector>
 
 // Usage example: the command line option for using h^{MS} in astar is
 // ./fast-downward.py [path-to-PDDL-problem-file] --search "wastar(merge-and-shrink())"
@@ -47,14 +53,85 @@
   points depending on the strategies that you come up with.
 */
 
-
-
-
+/*
+  The heuristic works on a factored transition system (see
+  factored_transition_system.h) that starts with the atomic factors and
+  merges two factors per iteration until one is left:
+
+  1) The merge strategy selects two factors. LINEAR merges the variables
+     into one factor in cg-goal-level order: the next variable is a
+     causal graph predecessor of a merged variable, or a goal variable,
+     or any variable, with ties broken towards higher variable numbers.
+     DFP (Draeger, Finkbeiner & Podelski, 2006) merges the pair of
+     factors with a common label that leads closest to the goal: the
+     rank of a label in a factor is the smallest goal distance of the
+     target of one of its transitions, and the score of a pair is the
+     minimum of max(rank1, rank2) over the labels that are not self-loops
+     on all states of both factors.
+  2) If label_reduction is set, the labels are reduced exactly with
+     respect to both factors.
+  3) Both factors are shrunk by bisimulation, which does not lose
+     information. If the product would still have more than max_states
+     states, they are shrunk further by bisimulation with a size limit,
+     which refines the partition by goal distances only as long as the
+     limit allows.
+  4) The product replaces the factors, and states that are unreachable or
+     cannot reach a goal state are pruned.
+
+  If construction exceeds max_time, the factors left are kept and the
+  heuristic is the maximum of their values. Afterwards only the lookup
+  data is kept: the cascading tables of each factor and its goal
+  distances.
+*/
 class MASHeuristic : public Heuristic
 {
+    enum MergeStrategy {LINEAR, DFP};
+
+    MergeStrategy merge_strategy;
+    int max_states;
+    bool label_reduction;
+    double max_time;
+    // Variables in the order of the linear merge strategy.
+    std::vector<int> linear_order;
+    bool unsolvable;
+    std::vector<std::unique_ptr<MergeAndShrinkRepresentation>> representations;
+    std::vector<std::vector<int>> distances;
+
+    void compute_linear_order();
+    // Composite is the factor of the merged variables or -1.
+    std::pair<int, int> select_linear(int composite, int num_merges) const;
+    std::pair<int, int> select_dfp(const FactoredTransitionSystem &fts) const;
+    /*
+      Sets abstraction to the coarsest bisimulation of the factor that
+      refines its goal distances, or a coarser partition with at most
+      max_size blocks. Returns the number of blocks.
+    */
+    int compute_bisimulation(const FactoredTransitionSystem::Factor &factor,
+                             int max_size, std::vector<int> &abstraction) const;
+    void shrink(FactoredTransitionSystem &fts, int index, int max_size) const;
+    void report_lookup_throughput() const;
+
+    // Values can be a State or a vector with one value per variable.
+    template<class Values>
+    int lookup(const Values &values) const
+    {
+        int h = 0;
+        for (size_t i = 0; i < representations.size(); ++i) {
+            int abstract_state = representations[i]->lookup(values);
+            if (abstract_state == -1)
+                return DEAD_END;
+            h = std::max(h, distances[i][abstract_state]);
+        }
+        return h;
+    }
 protected:
     virtual void initialize();
     virtual int compute_heuristic(const State &state);
+    // The lookup only reads the tables.
+    virtual bool compute_heuristic_is_thread_safe() const
+    {
+        return true;
+    }
 public:
     MASHeuristic(const Options &options);
     ~MASHeuristic() = default;
@@ -70,6 +70,11 @@ protected:
 
     virtual void initialize();
     virtual int compute_heuristic(const State& state);
+    // The lookup only reads the pattern databases.
+    virtual bool compute_heuristic_is_thread_safe() const
+    {
+        return true;
+    }
 public:
     PDBHeuristic(const Options& options);
     ~PDBHeuristic() = default;
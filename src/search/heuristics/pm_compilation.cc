@@ -0,0 +1,325 @@
+#include "pm_compilation.h"
+
+#include "../globals.h"
+#include "../utilities.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <mutex>
+#include <set>
+
+using namespace std;
+
+// Mutex pairs of publish_mutexes(), as ordered pairs of (var, value).
+static set<pair<pair<int, int>, pair<int, int>>> published_mutex_pairs;
+static std::mutex published_mutex_pairs_lock;
+
+// Rough memory usage of the compilation and its exploration.
+static const size_t BYTES_PER_META_FACT = 96;
+// Entries are stored twice (relation and inverse), plus vector growth.
+static const size_t BYTES_PER_ENTRY = 12;
+static const size_t BYTES_PER_META_OPERATOR = 32;
+
+PmCompilation::PmCompilation(const RelaxedTask &relaxed_task_, int m_,
+                             size_t memory_limit_)
+    : relaxed_task(relaxed_task_),
+      m(m_),
+      memory_limit(memory_limit_),
+      unsolvable(false) {
+}
+
+PmCompilation *PmCompilation::build(const RelaxedTask &relaxed_task, int m,
+                                    size_t memory_limit) {
+    assert(m >= 1 && m <= MAX_M);
+    verify_no_conditional_effects();
+    if (relaxed_task.get_num_facts() >= 0xFFFF) {
+        cerr << "The P^m compilation supports at most 65534 facts" << endl;
+        exit_with(EXIT_UNSUPPORTED);
+    }
+    PmCompilation *compilation = new PmCompilation(relaxed_task, m,
+                                                   memory_limit);
+    compilation->collect_mutex_pairs();
+    if (!compilation->compile()) {
+        delete compilation;
+        return 0;
+    }
+    return compilation;
+}
+
+void PmCompilation::publish_mutexes(const vector<Mutex> &mutexes) {
+    lock_guard<std::mutex> lock(published_mutex_pairs_lock);
+    for (const Mutex &mutex : mutexes) {
+        if (mutex.size() == 2)
+            published_mutex_pairs.insert(make_pair(min(mutex[0], mutex[1]),
+                                                   max(mutex[0], mutex[1])));
+    }
+}
+
+void PmCompilation::collect_mutex_pairs() {
+    lock_guard<std::mutex> lock(published_mutex_pairs_lock);
+    for (const auto &mutex : published_mutex_pairs) {
+        int fact1 = relaxed_task.get_fact_id(mutex.first.first,
+                                             mutex.first.second);
+        int fact2 = relaxed_task.get_fact_id(mutex.second.first,
+                                             mutex.second.second);
+        mutex_pairs.insert(get_pair_key(fact1, fact2));
+    }
+    if (!mutex_pairs.empty())
+        cout << "P^m compilation: using " << mutex_pairs.size()
+             << " published mutex pairs" << endl;
+}
+
+uint64_t PmCompilation::get_pair_key(int fact1, int fact2) {
+    if (fact1 > fact2)
+        swap(fact1, fact2);
+    return (uint64_t(fact1) << 32) | uint64_t(fact2);
+}
+
+bool PmCompilation::are_mutex(int fact1, int fact2) const {
+    if (::are_mutex(make_pair(relaxed_task.get_fact_var(fact1),
+                              relaxed_task.get_fact_value(fact1)),
+                    make_pair(relaxed_task.get_fact_var(fact2),
+                              relaxed_task.get_fact_value(fact2))))
+        return true;
+    return !mutex_pairs.empty() &&
+           mutex_pairs.count(get_pair_key(fact1, fact2));
+}
+
+uint64_t PmCompilation::get_key(const vector<int> &facts) {
+    assert(facts.size() <= MAX_M);
+    uint64_t key = 0;
+    for (size_t i = 0; i < facts.size(); ++i)
+        key |= uint64_t(facts[i] + 1) << (16 * i);
+    return key;
+}
+
+void PmCompilation::get_facts(int meta_fact, vector<int> &facts) const {
+    facts.clear();
+    for (uint64_t key = meta_fact_keys[meta_fact]; key; key >>= 16)
+        facts.push_back(int(key & 0xFFFF) - 1);
+}
+
+int PmCompilation::get_meta_fact_id(const vector<int> &facts) const {
+    unordered_map<uint64_t, int>::const_iterator it =
+        meta_fact_ids.find(get_key(facts));
+    if (it == meta_fact_ids.end())
+        return -1;
+    return it->second;
+}
+
+bool PmCompilation::collect_meta_facts(const vector<int> &facts, int size,
+                                       vector<int> &result) const {
+    assert(size <= MAX_M);
+    int num_facts = facts.size();
+    if (size == 0 || size > num_facts)
+        return true;
+    int indices[MAX_M];
+    for (int i = 0; i < size; ++i)
+        indices[i] = i;
+    bool complete = true;
+    while (true) {
+        uint64_t key = 0;
+        for (int i = 0; i < size; ++i)
+            key |= uint64_t(facts[indices[i]] + 1) << (16 * i);
+        unordered_map<uint64_t, int>::const_iterator it =
+            meta_fact_ids.find(key);
+        if (it == meta_fact_ids.end())
+            complete = false;
+        else
+            result.push_back(it->second);
+
+        // Next combination in lexicographic order.
+        int i = size - 1;
+        while (i >= 0 && indices[i] == num_facts - size + i)
+            --i;
+        if (i < 0)
+            break;
+        ++indices[i];
+        for (int j = i + 1; j < size; ++j)
+            indices[j] = indices[j - 1] + 1;
+    }
+    return complete;
+}
+
+void PmCompilation::collect_all_meta_facts(const vector<int> &facts,
+                                           vector<int> &result) const {
+    for (int size = 1; size <= m; ++size)
+        collect_meta_facts(facts, size, result);
+}
+
+size_t PmCompilation::estimate_memory() const {
+    size_t bytes = meta_fact_keys.size() * BYTES_PER_META_FACT;
+    if (task) {
+        bytes += task->get_num_entries() * BYTES_PER_ENTRY;
+        bytes += task->get_num_operators() * BYTES_PER_META_OPERATOR;
+    }
+    return bytes;
+}
+
+bool PmCompilation::add_meta_facts(vector<int> &facts) {
+    int num_facts = relaxed_task.get_num_facts();
+    // Facts of the variables after the variable of the last fact.
+    int first = 0;
+    if (!facts.empty()) {
+        int last_var = relaxed_task.get_fact_var(facts.back());
+        first = facts.back() + 1;
+        while (first < num_facts && relaxed_task.get_fact_var(first) == last_var)
+            ++first;
+    }
+    for (int fact = first; fact < num_facts; ++fact) {
+        bool consistent = true;
+        for (int other : facts) {
+            if (are_mutex(fact, other)) {
+                consistent = false;
+                break;
+            }
+        }
+        if (!consistent)
+            continue;
+        facts.push_back(fact);
+        uint64_t key = get_key(facts);
+        meta_fact_ids[key] = meta_fact_keys.size();
+        meta_fact_keys.push_back(key);
+        bool within_limit = true;
+        if (static_cast<int>(facts.size()) < m)
+            within_limit = add_meta_facts(facts);
+        facts.pop_back();
+        if (!within_limit || estimate_memory() > memory_limit)
+            return false;
+    }
+    return true;
+}
+
+void PmCompilation::add_meta_operator(int op, const vector<int> &context) {
+    RelaxedTask::IdRange preconditions = relaxed_task.get_preconditions(op);
+    RelaxedTask::IdRange effects = relaxed_task.get_effects(op);
+    int max_size = m - context.size();
+    assert(max_size >= 1);
+
+    vector<int> facts(preconditions.begin(), preconditions.end());
+    facts.insert(facts.end(), context.begin(), context.end());
+    sort(facts.begin(), facts.end());
+    vector<int> meta_preconditions;
+    int size = min(m, static_cast<int>(facts.size()));
+    // Operators with a mutex in their preconditions are never applicable.
+    if (!collect_meta_facts(facts, size, meta_preconditions))
+        return;
+
+    // Facts that hold after applying the operator: its effects and the
+    // preconditions that it does not delete.
+    vector<int> added(effects.begin(), effects.end());
+    for (int pre : preconditions) {
+        int var = relaxed_task.get_fact_var(pre);
+        bool deleted = false;
+        for (int eff : effects) {
+            if (relaxed_task.get_fact_var(eff) == var)
+                deleted = true;
+        }
+        if (!deleted)
+            added.push_back(pre);
+    }
+    sort(added.begin(), added.end());
+    vector<int> subsets;
+    vector<int> meta_effects;
+    for (size = 1; size <= max_size; ++size) {
+        subsets.clear();
+        collect_meta_facts(added, size, subsets);
+        for (int id : subsets) {
+            get_facts(id, facts);
+            bool has_effect = false;
+            for (int fact : facts) {
+                if (binary_search(effects.begin(), effects.end(), fact))
+                    has_effect = true;
+            }
+            if (!has_effect)
+                continue;
+            facts.insert(facts.end(), context.begin(), context.end());
+            sort(facts.begin(), facts.end());
+            int meta_fact = get_meta_fact_id(facts);
+            if (meta_fact != -1)
+                meta_effects.push_back(meta_fact);
+        }
+    }
+    if (!meta_effects.empty()) {
+        task->add_operator(relaxed_task.get_operator_no(op),
+                           meta_preconditions, meta_effects);
+    }
+}
+
+void PmCompilation::add_meta_operators(int op, const vector<int> &candidates,
+                                       size_t first, vector<int> &context) {
+    add_meta_operator(op, context);
+    if (static_cast<int>(context.size()) + 1 >= m)
+        return;
+    for (size_t i = first; i < candidates.size(); ++i) {
+        int fact = candidates[i];
+        int var = relaxed_task.get_fact_var(fact);
+        if (!context.empty() &&
+            relaxed_task.get_fact_var(context.back()) == var)
+            continue;
+        context.push_back(fact);
+        // Contexts with a mutex are no meta-facts.
+        if (meta_fact_ids.count(get_key(context)))
+            add_meta_operators(op, candidates, i + 1, context);
+        context.pop_back();
+    }
+}
+
+bool PmCompilation::compile() {
+    if (m > 1) {
+        vector<int> facts;
+        if (!add_meta_facts(facts))
+            return false;
+    } else {
+        for (int fact = 0; fact < relaxed_task.get_num_facts(); ++fact) {
+            uint64_t key = get_key(vector<int>(1, fact));
+            meta_fact_ids[key] = fact;
+            meta_fact_keys.push_back(key);
+        }
+    }
+    task.reset(new RelaxedTask(meta_fact_keys.size()));
+
+    int num_facts = relaxed_task.get_num_facts();
+    vector<int> blocked_vars;
+    vector<int> candidates;
+    vector<int> context;
+    for (int op = 0; op < relaxed_task.get_num_operators(); ++op) {
+        // Context facts: values of the other variables that are not mutex
+        // with a precondition.
+        blocked_vars.clear();
+        for (int fact : relaxed_task.get_preconditions(op))
+            blocked_vars.push_back(relaxed_task.get_fact_var(fact));
+        for (int fact : relaxed_task.get_effects(op))
+            blocked_vars.push_back(relaxed_task.get_fact_var(fact));
+        sort(blocked_vars.begin(), blocked_vars.end());
+        candidates.clear();
+        if (m > 1) {
+            for (int fact = 0; fact < num_facts; ++fact) {
+                int var = relaxed_task.get_fact_var(fact);
+                if (binary_search(blocked_vars.begin(), blocked_vars.end(),
+                                  var))
+                    continue;
+                bool consistent = true;
+                for (int pre : relaxed_task.get_preconditions(op)) {
+                    if (are_mutex(fact, pre))
+                        consistent = false;
+                }
+                if (consistent)
+                    candidates.push_back(fact);
+            }
+        }
+        add_meta_operators(op, candidates, 0, context);
+        if (m > 1 && estimate_memory() > memory_limit)
+            return false;
+    }
+
+    vector<int> goal(relaxed_task.get_goal_facts());
+    sort(goal.begin(), goal.end());
+    vector<int> meta_goal;
+    int size = min(m, static_cast<int>(goal.size()));
+    if (!collect_meta_facts(goal, size, meta_goal))
+        unsolvable = true;
+    task->finish(meta_goal);
+    return true;
+}
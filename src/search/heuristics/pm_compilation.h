@@ -0,0 +1,116 @@
+#ifndef HEURISTICS_PM_COMPILATION_H
+#define HEURISTICS_PM_COMPILATION_H
+
+#include "relaxed_task.h"
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+/*
+  P^m compilation of the relaxed task (Haslum, 2009) for m = 1, ..., 4,
+  used by the h^m heuristic and the h^m landmarks.
+
+  The facts of the compilation (meta-facts) are the sets of at most m facts
+  of different variables that contain no mutex of the translator and no
+  published mutex pair (see publish_mutexes()). For each
+  relaxed operator a and each context C, i.e., a set of at most m - 1 facts
+  whose variables occur neither in pre(a) nor in eff(a), there is a
+  meta-operator with the operator number of a. Its preconditions are the
+  subsets of pre(a) + C of size min(m, |pre(a) + C|), and it adds the sets
+  X + C of at most m facts with X a subset of eff(a) and the preconditions
+  of a that it does not delete, if X contains an effect. Larger
+  preconditions dominate their subsets, so the smaller ones are not
+  needed. The goal consists of the subsets of the goal of size
+  min(m, |goal|). h^max of the compilation is h^m of the relaxed task.
+
+  Conditional effects are not supported: the relaxed task splits them
+  into separate operators, which would make pairs of effects of one
+  operator unreachable and h^m inadmissible.
+
+  Sets of facts are passed as sorted IDs of the relaxed task. The
+  compilation is never modified after it has been built.
+*/
+class PmCompilation {
+public:
+    static const int MAX_M = 4;
+    // A mutex is a list of facts (var, value).
+    typedef std::vector<std::pair<int, int>> Mutex;
+private:
+    const RelaxedTask &relaxed_task;
+    int m;
+    size_t memory_limit;
+    // Published mutex pairs as fact pairs (see get_pair_key()).
+    std::unordered_set<uint64_t> mutex_pairs;
+    // Key of each meta-fact (see get_key()) and its inverse.
+    std::vector<uint64_t> meta_fact_keys;
+    std::unordered_map<uint64_t, int> meta_fact_ids;
+    std::unique_ptr<RelaxedTask> task;
+    // True if a subset of the goal contains a mutex.
+    bool unsolvable;
+
+    PmCompilation(const RelaxedTask &relaxed_task, int m,
+                  size_t memory_limit);
+
+    // A set of facts is encoded in 16 bits per fact.
+    static uint64_t get_key(const std::vector<int> &facts);
+    static uint64_t get_pair_key(int fact1, int fact2);
+    void collect_mutex_pairs();
+    bool are_mutex(int fact1, int fact2) const;
+    size_t estimate_memory() const;
+    // Recursively adds the meta-facts that extend the given facts.
+    bool add_meta_facts(std::vector<int> &facts);
+    void add_meta_operator(int op, const std::vector<int> &context);
+    // Recursively adds the meta-operators of op with contexts that extend
+    // the given context by candidates from first on.
+    void add_meta_operators(int op, const std::vector<int> &candidates,
+                            size_t first, std::vector<int> &context);
+    // Returns false if the compilation exceeds the memory limit.
+    bool compile();
+public:
+    /*
+      Returns 0 if the estimated size of the compilation exceeds the
+      memory limit (in bytes). The compilation for m = 1 is the relaxed
+      task itself and is always built.
+    */
+    static PmCompilation *build(const RelaxedTask &relaxed_task, int m,
+                                size_t memory_limit);
+    /*
+      Makes mutexes that the search component has found (e.g., the h^m
+      mutexes of hm_heuristic.h) available to all compilations built
+      afterwards, in addition to the mutexes of the translator, which are
+      read-only. Only pairs are used. Thread-safe; published mutexes are
+      never removed.
+    */
+    static void publish_mutexes(const std::vector<Mutex> &mutexes);
+
+    int get_m() const {
+        return m;
+    }
+    const RelaxedTask &get_task() const {
+        return *task;
+    }
+    int get_num_meta_facts() const {
+        return meta_fact_keys.size();
+    }
+    bool is_unsolvable() const {
+        return unsolvable;
+    }
+    void get_facts(int meta_fact, std::vector<int> &facts) const;
+    // Returns -1 if the set is not a meta-fact.
+    int get_meta_fact_id(const std::vector<int> &facts) const;
+    /*
+      Appends the IDs of the meta-facts that are subsets of the given size
+      of the facts. Returns false if a subset is not a meta-fact.
+    */
+    bool collect_meta_facts(const std::vector<int> &facts, int size,
+                            std::vector<int> &result) const;
+    // Appends the IDs of all meta-facts that are subsets of the facts.
+    void collect_all_meta_facts(const std::vector<int> &facts,
+                                std::vector<int> &result) const;
+};
+
+#endif
@@ -18,6 +18,7 @@ RedBlackHeuristic::RedBlackHeuristic(const Options &opts)
 void RedBlackHeuristic::initialize()
 {
     cout << "Initializing red-black heuristic..." << endl;
+    FFHeuristic::initialize();
     //TODO implementation: decide painting 
 }
 
@@ -33,7 +34,7 @@ int RedBlackHeuristic::compute_heuristic(const State &/*state*/)
     return -1;
 }
 
-void RedBlackHeuristic::get_helpful_actions(std::vector<const Operator *>
+void RedBlackHeuristic::add_helpful_actions(std::vector<const Operator *>
         &/*result*/)
 {
     // TODO implementation
@@ -23,7 +23,7 @@
 // black. More sophisticated painting strategies will be rewarded with
 // additional bonus points.
 //
-// Helpful actions: in get_helpful_actions you should only add those
+// Helpful actions: in add_helpful_actions you should only add those
 // operators of the Red-Black plan to result that are applicable in the state on which
 // compute_heuristic is called.
 //
@@ -57,10 +57,10 @@ protected:
 
     virtual void initialize();
     virtual int compute_heuristic(const State &state);
+    virtual void add_helpful_actions(std::vector<const Operator *> &result);
 public:
     RedBlackHeuristic(const Options &options);
     ~RedBlackHeuristic() = default;
-    virtual void get_helpful_actions(std::vector<const Operator *> &result);
 };
 
 #endif
@@ -0,0 +1,324 @@
+#include "relaxed_exploration.h"
+
+#include "../globals.h"
+#include "../state.h"
+
+#include <algorithm>
+#include <cassert>
+
+using namespace std;
+
+
+RelaxedExploration::RelaxedExploration()
+    : relaxed_task(0),
+      aggregation(MAX),
+      incremental(false),
+      num_unreached_goals(0),
+      unit_cost(true),
+      parent_id(StateID::no_state),
+      child_id(StateID::no_state),
+      cached_id(StateID::no_state) {
+}
+
+RelaxedExploration::RelaxedExploration(const RelaxedTask &relaxed_task_,
+                                       const vector<int> &operator_costs,
+                                       Aggregation aggregation_,
+                                       bool incremental_)
+    : relaxed_task(&relaxed_task_),
+      aggregation(aggregation_),
+      incremental(incremental_),
+      num_unreached_goals(0),
+      unit_cost(true),
+      parent_id(StateID::no_state),
+      child_id(StateID::no_state),
+      cached_id(StateID::no_state) {
+    FactInfo unreached = {-1, -1};
+    facts.resize(relaxed_task->get_num_facts(), unreached);
+    int num_operators = relaxed_task->get_num_operators();
+    num_preconditions.reserve(num_operators);
+    base_costs.reserve(num_operators);
+    for (int op = 0; op < num_operators; ++op) {
+        num_preconditions.push_back(relaxed_task->get_num_preconditions(op));
+        int base_cost = operator_costs[relaxed_task->get_operator_no(op)];
+        base_costs.push_back(base_cost);
+        if (base_cost > 1)
+            unit_cost = false;
+    }
+    unsatisfied_preconditions = num_preconditions;
+    accumulated_costs = base_costs;
+    if (incremental)
+        affected.resize(relaxed_task->get_num_facts(), false);
+}
+
+void RelaxedExploration::reset() {
+    for (int fact : reached_facts) {
+        facts[fact].cost = -1;
+        facts[fact].supporter = -1;
+    }
+    reached_facts.clear();
+    unsatisfied_preconditions = num_preconditions;
+    if (aggregation == SUM)
+        accumulated_costs = base_costs;
+    buckets.clear();
+    queue.clear();
+}
+
+template<typename Queue>
+void RelaxedExploration::enqueue_if_necessary(Queue &queue, int fact, int cost,
+                                              int supporter) {
+    assert(cost >= 0);
+    FactInfo &info = facts[fact];
+    if (info.cost == -1 || info.cost > cost) {
+        if (info.cost == -1)
+            reached_facts.push_back(fact);
+        info.cost = cost;
+        info.supporter = supporter;
+        queue.push(cost, fact);
+    }
+}
+
+void RelaxedExploration::get_state_facts(const State &state,
+                                         vector<int> &result) const {
+    result.resize(g_variable_domain.size());
+    for (size_t var = 0; var < g_variable_domain.size(); ++var)
+        result[var] = relaxed_task->get_fact_id(var, state[var]);
+}
+
+void RelaxedExploration::set_parent(const State &parent_state,
+                                    const State &state) {
+    if (!incremental)
+        return;
+    parent_id = parent_state.get_id();
+    child_id = state.get_id();
+    get_state_facts(parent_state, parent_state_facts);
+}
+
+void RelaxedExploration::compute(const State &state) {
+    assert(relaxed_task);
+    get_state_facts(state, state_facts);
+    if (!incremental || child_id == StateID::no_state ||
+        state.get_id() != child_id) {
+        explore(state_facts, true);
+        return;
+    }
+    child_id = StateID::no_state;
+    // IDs of different state registries may coincide, hence the comparison.
+    if (parent_id != cached_id || parent_state_facts != cached_state_facts) {
+        explore(parent_state_facts, false);
+        cached_id = parent_id;
+        cached_state_facts = parent_state_facts;
+        cached_facts = facts;
+        cached_reached_facts = reached_facts;
+    } else {
+        facts = cached_facts;
+        reached_facts = cached_reached_facts;
+    }
+    if (!repair(cached_state_facts, state_facts))
+        explore(state_facts, true);
+}
+
+void RelaxedExploration::compute(const vector<int> &state_facts,
+                                 bool stop_at_goals) {
+    assert(relaxed_task);
+    explore(state_facts, stop_at_goals);
+}
+
+void RelaxedExploration::explore(const vector<int> &state_facts,
+                                 bool stop_at_goals) {
+    reset();
+    if (!unit_cost)
+        explore(queue, state_facts, stop_at_goals);
+    else if (aggregation == MAX)
+        explore_layers(state_facts, stop_at_goals);
+    else
+        explore(buckets, state_facts, stop_at_goals);
+}
+
+void RelaxedExploration::enqueue_in_layers(int fact, int cost, int supporter,
+                                           int layer) {
+    FactInfo &info = facts[fact];
+    if (info.cost == -1 || info.cost > cost) {
+        if (info.cost == -1)
+            reached_facts.push_back(fact);
+        info.cost = cost;
+        info.supporter = supporter;
+        if (cost == layer)
+            current_layer.push_back(fact);
+        else
+            next_layer.push_back(fact);
+    }
+}
+
+/*
+  With operator costs 0 and 1, the h^max cost of a fact is the layer in
+  which it is reached, so the queue is replaced by two layers. Effects of
+  operators with cost 0 are appended to the layer that is being processed.
+*/
+void RelaxedExploration::explore_layers(const vector<int> &state_facts,
+                                        bool stop_at_goals) {
+    const RelaxedTask &task = *relaxed_task;
+    num_unreached_goals = task.get_goal_facts().size();
+    current_layer.clear();
+    next_layer.clear();
+    for (int fact : state_facts)
+        enqueue_in_layers(fact, 0, -1, 0);
+    for (int op : task.get_operators_without_preconditions()) {
+        for (int fact : task.get_effects(op))
+            enqueue_in_layers(fact, base_costs[op], op, 0);
+    }
+
+    for (int layer = 0; !current_layer.empty(); ++layer) {
+        for (size_t i = 0; i < current_layer.size(); ++i) {
+            int fact = current_layer[i];
+            // The fact may have been moved to an earlier layer.
+            if (facts[fact].cost < layer)
+                continue;
+            if (stop_at_goals && task.is_goal_fact(fact) &&
+                --num_unreached_goals == 0)
+                return;
+            for (int op : task.get_precondition_of(fact)) {
+                if (--unsatisfied_preconditions[op] == 0) {
+                    int op_cost = base_costs[op] + layer;
+                    for (int eff : task.get_effects(op))
+                        enqueue_in_layers(eff, op_cost, op, layer);
+                }
+            }
+        }
+        current_layer.swap(next_layer);
+        next_layer.clear();
+    }
+}
+
+template<typename Queue>
+void RelaxedExploration::explore(Queue &queue, const vector<int> &state_facts,
+                                 bool stop_at_goals) {
+    num_unreached_goals = relaxed_task->get_goal_facts().size();
+    for (int fact : state_facts)
+        enqueue_if_necessary(queue, fact, 0, -1);
+    for (int op : relaxed_task->get_operators_without_preconditions()) {
+        for (int fact : relaxed_task->get_effects(op))
+            enqueue_if_necessary(queue, fact, base_costs[op], op);
+    }
+
+    while (!queue.empty()) {
+        pair<int, int> top = queue.pop();
+        int cost = top.first;
+        int fact = top.second;
+        if (facts[fact].cost < cost)
+            continue;
+        // Popped facts have their final cost.
+        if (stop_at_goals && relaxed_task->is_goal_fact(fact) &&
+            --num_unreached_goals == 0)
+            break;
+        for (int op : relaxed_task->get_precondition_of(fact)) {
+            /*
+              Facts are popped in order of their cost, so for h^max the
+              last precondition determines the cost of the operator.
+            */
+            if (aggregation == SUM)
+                accumulated_costs[op] += cost;
+            if (--unsatisfied_preconditions[op] == 0) {
+                int op_cost = aggregation == SUM ? accumulated_costs[op] :
+                              base_costs[op] + cost;
+                for (int eff : relaxed_task->get_effects(op))
+                    enqueue_if_necessary(queue, eff, op_cost, op);
+            }
+        }
+    }
+}
+
+int RelaxedExploration::compute_operator_cost(int op) const {
+    int cost = 0;
+    for (int pre : relaxed_task->get_preconditions(op)) {
+        int pre_cost = facts[pre].cost;
+        if (pre_cost == -1)
+            return -1;
+        if (aggregation == SUM)
+            cost += pre_cost;
+        else
+            cost = max(cost, pre_cost);
+    }
+    return base_costs[op] + cost;
+}
+
+bool RelaxedExploration::repair(const vector<int> &old_state_facts,
+                                const vector<int> &new_state_facts) {
+    /*
+      Collect the facts whose best supporters transitively depend on a
+      fact of the old state that is not part of the new state. The costs
+      of all other facts can only decrease.
+    */
+    for (size_t var = 0; var < old_state_facts.size(); ++var) {
+        int fact = old_state_facts[var];
+        if (fact != new_state_facts[var]) {
+            affected[fact] = true;
+            affected_facts.push_back(fact);
+        }
+    }
+    for (size_t i = 0; i < affected_facts.size(); ++i) {
+        for (int op : relaxed_task->get_precondition_of(affected_facts[i])) {
+            for (int eff : relaxed_task->get_effects(op)) {
+                if (!affected[eff] && facts[eff].supporter == op) {
+                    affected[eff] = true;
+                    affected_facts.push_back(eff);
+                }
+            }
+        }
+    }
+    if (affected_facts.size() * MAX_AFFECTED_DIVISOR > facts.size()) {
+        for (int fact : affected_facts)
+            affected[fact] = false;
+        affected_facts.clear();
+        return false;
+    }
+    for (int fact : affected_facts) {
+        facts[fact].cost = -1;
+        facts[fact].supporter = -1;
+    }
+
+    queue.clear();
+    for (size_t var = 0; var < new_state_facts.size(); ++var) {
+        if (new_state_facts[var] != old_state_facts[var])
+            enqueue_if_necessary(queue, new_state_facts[var], 0, -1);
+    }
+    for (int fact : affected_facts) {
+        for (int op : relaxed_task->get_achievers(fact)) {
+            int cost = compute_operator_cost(op);
+            if (cost != -1)
+                enqueue_if_necessary(queue, fact, cost, op);
+        }
+    }
+    for (int fact : affected_facts)
+        affected[fact] = false;
+    affected_facts.clear();
+
+    while (!queue.empty()) {
+        pair<int, int> top = queue.pop();
+        int cost = top.first;
+        int fact = top.second;
+        if (facts[fact].cost < cost)
+            continue;
+        for (int op : relaxed_task->get_precondition_of(fact)) {
+            int op_cost = compute_operator_cost(op);
+            if (op_cost == -1)
+                continue;
+            for (int eff : relaxed_task->get_effects(op))
+                enqueue_if_necessary(queue, eff, op_cost, op);
+        }
+    }
+    return true;
+}
+
+int RelaxedExploration::get_goal_cost(Aggregation aggregation) const {
+    int result = 0;
+    for (int goal : relaxed_task->get_goal_facts()) {
+        int cost = facts[goal].cost;
+        if (cost == -1)
+            return -1;
+        if (aggregation == SUM)
+            result += cost;
+        else
+            result = max(result, cost);
+    }
+    return result;
+}
@@ -0,0 +1,155 @@
+#ifndef HEURISTICS_RELAXED_EXPLORATION_H
+#define HEURISTICS_RELAXED_EXPLORATION_H
+
+#include "../priority_queue.h"
+#include "../state_id.h"
+#include "relaxed_task.h"
+
+#include <vector>
+
+class State;
+
+/*
+  Cost-aware h^max/h^add exploration of the relaxed task (generalized
+  Dijkstra, Keyder & Geffner, 2008).
+
+  Facts are popped from a radix queue in order of their cost. If all
+  operators cost 0 or 1, h^add uses a bucket queue instead, and h^max
+  processes the facts in layers without any queue. When a fact
+  is popped, the precondition counters of the relaxed operators that need
+  it are decreased and their costs are updated (the maximum or the sum of
+  the precondition costs, plus the operator cost). When the last
+  precondition of an operator has been popped, its effects are queued with
+  the cost of the operator. Facts are final when they are popped, and the
+  exploration stops as soon as the last goal fact has been popped, so
+  apart from the goal costs, the costs of other facts may be too high.
+
+  All arrays are allocated once. The facts reached by a call of compute()
+  are recorded, and the next call only resets those. Most calls decrease
+  the precondition counters of almost all operators, so the counters are
+  reset with one copy instead.
+  Copying an exploration (e.g., when cloning a heuristic) copies the
+  scratch data and shares the relaxed task.
+
+  In incremental mode, the search announces the parent of the next state
+  to be evaluated with set_parent() (from Heuristic::reach_state). The
+  complete exploration of the parent, without stopping at the goals, is
+  cached, and the exploration of a child starts from the cached costs.
+  Like in incremental h^max (Liu, Koenig & Furcy, 2002), only the facts
+  whose best supporters depend on a fact that the child does not share
+  with the parent are set to unreached. They get their costs from the
+  achievers whose preconditions are still reached, and the new facts of
+  the child get cost 0. A Dijkstra search from these facts then repairs
+  all costs that change, recomputing the cost of an operator whenever one
+  of its preconditions gets cheaper. The costs of all reached facts are
+  exact afterwards. If too many facts would have to be reset, the child
+  is explored from scratch instead, as are states evaluated without an
+  announced parent. Since a parent is explored completely, this only pays
+  off if several children of each parent are evaluated and they change
+  the costs of few facts.
+*/
+class RelaxedExploration {
+public:
+    enum Aggregation {MAX, SUM};
+private:
+    // Exploration data of a fact, kept together so that each update
+    // touches a single cache line.
+    struct FactInfo {
+        int cost;
+        int supporter;
+    };
+
+    const RelaxedTask *relaxed_task;
+    Aggregation aggregation;
+    bool incremental;
+    std::vector<FactInfo> facts;
+    // Indexed by relaxed operator.
+    std::vector<int> num_preconditions;
+    std::vector<int> base_costs;
+    std::vector<int> unsatisfied_preconditions;
+    // h^add only: base cost plus the costs of the reached preconditions.
+    std::vector<int> accumulated_costs;
+    int num_unreached_goals;
+    // Facts whose entries differ from their initial values.
+    std::vector<int> reached_facts;
+    // True if all operators cost 0 or 1.
+    bool unit_cost;
+    BucketQueue<int> buckets;
+    RadixQueue<int> queue;
+    std::vector<int> current_layer;
+    std::vector<int> next_layer;
+    // Fact of each variable in the evaluated state.
+    std::vector<int> state_facts;
+
+    // Incremental mode: the parent and child announced by set_parent() ...
+    StateID parent_id;
+    StateID child_id;
+    std::vector<int> parent_state_facts;
+    // ... and the parent whose complete exploration is cached.
+    StateID cached_id;
+    std::vector<int> cached_state_facts;
+    std::vector<FactInfo> cached_facts;
+    std::vector<int> cached_reached_facts;
+    // Scratch data of repair().
+    static const size_t MAX_AFFECTED_DIVISOR = 8;
+    std::vector<bool> affected;
+    std::vector<int> affected_facts;
+
+    void reset();
+    template<typename Queue>
+    void enqueue_if_necessary(Queue &queue, int fact, int cost, int supporter);
+    void get_state_facts(const State &state, std::vector<int> &result) const;
+    void explore(const std::vector<int> &state_facts, bool stop_at_goals);
+    template<typename Queue>
+    void explore(Queue &queue, const std::vector<int> &state_facts,
+                 bool stop_at_goals);
+    void enqueue_in_layers(int fact, int cost, int supporter, int layer);
+    void explore_layers(const std::vector<int> &state_facts,
+                        bool stop_at_goals);
+    // Returns -1 if a precondition of the relaxed operator is not reached.
+    int compute_operator_cost(int op) const;
+    /*
+      Returns false without changing the costs if the repair would have to
+      reset more than a 1/MAX_AFFECTED_DIVISOR fraction of the facts.
+    */
+    bool repair(const std::vector<int> &old_state_facts,
+                const std::vector<int> &new_state_facts);
+    int get_goal_cost(Aggregation aggregation) const;
+public:
+    RelaxedExploration();
+    /*
+      operator_costs contains the (adjusted) cost of each operator in
+      g_operators.
+    */
+    RelaxedExploration(const RelaxedTask &relaxed_task,
+                       const std::vector<int> &operator_costs,
+                       Aggregation aggregation, bool incremental = false);
+
+    // Announces that state is reached from parent_state (incremental mode).
+    void set_parent(const State &parent_state, const State &state);
+    void compute(const State &state);
+    /*
+      Explores from the given facts, e.g., of a compilation of the task.
+      Without stopping at the goals, all fact costs are exact.
+    */
+    void compute(const std::vector<int> &state_facts,
+                 bool stop_at_goals = true);
+
+    // Returns -1 if the fact is not reached.
+    int get_fact_cost(int fact) const {
+        return facts[fact].cost;
+    }
+    // Returns -1 for facts of the state and facts that are not reached.
+    int get_best_supporter(int fact) const {
+        return facts[fact].supporter;
+    }
+    /*
+      Returns the h^max or h^add value of the goal computed by the last
+      call of compute(), or -1 if the goal is not reachable.
+    */
+    int get_goal_cost() const {
+        return get_goal_cost(aggregation);
+    }
+};
+
+#endif
@@ -0,0 +1,124 @@
+#include "relaxed_task.h"
+
+#include "../globals.h"
+#include "../operator.h"
+
+#include <algorithm>
+#include <iostream>
+
+using namespace std;
+
+// Appends the sorted fact IDs as a new row of a CSR relation.
+static void add_row(vector<int> &facts, vector<int> &starts,
+                    vector<int> &ids) {
+    sort(facts.begin(), facts.end());
+    facts.erase(unique(facts.begin(), facts.end()), facts.end());
+    ids.insert(ids.end(), facts.begin(), facts.end());
+    starts.push_back(ids.size());
+}
+
+
+RelaxedTask::RelaxedTask()
+    : num_facts(0) {
+    for (size_t var = 0; var < g_variable_domain.size(); ++var) {
+        fact_offsets.push_back(num_facts);
+        for (int value = 0; value < g_variable_domain[var]; ++value) {
+            fact_vars.push_back(var);
+            fact_values.push_back(value);
+        }
+        num_facts += g_variable_domain[var];
+    }
+
+    precondition_starts.push_back(0);
+    effect_starts.push_back(0);
+    vector<int> pre_facts;
+    vector<int> eff_facts;
+    for (size_t op_no = 0; op_no < g_operators.size(); ++op_no) {
+        const Operator &op = g_operators[op_no];
+        vector<int> base_pre_facts;
+        for (const Condition &pre : op.get_preconditions())
+            base_pre_facts.push_back(get_fact_id(pre.var, pre.val));
+
+        eff_facts.clear();
+        for (const Effect &eff : op.get_effects()) {
+            if (eff.conditions.empty())
+                eff_facts.push_back(get_fact_id(eff.var, eff.val));
+        }
+        if (!eff_facts.empty()) {
+            pre_facts = base_pre_facts;
+            add_operator(op_no, pre_facts, eff_facts);
+        }
+        for (const Effect &eff : op.get_effects()) {
+            if (eff.conditions.empty())
+                continue;
+            pre_facts = base_pre_facts;
+            for (const Condition &cond : eff.conditions)
+                pre_facts.push_back(get_fact_id(cond.var, cond.val));
+            eff_facts.assign(1, get_fact_id(eff.var, eff.val));
+            add_operator(op_no, pre_facts, eff_facts);
+        }
+    }
+
+    vector<int> goal;
+    for (size_t i = 0; i < g_goal.size(); ++i)
+        goal.push_back(get_fact_id(g_goal[i].first, g_goal[i].second));
+    finish(goal);
+    cout << "Relaxed task: " << num_facts << " facts, "
+         << get_num_operators() << " operators, " << preconditions.size()
+         << " preconditions, " << effects.size() << " effects" << endl;
+}
+
+RelaxedTask::RelaxedTask(int num_facts_)
+    : num_facts(num_facts_) {
+    precondition_starts.push_back(0);
+    effect_starts.push_back(0);
+}
+
+void RelaxedTask::add_operator(int op_no, vector<int> &pre_facts,
+                               vector<int> &eff_facts) {
+    operator_nos.push_back(op_no);
+    add_row(pre_facts, precondition_starts, preconditions);
+    add_row(eff_facts, effect_starts, effects);
+}
+
+void RelaxedTask::finish(const vector<int> &goal) {
+    invert(precondition_starts, preconditions, num_facts,
+           precondition_of_starts, precondition_of);
+    invert(effect_starts, effects, num_facts, achiever_starts, achievers);
+    for (int op = 0; op < get_num_operators(); ++op) {
+        if (get_num_preconditions(op) == 0)
+            operators_without_preconditions.push_back(op);
+    }
+
+    goal_fact_flags.resize(num_facts, false);
+    for (int fact : goal) {
+        if (!goal_fact_flags[fact]) {
+            goal_facts.push_back(fact);
+            goal_fact_flags[fact] = true;
+        }
+    }
+}
+
+// Computes the transposed relation of a CSR relation.
+void RelaxedTask::invert(const vector<int> &starts, const vector<int> &ids,
+                         int num_targets, vector<int> &inverse_starts,
+                         vector<int> &inverse_ids) {
+    inverse_starts.assign(num_targets + 1, 0);
+    for (int id : ids)
+        ++inverse_starts[id + 1];
+    for (int target = 0; target < num_targets; ++target)
+        inverse_starts[target + 1] += inverse_starts[target];
+    inverse_ids.resize(ids.size());
+    vector<int> next(inverse_starts.begin(), inverse_starts.end() - 1);
+    int num_rows = starts.size() - 1;
+    for (int row = 0; row < num_rows; ++row) {
+        for (int i = starts[row]; i < starts[row + 1]; ++i)
+            inverse_ids[next[ids[i]]++] = row;
+    }
+}
+
+const RelaxedTask &get_relaxed_task() {
+    // Initialization of local statics is thread-safe.
+    static const RelaxedTask relaxed_task;
+    return relaxed_task;
+}
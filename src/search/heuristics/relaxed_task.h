@@ -0,0 +1,142 @@
+#ifndef HEURISTICS_RELAXED_TASK_H
+#define HEURISTICS_RELAXED_TASK_H
+
+#include <vector>
+
+/*
+  Compiled delete relaxation of the task that is shared by the relaxation
+  heuristics (h^max, h^add, h^FF, h^2, ...).
+
+  Facts (var, value) get dense IDs, consecutive for the values of each
+  variable. Each operator becomes a relaxed operator with its preconditions
+  and unconditional effects; each conditional effect becomes an additional
+  relaxed operator whose preconditions also contain the effect conditions
+  (like the unary operators of the classic implementations, but operators
+  share one precondition counter for all unconditional effects). Axioms are
+  ignored. All relations are stored in compressed sparse row (CSR) form,
+  i.e., the IDs related to element i are ids[starts[i]] ...
+  ids[starts[i + 1] - 1], so the data of the whole task lies in a few
+  contiguous arrays.
+
+  The task is built on the first call of get_relaxed_task() after the task
+  has been read, and is never modified afterwards, so it can be used by
+  several threads at a time.
+
+  Compilations of the task (e.g., the P^m compilation of the h^m
+  heuristic) can be built as relaxed tasks as well, by adding their
+  operators and calling finish(). Their facts have no variables and
+  values, and operators refer to the operator in g_operators whose cost
+  they have.
+*/
+class RelaxedTask {
+public:
+    // IDs of one row of a CSR relation.
+    class IdRange {
+        const int *first;
+        const int *last;
+    public:
+        IdRange(const int *first_, const int *last_)
+            : first(first_), last(last_) {}
+        const int *begin() const {return first; }
+        const int *end() const {return last; }
+        int size() const {return last - first; }
+        bool empty() const {return first == last; }
+    };
+private:
+    int num_facts;
+    std::vector<int> fact_offsets;
+    std::vector<int> fact_vars;
+    std::vector<int> fact_values;
+
+    // Index in g_operators of each relaxed operator.
+    std::vector<int> operator_nos;
+    std::vector<int> precondition_starts;
+    std::vector<int> preconditions;
+    std::vector<int> effect_starts;
+    std::vector<int> effects;
+    // Inverse relations: relaxed operators by precondition and by effect.
+    std::vector<int> precondition_of_starts;
+    std::vector<int> precondition_of;
+    std::vector<int> achiever_starts;
+    std::vector<int> achievers;
+    std::vector<int> operators_without_preconditions;
+
+    std::vector<int> goal_facts;
+    std::vector<bool> goal_fact_flags;
+
+    static IdRange get_row(const std::vector<int> &starts,
+                           const std::vector<int> &ids, int row) {
+        return IdRange(ids.data() + starts[row], ids.data() + starts[row + 1]);
+    }
+    static void invert(const std::vector<int> &starts,
+                       const std::vector<int> &ids, int num_targets,
+                       std::vector<int> &inverse_starts,
+                       std::vector<int> &inverse_ids);
+public:
+    // Use get_relaxed_task() instead of creating further copies.
+    RelaxedTask();
+    // Creates an empty task with the given number of facts.
+    explicit RelaxedTask(int num_facts);
+
+    // The fact vectors are sorted.
+    void add_operator(int op_no, std::vector<int> &pre_facts,
+                      std::vector<int> &eff_facts);
+    // Must be called after all operators have been added.
+    void finish(const std::vector<int> &goal);
+    // Number of precondition and effect entries (memory estimation).
+    int get_num_entries() const {
+        return preconditions.size() + effects.size();
+    }
+
+    int get_num_facts() const {
+        return num_facts;
+    }
+    int get_fact_id(int var, int value) const {
+        return fact_offsets[var] + value;
+    }
+    int get_fact_var(int fact) const {
+        return fact_vars[fact];
+    }
+    int get_fact_value(int fact) const {
+        return fact_values[fact];
+    }
+
+    int get_num_operators() const {
+        return operator_nos.size();
+    }
+    int get_operator_no(int op) const {
+        return operator_nos[op];
+    }
+    int get_num_preconditions(int op) const {
+        return precondition_starts[op + 1] - precondition_starts[op];
+    }
+    IdRange get_preconditions(int op) const {
+        return get_row(precondition_starts, preconditions, op);
+    }
+    IdRange get_effects(int op) const {
+        return get_row(effect_starts, effects, op);
+    }
+    // Relaxed operators that have the fact as a precondition.
+    IdRange get_precondition_of(int fact) const {
+        return get_row(precondition_of_starts, precondition_of, fact);
+    }
+    // Relaxed operators that have the fact as an effect.
+    IdRange get_achievers(int fact) const {
+        return get_row(achiever_starts, achievers, fact);
+    }
+    const std::vector<int> &get_operators_without_preconditions() const {
+        return operators_without_preconditions;
+    }
+
+    const std::vector<int> &get_goal_facts() const {
+        return goal_facts;
+    }
+    bool is_goal_fact(int fact) const {
+        return goal_fact_flags[fact];
+    }
+};
+
+// Returns the relaxed task of the global task.
+extern const RelaxedTask &get_relaxed_task();
+
+#endif
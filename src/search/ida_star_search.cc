@@ -0,0 +1,291 @@
+#include "ida_star_search.h"
+
+#include "globals.h"
+#include "heuristic.h"
+#include "option_parser.h"
+#include "plugin.h"
+#include "state_registry.h"
+#include "successor_generator.h"
+#include "utilities.h"
+
+#include <algorithm>
+#include <limits>
+
+using namespace std;
+
+static const int INF = numeric_limits<int>::max();
+
+
+IDAStarSearch::IDAStarSearch(const Options &opts)
+    : SearchEngine(opts),
+      heuristic(opts.get<Heuristic *>("eval")),
+      transposition_table(opts.get<int>("tt_size")),
+      f_bound(0),
+      next_f_bound(INF),
+      initial_h(0),
+      iteration(0),
+      timer(opts.get<double>("max_time")),
+      timed_out(false),
+      num_table_hits(0),
+      num_table_prunings(0)
+{
+}
+
+void IDAStarSearch::initialize()
+{
+    cout << "Conducting IDA* with a transposition table of "
+         << transposition_table.size() << " entries, (real) bound = "
+         << bound << endl;
+    search_progress.add_heuristic(heuristic);
+    initial_state_data.resize(g_state_packer->get_num_bins());
+    StateRegistry::compute_initial_state_data(&initial_state_data[0]);
+    heuristic->evaluate(
+        g_state_registry->get_unregistered_state(&initial_state_data[0]));
+    search_progress.inc_evaluated_states();
+    search_progress.inc_evaluations();
+    if (heuristic->is_dead_end()) {
+        cout << "Initial state is a dead end." << endl;
+        initial_h = INF;
+        return;
+    }
+    search_progress.get_initial_h_values();
+    initial_h = heuristic->get_heuristic();
+    f_bound = initial_h;
+}
+
+unsigned long long IDAStarSearch::get_fingerprint(
+    const PackedStateBin *buffer) const
+{
+    unsigned long long hash = hash_number_sequence(
+        buffer, g_state_packer->get_num_bins());
+    // Mix the bits since the table index is taken modulo the table size.
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    hash *= 0xc4ceb9fe1a85ec53ULL;
+    hash ^= hash >> 33;
+    return hash ? hash : 1;
+}
+
+IDAStarSearch::TranspositionEntry *IDAStarSearch::lookup(
+    unsigned long long fingerprint)
+{
+    if (transposition_table.empty()) {
+        return 0;
+    }
+    TranspositionEntry &entry =
+        transposition_table[fingerprint % transposition_table.size()];
+    if (entry.fingerprint != fingerprint) {
+        return 0;
+    }
+    return &entry;
+}
+
+void IDAStarSearch::store(unsigned long long fingerprint, int g, int h)
+{
+    if (transposition_table.empty()) {
+        return;
+    }
+    TranspositionEntry &entry =
+        transposition_table[fingerprint % transposition_table.size()];
+    entry.fingerprint = fingerprint;
+    entry.g = g;
+    entry.h = h;
+    entry.iteration = iteration;
+}
+
+SearchStatus IDAStarSearch::step()
+{
+    if (initial_h == INF) {
+        return FAILED;
+    }
+    ++iteration;
+    cout << "f_bound = " << f_bound << " [expanded "
+         << search_progress.get_expanded() << " state(s), t="
+         << g_timer << "]" << endl;
+
+    next_f_bound = INF;
+    path.clear();
+    State initial_state =
+        g_state_registry->get_unregistered_state(&initial_state_data[0]);
+    store(get_fingerprint(&initial_state_data[0]), 0, initial_h);
+    int h = initial_h;
+    if (search_subtree(initial_state, 0, 0, h, 0)) {
+        set_plan(path);
+        return SOLVED;
+    }
+    if (timed_out) {
+        cout << "Time limit reached. Abort search." << endl;
+        return TIMEOUT;
+    }
+    if (next_f_bound == INF) {
+        cout << "Completely explored state space -- no solution!" << endl;
+        return FAILED;
+    }
+    initial_h = max(initial_h, h);
+    f_bound = next_f_bound;
+    return IN_PROGRESS;
+}
+
+/*
+  Searches the subtree below state, which is reached with cost g (real_g
+  for the original costs) and has heuristic value h. Returns true if a goal
+  state is found; path then contains the plan. Otherwise, h is raised to the
+  cost of the cheapest path to the f-bound frontier through the children,
+  unless a child was pruned by the cost bound.
+*/
+bool IDAStarSearch::search_subtree(const State &state, int g, int real_g,
+                                   int &h, int depth)
+{
+    int f = g + h;
+    if (f > f_bound) {
+        next_f_bound = min(next_f_bound, f);
+        return false;
+    }
+    if (test_goal(state)) {
+        return true;
+    }
+    search_progress.inc_expanded();
+    if ((search_progress.get_expanded() & 1023) == 0 && timer.is_expired()) {
+        timed_out = true;
+    }
+    if (timed_out) {
+        return false;
+    }
+
+    if (static_cast<int>(frames.size()) == depth) {
+        frames.push_back(Frame());
+    }
+    // References to deque elements stay valid when frames grows.
+    Frame &frame = frames[depth];
+    frame.applicable_ops.clear();
+    g_successor_generator->generate_applicable_ops(state,
+                                                   frame.applicable_ops);
+    search_progress.inc_generated_ops(frame.applicable_ops.size());
+
+    int num_bins = g_state_packer->get_num_bins();
+    frame.data.resize(frame.applicable_ops.size() * num_bins);
+    frame.children.clear();
+    // Cheapest cost of reaching the frontier through a child.
+    int child_bound = INF;
+    /*
+      Children pruned by the cost bound are not part of child_bound, so it
+      is no admissible estimate if there are any.
+    */
+    bool pruned_by_bound = false;
+    for (size_t i = 0; i < frame.applicable_ops.size(); ++i) {
+        const Operator *op = frame.applicable_ops[i];
+        if (real_g + op->get_cost() >= bound) {
+            pruned_by_bound = true;
+            continue;
+        }
+        int cost = get_adjusted_cost(*op);
+        int succ_g = g + cost;
+        Child child;
+        child.op = op;
+        child.data_pos = frame.children.size() * num_bins;
+        PackedStateBin *succ_data = &frame.data[child.data_pos];
+        StateRegistry::compute_successor_data(state, *op, succ_data);
+        search_progress.inc_generated();
+        child.fingerprint = get_fingerprint(succ_data);
+
+        TranspositionEntry *entry = lookup(child.fingerprint);
+        if (entry) {
+            ++num_table_hits;
+            child.h = entry->h;
+            if (child.h == INF) {
+                continue;
+            }
+            if (entry->iteration == iteration && entry->g <= succ_g) {
+                // Searched (or on the path) with at most this cost already.
+                ++num_table_prunings;
+                child_bound = min(child_bound, cost + child.h);
+                continue;
+            }
+        } else {
+            heuristic->evaluate(
+                g_state_registry->get_unregistered_state(succ_data));
+            search_progress.inc_evaluated_states();
+            search_progress.inc_evaluations();
+            if (heuristic->is_dead_end()) {
+                search_progress.inc_dead_ends();
+                store(child.fingerprint, succ_g, INF);
+                continue;
+            }
+            child.h = heuristic->get_heuristic();
+        }
+        store(child.fingerprint, succ_g, child.h);
+        frame.children.push_back(child);
+    }
+
+    stable_sort(frame.children.begin(), frame.children.end());
+    for (size_t i = 0; i < frame.children.size(); ++i) {
+        const Child &child = frame.children[i];
+        State succ_state = g_state_registry->get_unregistered_state(
+            &frame.data[child.data_pos]);
+        int cost = get_adjusted_cost(*child.op);
+        int succ_h = child.h;
+        path.push_back(child.op);
+        if (search_subtree(succ_state, g + cost, real_g + child.op->get_cost(),
+                           succ_h, depth + 1)) {
+            return true;
+        }
+        path.pop_back();
+        if (timed_out) {
+            return false;
+        }
+        TranspositionEntry *entry = lookup(child.fingerprint);
+        if (entry && succ_h > entry->h) {
+            entry->h = succ_h;
+        }
+        if (succ_h != INF) {
+            child_bound = min(child_bound, cost + succ_h);
+        }
+    }
+    if (child_bound != INF && !pruned_by_bound) {
+        h = max(h, child_bound);
+    }
+    return false;
+}
+
+void IDAStarSearch::statistics() const
+{
+    search_progress.print_statistics();
+    cout << "Iterations: " << iteration << endl;
+    cout << "Transposition table hits: " << num_table_hits << endl;
+    cout << "Transposition table prunings: " << num_table_prunings << endl;
+}
+
+static SearchEngine *_parse(OptionParser &parser)
+{
+    parser.document_synopsis(
+        "IDA* search",
+        "Iterative deepening A* with a fixed-size transposition table. "
+        "Finds optimal plans with admissible heuristics and uses memory "
+        "linear in the plan length plus the size of the table.");
+    parser.document_note(
+        "Heuristics",
+        "States are not registered, so heuristics that store information "
+        "per state or rely on reach_state are not supported.");
+    parser.add_option<Heuristic *>("eval", "heuristic");
+    parser.add_option<int>(
+        "tt_size",
+        "number of entries of the transposition table (0 disables it)",
+        "1000000");
+    SearchEngine::add_options_to_parser(parser);
+    Options opts = parser.parse();
+
+    if (opts.get<int>("tt_size") < 0) {
+        parser.error("tt_size must not be negative");
+    }
+    if (parser.dry_run()) {
+        return 0;
+    }
+    if (opts.get<Heuristic *>("eval")->is_path_dependent()) {
+        parser.error("idastar does not support heuristics that depend on the "
+                     "path to a state");
+    }
+    return new IDAStarSearch(opts);
+}
+
+static Plugin<SearchEngine> _plugin("idastar", _parse);
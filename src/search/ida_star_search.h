@@ -0,0 +1,107 @@
+#ifndef IDA_STAR_SEARCH_H
+#define IDA_STAR_SEARCH_H
+
+#include "countdown_timer.h"
+#include "search_engine.h"
+#include "state.h"
+
+#include <deque>
+#include <vector>
+
+// Usage example: the command line option for using IDA* with heuristic h is
+// ./fast-downward.py [path-to-PDDL-problem-file] --search "idastar(h())"
+// So, for the PDB heuristic and a transposition table with 4 million entries
+// ./fast-downward.py [path-to-PDDL-problem-file] --search "idastar(pdb(), tt_size=4000000)"
+// Obviously, [path-to-PDDL-problem-file] has to be replaced by the actual path
+// to the PDDL problem file.
+
+/*
+  Iterative deepening A* (Korf, 1985) with a transposition table.
+
+  Each iteration is a depth-first search that prunes states with
+  f = g + h > f_bound; the next iteration uses the smallest pruned f-value
+  as its bound. States are not registered: the search keeps the packed data
+  of the children of every state on the current path and evaluates and
+  expands them as unregistered states. Children are tried in order of
+  increasing h.
+
+  The transposition table has a fixed number of entries. Each entry stores
+  a 64-bit fingerprint of a state, the smallest g with which the state was
+  reached in the current iteration and its best known h-value. Colliding
+  states simply replace each other. A state that is reached again in the
+  same iteration with a g that is not smaller is skipped (this also
+  prevents cycles). After searching the subtree of a state, its h-value is
+  raised to the smallest cost of reaching the f-bound through its children,
+  which remains admissible and saves evaluations in later iterations.
+*/
+
+class Heuristic;
+class Options;
+
+class IDAStarSearch : public SearchEngine
+{
+    struct TranspositionEntry {
+        // 0 marks empty entries.
+        unsigned long long fingerprint;
+        int g;
+        int h;
+        int iteration;
+
+        TranspositionEntry()
+            : fingerprint(0), g(0), h(0), iteration(-1)
+        {
+        }
+    };
+
+    struct Child {
+        const Operator *op;
+        int h;
+        // Offset of the packed state data in the data of the frame.
+        int data_pos;
+        unsigned long long fingerprint;
+
+        bool operator<(const Child &other) const
+        {
+            return h < other.h;
+        }
+    };
+
+    // Scratch data for expanding a state at a given depth of the path.
+    struct Frame {
+        std::vector<const Operator *> applicable_ops;
+        std::vector<PackedStateBin> data;
+        std::vector<Child> children;
+    };
+
+    Heuristic *heuristic;
+    std::vector<TranspositionEntry> transposition_table;
+    std::deque<Frame> frames;
+    std::vector<PackedStateBin> initial_state_data;
+
+    int f_bound;
+    int next_f_bound;
+    int initial_h;
+    int iteration;
+    Plan path;
+
+    CountdownTimer timer;
+    bool timed_out;
+
+    int num_table_hits;
+    int num_table_prunings;
+
+    unsigned long long get_fingerprint(const PackedStateBin *buffer) const;
+    TranspositionEntry *lookup(unsigned long long fingerprint);
+    void store(unsigned long long fingerprint, int g, int h);
+    bool search_subtree(const State &state, int g, int real_g, int &h,
+                        int depth);
+protected:
+    virtual void initialize();
+    virtual SearchStatus step();
+public:
+    IDAStarSearch(const Options &opts);
+    virtual ~IDAStarSearch() = default;
+    virtual void statistics() const;
+};
+
+#endif
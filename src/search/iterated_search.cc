@@ -1,4 +1,5 @@
 #include "iterated_search.h"
+#include "heuristic.h"
 #include "plugin.h"
 #include "ext/tree_util.hh"
 #include <limits>
@@ -9,7 +10,10 @@ IteratedSearch::IteratedSearch(const Options &opts)
       pass_bound(opts.get<bool>("pass_bound")),
       repeat_last_phase(opts.get<bool>("repeat_last")),
       continue_on_fail(opts.get<bool>("continue_on_fail")),
-      continue_on_solve(opts.get<bool>("continue_on_solve")) {
+      continue_on_solve(opts.get<bool>("continue_on_solve")),
+      warm_start(opts.get<bool>("warm_start")) {
+    current_search = NULL;
+    previous_search = NULL;
     last_phase_found_solution = false;
     best_bound = bound;
     iterated_found_solution = false;
@@ -17,6 +21,7 @@ IteratedSearch::IteratedSearch(const Options &opts)
 }
 
 IteratedSearch::~IteratedSearch() {
+    delete previous_search;
 }
 
 void IteratedSearch::initialize() {
@@ -26,7 +31,10 @@ void IteratedSearch::initialize() {
 SearchEngine *IteratedSearch::get_search_engine(
     int engine_configs_index) {
     OptionParser parser(engine_configs[engine_configs_index], false);
+    // Later phases look up the values of the states of earlier phases.
+    bool cache = Heuristic::set_cache_estimates_by_default(true);
     SearchEngine *engine = parser.start_parsing<SearchEngine *>();
+    Heuristic::set_cache_estimates_by_default(cache);
 
     cout << "Starting search: ";
     kptree::print_tree_bracketed(engine_configs[engine_configs_index], cout);
@@ -43,9 +51,15 @@ SearchEngine *IteratedSearch::create_phase(int p) {
            solution the last time around, since then this search would
            just behave the same way again (assuming determinism, which
            we might not actually have right now, but strive for). So
-           this overrides continue_on_fail.
+           this overrides continue_on_fail. The exception are engines that
+           can continue from the failed phase (e.g., beam search with a
+           wider beam). This is checked before the phase is parsed, so that
+           no engine (and no heuristic preprocessing) is built in vain.
         */
-        if (repeat_last_phase && last_phase_found_solution) {
+        bool can_continue = warm_start && previous_search &&
+                            previous_search->can_continue();
+        if (repeat_last_phase &&
+            (last_phase_found_solution || can_continue)) {
             return get_search_engine(engine_configs.size() - 1);
         } else {
             return NULL;
@@ -63,6 +77,24 @@ SearchStatus IteratedSearch::step() {
     if (pass_bound) {
         current_search->set_bound(best_bound);
     }
+    if (previous_search) {
+        bool warm_started =
+            warm_start && current_search->warm_start(*previous_search);
+        if (warm_started) {
+            cout << "Continuing from the search space of the previous phase"
+                 << endl;
+        } else if (phase >= static_cast<int>(engine_configs.size()) &&
+                   !last_phase_found_solution) {
+            // Repeating the failed phase would fail again. This only
+            // happens if can_continue() promised too much.
+            delete current_search;
+            current_search = NULL;
+            return found_solution() ? SOLVED : FAILED;
+        }
+        // Frees the search space of the previous phase.
+        delete previous_search;
+        previous_search = NULL;
+    }
     ++phase;
 
     current_search->search();
@@ -94,6 +126,7 @@ SearchStatus IteratedSearch::step() {
         current_search->get_search_progress().get_generated_ops());
     search_progress.inc_reopened(
         current_search->get_search_progress().get_reopened());
+    previous_search = current_search;
 
     return step_return_value();
 }
@@ -135,10 +168,17 @@ static SearchEngine *_parse(OptionParser &parser) {
     parser.document_synopsis("Iterated search", "");
     parser.document_note(
         "Note 1",
-        "We do no cache values between search iterations at the moment. "
-        "If you perform a LAMA-style iterative search, heuristic values "
-        "will be computed multiple times. "
-        "Adding heuristic caching is [issue108 http://issues.fast-downward.org/issue108].");
+        "Unless their cache_estimates option is set, the heuristics of the "
+        "phases cache the values of registered states and share them with "
+        "all heuristics with the same configuration, so phases look up the "
+        "values of states that earlier phases have evaluated. With "
+        "warm_start, engines that "
+        "support it (wastar with the same heuristic as the previous phase "
+        "and without pruning) also continue with the open and closed nodes "
+        "of the previous phase instead of starting from scratch, and beam "
+        "search doubles the width of the previous phase. With repeat_last, "
+        "the last phase is also repeated after a failure if it can be "
+        "warm-started, which restarts beam search with wider beams.");
     parser.document_note(
         "Note 2",
         "Running this\n```\n"
@@ -175,6 +215,10 @@ static SearchEngine *_parse(OptionParser &parser) {
     parser.add_option<bool>("continue_on_solve",
                             "continue search after solution found",
                             "true");
+    parser.add_option<bool>("warm_start",
+                            "continue from the search space of the previous "
+                            "phase if the engine supports it",
+                            "true");
     parser.add_option<int>("plan_counter",
                            "start enumerating plans with plan_counter + 1",
                            "0");
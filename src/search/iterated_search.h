@@ -16,6 +16,7 @@ class IteratedSearch : public SearchEngine {
     int plan_counter;
 
     SearchEngine *current_search;
+    SearchEngine *previous_search;
     std::string current_search_name;
 
     const std::vector<ParseTree> engine_configs;
@@ -23,6 +24,7 @@ class IteratedSearch : public SearchEngine {
     bool repeat_last_phase;
     bool continue_on_fail;
     bool continue_on_solve;
+    bool warm_start;
 
     SearchEngine *get_search_engine(int engine_config_start_index);
     SearchEngine *create_phase(int p);
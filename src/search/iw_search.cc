@@ -0,0 +1,108 @@
+#include "iw_search.h"
+
+#include "globals.h"
+#include "option_parser.h"
+#include "plugin.h"
+#include "state_registry.h"
+#include "successor_generator.h"
+
+using namespace std;
+
+
+IWSearch::IWSearch(const Options &opts)
+    : SearchEngine(opts),
+      novelty_table(opts.get<int>("width")),
+      num_pruned(0)
+{
+}
+
+void IWSearch::initialize()
+{
+    cout << "Conducting IW(" << novelty_table.get_max_novelty()
+         << "), (real) bound = " << bound << endl;
+    succ_data.resize(g_state_packer->get_num_bins());
+
+    const State &initial_state = g_initial_state();
+    novelty_table.compute_and_insert(initial_state);
+    SearchNode node = search_space.get_node(initial_state);
+    node.open_initial(0);
+    if (check_goal_and_set_plan(initial_state)) {
+        return;
+    }
+    queue.push_back(initial_state.get_id());
+}
+
+SearchStatus IWSearch::step()
+{
+    if (found_solution()) {
+        return SOLVED;
+    }
+    if (queue.empty()) {
+        cout << "No novel states left -- no solution found!" << endl;
+        return FAILED;
+    }
+    State state = g_state_registry->lookup_state(queue.front());
+    queue.pop_front();
+    SearchNode node = search_space.get_node(state);
+    node.close();
+    search_progress.inc_expanded();
+
+    applicable_ops.clear();
+    g_successor_generator->generate_applicable_ops(state, applicable_ops);
+    search_progress.inc_generated_ops(applicable_ops.size());
+    for (size_t i = 0; i < applicable_ops.size(); ++i) {
+        const Operator *op = applicable_ops[i];
+        if (node.get_real_g() + op->get_cost() >= bound) {
+            continue;
+        }
+        StateRegistry::compute_successor_data(state, *op, &succ_data[0]);
+        search_progress.inc_generated();
+        if (g_state_registry->find_state_data(&succ_data[0]) !=
+            StateID::no_state) {
+            continue;
+        }
+        int novelty = novelty_table.compute_and_insert(
+            g_state_registry->get_unregistered_state(&succ_data[0]));
+        if (novelty > novelty_table.get_max_novelty()) {
+            ++num_pruned;
+            continue;
+        }
+        State succ_state = g_state_registry->register_state_data(&succ_data[0]);
+        SearchNode succ_node = search_space.get_node(succ_state);
+        succ_node.open(0, node, op);
+        if (check_goal_and_set_plan(succ_state)) {
+            return SOLVED;
+        }
+        queue.push_back(succ_state.get_id());
+    }
+    return IN_PROGRESS;
+}
+
+void IWSearch::statistics() const
+{
+    search_progress.print_statistics();
+    search_space.statistics();
+    cout << "Pruned states (not novel): " << num_pruned << endl;
+}
+
+static SearchEngine *_parse(OptionParser &parser)
+{
+    parser.document_synopsis(
+        "Iterated width search IW(k)",
+        "Breadth-first search that prunes all states with a novelty larger "
+        "than k, i.e., states that do not make an atom (k = 1) or a pair of "
+        "atoms (k = 2) true for the first time. Incomplete.");
+    parser.add_option<int>("width", "maximum novelty k (1 or 2)", "2");
+    SearchEngine::add_options_to_parser(parser);
+    Options opts = parser.parse();
+
+    if (opts.get<int>("width") < 1 || opts.get<int>("width") > 2) {
+        parser.error("width must be 1 or 2");
+    }
+    if (parser.dry_run()) {
+        return 0;
+    }
+    return new IWSearch(opts);
+}
+
+static Plugin<SearchEngine> _plugin("iw", _parse);
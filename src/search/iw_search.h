@@ -0,0 +1,46 @@
+#ifndef IW_SEARCH_H
+#define IW_SEARCH_H
+
+#include "novelty_table.h"
+#include "search_engine.h"
+#include "state.h"
+
+#include <deque>
+#include <vector>
+
+// Usage example: the command line option for using iterated width search
+// with width k is
+// ./fast-downward.py [path-to-PDDL-problem-file] --search "iw(width=k)"
+// So, for IW(2) it is
+// ./fast-downward.py [path-to-PDDL-problem-file] --search "iw(width=2)"
+// Obviously, [path-to-PDDL-problem-file] has to be replaced by the actual path
+// to the PDDL problem file.
+
+/*
+  IW(k) (Lipovetzky & Geffner, 2012): breadth-first search that prunes every
+  generated state whose novelty (see NoveltyTable) is larger than k. Pruned
+  states are not registered. IW(k) is incomplete, but it solves many
+  problems with a single goal atom with k <= 2 in time and memory
+  polynomial in the number of atoms. Goals are tested when states are
+  generated.
+*/
+
+class Options;
+
+class IWSearch : public SearchEngine
+{
+    NoveltyTable novelty_table;
+    std::deque<StateID> queue;
+    std::vector<PackedStateBin> succ_data;
+    std::vector<const Operator *> applicable_ops;
+    int num_pruned;
+protected:
+    virtual void initialize();
+    virtual SearchStatus step();
+public:
+    IWSearch(const Options &opts);
+    virtual ~IWSearch() = default;
+    virtual void statistics() const;
+};
+
+#endif
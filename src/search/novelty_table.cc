@@ -0,0 +1,79 @@
+#include "novelty_table.h"
+
+#include "globals.h"
+#include "state.h"
+
+#include <cassert>
+
+using namespace std;
+
+// Sets the given bit and returns whether it was unset before.
+static inline bool test_and_set(vector<uint64_t> &bits, size_t index) {
+    uint64_t &word = bits[index >> 6];
+    uint64_t mask = uint64_t(1) << (index & 63);
+    bool is_new = !(word & mask);
+    word |= mask;
+    return is_new;
+}
+
+
+NoveltyTable::NoveltyTable(int max_novelty_)
+    : max_novelty(max_novelty_),
+      num_facts(0),
+      state_facts(g_variable_domain.size()) {
+    assert(max_novelty == 1 || max_novelty == 2);
+    fact_offsets.reserve(g_variable_domain.size());
+    for (size_t var = 0; var < g_variable_domain.size(); ++var) {
+        fact_offsets.push_back(num_facts);
+        num_facts += g_variable_domain[var];
+    }
+}
+
+NoveltyTable::Partition &NoveltyTable::get_partition(int partition) {
+    assert(partition >= 0);
+    if (partition >= static_cast<int>(partitions.size()))
+        partitions.resize(partition + 1);
+    Partition &result = partitions[partition];
+    if (result.facts_seen.empty()) {
+        result.facts_seen.resize((num_facts + 63) / 64, 0);
+        if (max_novelty == 2) {
+            size_t num_pairs = size_t(num_facts) * (num_facts - 1) / 2;
+            result.pairs_seen.resize((num_pairs + 63) / 64, 0);
+        }
+    }
+    return result;
+}
+
+int NoveltyTable::compute_and_insert(const State &state, int partition) {
+    Partition &table = get_partition(partition);
+    int num_vars = state_facts.size();
+    int novelty = max_novelty + 1;
+    for (int var = 0; var < num_vars; ++var) {
+        int fact = fact_offsets[var] + state[var];
+        state_facts[var] = fact;
+        if (test_and_set(table.facts_seen, fact))
+            novelty = 1;
+    }
+    if (max_novelty == 2) {
+        // Fact IDs increase with the variable, so fact1 < fact2 below.
+        for (int var2 = 1; var2 < num_vars; ++var2) {
+            size_t fact2 = state_facts[var2];
+            size_t row = fact2 * (fact2 - 1) / 2;
+            for (int var1 = 0; var1 < var2; ++var1) {
+                if (test_and_set(table.pairs_seen, row + state_facts[var1]) &&
+                    novelty > 2)
+                    novelty = 2;
+            }
+        }
+    }
+    return novelty;
+}
+
+size_t NoveltyTable::get_num_partitions() const {
+    size_t result = 0;
+    for (size_t i = 0; i < partitions.size(); ++i) {
+        if (!partitions[i].facts_seen.empty())
+            ++result;
+    }
+    return result;
+}
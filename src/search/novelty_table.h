@@ -0,0 +1,56 @@
+#ifndef NOVELTY_TABLE_H
+#define NOVELTY_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class State;
+
+/*
+  Novelty of states for width-based search (Lipovetzky & Geffner, 2012).
+
+  The novelty of a state is 1 if it makes some atom (var, value) true for
+  the first time, 2 if it makes some pair of atoms true for the first time
+  and max_novelty + 1 if it is not novel up to max_novelty (which is 1 or
+  2). Atoms are numbered consecutively by variable ("fact IDs"), and the
+  table keeps one flat bitset over the fact IDs and, for max_novelty = 2,
+  one over the pairs of fact IDs (in triangular order) for each partition.
+  States are only compared to the earlier states of the same partition
+  (e.g., with the same number of unachieved goals). The bitsets of a
+  partition are allocated when it is first used.
+
+  compute_and_insert needs O(|vars|) time for max_novelty = 1 and
+  O(|vars|^2) for max_novelty = 2 and does not allocate memory once the
+  partition exists.
+*/
+class NoveltyTable {
+    struct Partition {
+        std::vector<uint64_t> facts_seen;
+        std::vector<uint64_t> pairs_seen;
+    };
+
+    int max_novelty;
+    std::vector<int> fact_offsets;
+    int num_facts;
+    std::vector<Partition> partitions;
+    // Fact IDs of the state that is inserted.
+    std::vector<int> state_facts;
+
+    Partition &get_partition(int partition);
+public:
+    explicit NoveltyTable(int max_novelty);
+
+    /*
+      Returns the novelty of the state with respect to the states inserted
+      into the given partition so far and inserts it.
+    */
+    int compute_and_insert(const State &state, int partition = 0);
+
+    int get_max_novelty() const {
+        return max_novelty;
+    }
+    size_t get_num_partitions() const;
+};
+
+#endif
@@ -25,8 +25,6 @@ void Operator::read_pre_post(istream &in) {
 }
 
 Operator::Operator(istream &in, bool axiom) {
-    marked = false;
-
     is_an_axiom = axiom;
     if (!is_an_axiom) {
         check_magic(in, "begin_operator");
@@ -55,8 +53,6 @@ Operator::Operator(istream &in, bool axiom) {
         read_pre_post(in);
         check_magic(in, "end_rule");
     }
-
-    marker1 = marker2 = false;
 }
 
 void Condition::dump() const {
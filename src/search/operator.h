@@ -59,7 +59,6 @@ class Operator {
     std::string name;
     int cost;
 
-    mutable bool marked; // Used for short-term marking of preferred operators
     void read_pre_post(std::istream &in);
 public:
     explicit Operator(std::istream &in, bool is_axiom);
@@ -78,18 +77,6 @@ public:
         return true;
     }
 
-    bool is_marked() const {
-        return marked;
-    }
-    void mark() const {
-        marked = true;
-    }
-    void unmark() const {
-        marked = false;
-    }
-
-    mutable bool marker1, marker2; // HACK! HACK!
-
     int get_cost() const {return cost; }
 };
 
@@ -7,6 +7,7 @@
 
 #include <algorithm>
 #include <iostream>
+#include <sstream>
 #include <string>
 #include <utility>
 #include <vector>
@@ -179,8 +180,9 @@ SearchEngine *OptionParser::parse_cmd_line_aux(
             if (is_last)
                 throw ArgError("missing argument after --random-seed");
             ++i;
-            srand(atoi(args[i].c_str()));
-            g_rng.seed(atoi(args[i].c_str()));
+            g_random_seed = atoi(args[i].c_str());
+            srand(g_random_seed);
+            g_rng.seed(g_random_seed);
             cout << "random seed " << args[i] << endl;
         } else if ((arg.compare("--help") == 0) && dry_run) {
             cout << "Help:" << endl;
@@ -428,6 +430,9 @@ Options OptionParser::parse() {
         }
         last_key = pti->key;
     }
+    ostringstream config;
+    kptree::print_tree_bracketed(parse_tree, config);
+    opts.set_unparsed_config(config.str());
     return opts;
 }
 
@@ -428,8 +428,18 @@ public:
     bool contains(std::string key) const {
         return storage.find(key) != storage.end();
     }
+
+    // The configuration string these options were parsed from.
+    const std::string &get_unparsed_config() const {
+        return unparsed_config;
+    }
+
+    void set_unparsed_config(const std::string &config) {
+        unparsed_config = config;
+    }
 private:
     bool help_mode;
+    std::string unparsed_config;
 };
 
 //TODO: get rid of OptionFlags, instead use default_value = "None" ?
@@ -0,0 +1,198 @@
+#include "parallel_portfolio.h"
+
+#include "globals.h"
+#include "option_parser.h"
+#include "plugin.h"
+#include "rng.h"
+#include "state_registry.h"
+#include "utilities.h"
+
+#include "ext/tree_util.hh"
+
+#include <thread>
+
+using namespace std;
+
+// The option parser is not thread-safe.
+static mutex parse_mutex;
+
+
+ParallelPortfolio::ParallelPortfolio(const Options &opts)
+    : SearchEngine(opts),
+      engine_configs(opts.get_list<ParseTree>("engine_configs")),
+      is_optimal(engine_configs.size(), false),
+      best_bound(bound),
+      optimality_proven(false),
+      best_plan_cost(bound),
+      plan_counter(0),
+      best_member(-1),
+      member_progress(engine_configs.size())
+{
+    vector<int> optimal = opts.get_list<int>("optimal");
+    for (size_t i = 0; i < optimal.size(); ++i) {
+        is_optimal[optimal[i]] = true;
+    }
+}
+
+void ParallelPortfolio::initialize()
+{
+    cout << "Conducting parallel portfolio with " << engine_configs.size()
+         << " engine(s), (real) bound = " << bound << endl;
+    if (has_axioms()) {
+        // The global axiom evaluator keeps scratch data in its members.
+        cerr << "parallel_portfolio does not support axioms!" << endl
+             << "Terminating." << endl;
+        exit_with(EXIT_UNSUPPORTED);
+    }
+    best_bound = bound;
+    best_plan_cost = bound;
+}
+
+SearchStatus ParallelPortfolio::step()
+{
+    vector<thread> threads;
+    for (size_t i = 0; i < engine_configs.size(); ++i) {
+        threads.push_back(thread(&ParallelPortfolio::run_member, this, i));
+    }
+    for (size_t i = 0; i < threads.size(); ++i) {
+        threads[i].join();
+    }
+
+    for (size_t i = 0; i < member_progress.size(); ++i) {
+        const SearchProgress &progress = member_progress[i];
+        search_progress.inc_expanded(progress.get_expanded());
+        search_progress.inc_evaluated_states(progress.get_evaluated_states());
+        search_progress.inc_evaluations(progress.get_evaluations());
+        search_progress.inc_generated(progress.get_generated());
+        search_progress.inc_generated_ops(progress.get_generated_ops());
+        search_progress.inc_reopened(progress.get_reopened());
+    }
+    return found_solution() ? SOLVED : FAILED;
+}
+
+void ParallelPortfolio::run_member(int id)
+{
+    StateRegistry registry;
+    g_state_registry = &registry;
+    // Reproducible for a given seed, but different for each member.
+    g_rng.seed(g_random_seed + id);
+
+    SearchEngine *engine;
+    {
+        lock_guard<mutex> lock(parse_mutex);
+        OptionParser parser(engine_configs[id], false);
+        engine = parser.start_parsing<SearchEngine *>();
+        cout << "Starting search " << id << ": ";
+        kptree::print_tree_bracketed(engine_configs[id], cout);
+        cout << endl;
+    }
+    engine->share_bound(&best_bound, &optimality_proven);
+    engine->search();
+
+    {
+        lock_guard<mutex> lock(result_mutex);
+        cout << "Statistics of search " << id << ":" << endl;
+        engine->statistics();
+        member_progress[id] = engine->get_search_progress();
+        if (engine->found_solution()) {
+            const Plan &member_plan = engine->get_plan();
+            int plan_cost = calculate_plan_cost(member_plan);
+            cout << "Search " << id << " found a plan with cost "
+                 << plan_cost << endl;
+            if (plan_cost < best_plan_cost) {
+                best_plan_cost = plan_cost;
+                best_member = id;
+                set_plan(member_plan);
+                save_plan(member_plan, ++plan_counter);
+            }
+        }
+        SearchStatus status = engine->get_status();
+        if (is_optimal[id] && (status == SOLVED || status == FAILED) &&
+            !optimality_proven) {
+            cout << "Search " << id << " proved that ";
+            // A running engine may have published a cheaper plan already.
+            if (best_bound < bound) {
+                cout << "the best plan is optimal";
+            } else {
+                cout << "no plan exists within the bound";
+            }
+            cout << " -- stopping all searches" << endl;
+            optimality_proven = true;
+        }
+    }
+
+    // Destroy the engine while its registry still exists.
+    delete engine;
+    g_state_registry = 0;
+}
+
+void ParallelPortfolio::statistics() const
+{
+    cout << "Cumulative statistics:" << endl;
+    search_progress.print_statistics();
+    if (found_solution()) {
+        cout << "Best plan found by search " << best_member << endl;
+    }
+}
+
+void ParallelPortfolio::save_plan_if_necessary() const
+{
+    // Every improved plan has already been saved.
+}
+
+static SearchEngine *_parse(OptionParser &parser)
+{
+    parser.document_synopsis(
+        "Parallel portfolio",
+        "Runs all search engines at the same time, each in its own thread "
+        "with its own state registry and heuristics. The cost of the best "
+        "plan found so far is the bound for all engines.");
+    parser.document_note(
+        "Plan files",
+        "The i-th improved plan is written to sas_plan.i.");
+    parser.document_note(
+        "Predefined heuristics",
+        "The engines cannot use predefined heuristics, since heuristic "
+        "objects are not shared between threads.");
+    parser.add_list_option<ParseTree>("engine_configs",
+                                      "search engines that run in parallel");
+    parser.add_list_option<int>(
+        "optimal",
+        "indices (starting at 0) of the engines that only find optimal plans "
+        "and fail only if there is no plan within the bound. When one of "
+        "them finishes, all other engines are stopped.", "[]");
+    SearchEngine::add_options_to_parser(parser);
+    Options opts = parser.parse();
+
+    opts.verify_list_non_empty<ParseTree>("engine_configs");
+    vector<ParseTree> configs = opts.get_list<ParseTree>("engine_configs");
+    vector<int> optimal = opts.get_list<int>("optimal");
+    for (size_t i = 0; i < optimal.size(); ++i) {
+        if (optimal[i] < 0 || optimal[i] >= static_cast<int>(configs.size())) {
+            parser.error("optimal contains an invalid engine index");
+        }
+    }
+    if (parser.help_mode()) {
+        return 0;
+    }
+    for (size_t i = 0; i < configs.size(); ++i) {
+        for (ParseTree::iterator it = configs[i].begin();
+             it != configs[i].end(); ++it) {
+            if (Predefinitions<Heuristic *>::instance()->contains(it->value)) {
+                parser.error("parallel_portfolio cannot use the predefined "
+                             "heuristic " + it->value);
+            }
+        }
+    }
+    if (parser.dry_run()) {
+        // Check if the search engines can be parsed.
+        for (size_t i = 0; i < configs.size(); ++i) {
+            OptionParser test_parser(configs[i], true);
+            test_parser.start_parsing<SearchEngine *>();
+        }
+        return 0;
+    }
+    return new ParallelPortfolio(opts);
+}
+
+static Plugin<SearchEngine> _plugin("parallel_portfolio", _parse);
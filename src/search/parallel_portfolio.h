@@ -0,0 +1,68 @@
+#ifndef PARALLEL_PORTFOLIO_H
+#define PARALLEL_PORTFOLIO_H
+
+#include "option_parser_util.h"
+#include "search_engine.h"
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+// Usage example: the command line option for running the search engines
+// e1, ..., en at the same time, where e1 is optimal, is
+// ./fast-downward.py [path-to-PDDL-problem-file] --search "parallel_portfolio([e1(), ..., en()], optimal=[0])"
+// So, for greedy search with h^{FF} next to A* with LM-cut it is
+// ./fast-downward.py [path-to-PDDL-problem-file] --search "parallel_portfolio([wastar(ff(), w=100), wastar(lmcut())], optimal=[1])"
+// Obviously, [path-to-PDDL-problem-file] has to be replaced by the actual path
+// to the PDDL problem file.
+
+/*
+  Parallel portfolio: runs every engine configuration in its own thread.
+
+  The threads share the (read-only) task representation in globals.h, but
+  each has its own state registry (g_state_registry is thread-local) and
+  parses its own engine and heuristics. The random number generator g_rng
+  of member i is seeded with the random seed plus i. The parsing itself is serialized
+  because the option parser writes to global documentation data.
+
+  The real cost of the best plan found so far is shared atomically: each
+  engine publishes the cost of every plan as soon as it finds it and uses
+  the shared value as its bound before each step (see
+  SearchEngine::share_bound). The plans themselves are collected when the
+  engines finish. An engine listed in "optimal" proves that the
+  best plan is optimal when it finishes, whether it found a plan or not;
+  all other engines are then interrupted.
+*/
+
+class Options;
+
+class ParallelPortfolio : public SearchEngine
+{
+    const std::vector<ParseTree> engine_configs;
+    std::vector<bool> is_optimal;
+
+    std::atomic<int> best_bound;
+    std::atomic<bool> optimality_proven;
+
+    // Protects the plan, best_plan_cost, plan_counter, member_progress and
+    // the output of the member statistics.
+    std::mutex result_mutex;
+    // Real cost of the plan of the portfolio; best_bound can be lower while
+    // the engine that found a cheaper plan is still running.
+    int best_plan_cost;
+    int plan_counter;
+    int best_member;
+    std::vector<SearchProgress> member_progress;
+
+    void run_member(int id);
+protected:
+    virtual void initialize();
+    virtual SearchStatus step();
+public:
+    ParallelPortfolio(const Options &opts);
+    virtual ~ParallelPortfolio() = default;
+    virtual void statistics() const;
+    virtual void save_plan_if_necessary() const;
+};
+
+#endif
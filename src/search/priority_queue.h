@@ -3,6 +3,7 @@
 
 #include "utilities.h"
 
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 #include <queue>
@@ -10,9 +11,10 @@
 #include <vector>
 
 /*
-  We define three priority queue classes here: HeapQueue (heap-based),
-  BucketQueue (bucket-based), and AdaptiveQueue (starts out bucket-based,
-  transforms into heap-based if that seems to make sense).
+  We define four priority queue classes here: HeapQueue (heap-based),
+  BucketQueue (bucket-based), AdaptiveQueue (starts out bucket-based,
+  transforms into heap-based if that seems to make sense) and RadixQueue
+  (monotone radix heap).
 
   More precisely, an AdaptiveQueue is converted from a BucketQueue to
   a HeapQueue when the number of required buckets exceeds both
@@ -266,4 +268,83 @@ public:
     }
 };
 
+
+/*
+  Radix heap (Ahuja et al., 1990) for Dijkstra-like explorations: the keys
+  are non-negative and no key may be smaller than the key of the last
+  popped entry. An entry is in bucket b > 0 if bit b - 1 is the highest
+  bit in which its key differs from that key (and in bucket 0 if the keys
+  are equal), so push is O(1) and each entry moves to a lower bucket at
+  most 32 times. Unlike AdaptiveQueue, it has no key
+  range that makes it switch representations, and it can be copied.
+*/
+template<typename Value>
+class RadixQueue {
+public:
+    typedef std::pair<int, Value> Entry;
+private:
+    static const int NUM_BUCKETS = 32;
+
+    std::vector<Entry> buckets[NUM_BUCKETS];
+    int last_key;
+    int num_entries;
+
+    // Number of significant bits of x.
+    static int get_bit_length(unsigned int x) {
+        int length = 0;
+        for (int shift = 16; shift > 0; shift /= 2) {
+            if (x >> shift) {
+                length += shift;
+                x >>= shift;
+            }
+        }
+        return length + x;
+    }
+
+    int get_bucket(int key) const {
+        return get_bit_length(static_cast<unsigned int>(key ^ last_key));
+    }
+public:
+    RadixQueue() : last_key(0), num_entries(0) {
+    }
+
+    void push(int key, const Value &value) {
+        assert(key >= last_key);
+        ++num_entries;
+        buckets[get_bucket(key)].push_back(std::make_pair(key, value));
+    }
+
+    Entry pop() {
+        assert(num_entries > 0);
+        --num_entries;
+        if (buckets[0].empty()) {
+            int bucket_no = 1;
+            while (buckets[bucket_no].empty())
+                ++bucket_no;
+            std::vector<Entry> &bucket = buckets[bucket_no];
+            int min_key = bucket[0].first;
+            for (size_t i = 1; i < bucket.size(); ++i)
+                min_key = std::min(min_key, bucket[i].first);
+            last_key = min_key;
+            for (size_t i = 0; i < bucket.size(); ++i)
+                buckets[get_bucket(bucket[i].first)].push_back(bucket[i]);
+            bucket.clear();
+        }
+        Entry result = buckets[0].back();
+        buckets[0].pop_back();
+        return result;
+    }
+
+    bool empty() const {
+        return num_entries == 0;
+    }
+
+    void clear() {
+        for (int i = 0; i < NUM_BUCKETS; ++i)
+            buckets[i].clear();
+        last_key = 0;
+        num_entries = 0;
+    }
+};
+
 #endif
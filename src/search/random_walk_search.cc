@@ -0,0 +1,261 @@
+#include "random_walk_search.h"
+
+#include "globals.h"
+#include "heuristic.h"
+#include "option_parser.h"
+#include "plugin.h"
+#include "rng.h"
+#include "state_registry.h"
+#include "successor_generator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace std;
+
+static const int INF = numeric_limits<int>::max();
+
+
+RandomWalkSearch::RandomWalkSearch(const Options &opts)
+    : SearchEngine(opts),
+      heuristic(opts.get<Heuristic *>("eval")),
+      num_walks(opts.get<int>("walks")),
+      initial_length(opts.get<int>("length")),
+      length_factor(opts.get<double>("length_factor")),
+      restart_after(opts.get<int>("restart_after")),
+      random_seed(opts.get<int>("random_seed")),
+      current_real_g(0),
+      current_h(INF),
+      initial_h(INF),
+      h_min(INF),
+      steps_without_progress(0),
+      length(initial_length),
+      best_endpoint_h(INF),
+      num_walks_run(0),
+      num_restarts(0),
+      best_h_ever(INF)
+{
+}
+
+void RandomWalkSearch::initialize()
+{
+    cout << "Conducting random walk search with " << num_walks
+         << " walks per step, (real) bound = " << bound << endl;
+    if (random_seed != -1) {
+        g_rng.seed(random_seed);
+    }
+    search_progress.add_heuristic(heuristic);
+
+    int num_bins = g_state_packer->get_num_bins();
+    current_data.resize(num_bins);
+    walk_data[0].resize(num_bins);
+    walk_data[1].resize(num_bins);
+    best_endpoint_data.resize(num_bins);
+
+    StateRegistry::compute_initial_state_data(&current_data[0]);
+    State initial_state =
+        g_state_registry->get_unregistered_state(&current_data[0]);
+    heuristic->evaluate(initial_state);
+    search_progress.inc_evaluated_states();
+    search_progress.inc_evaluations();
+    if (heuristic->is_dead_end()) {
+        cout << "Initial state is a dead end." << endl;
+        return;
+    }
+    search_progress.get_initial_h_values();
+    if (test_goal(initial_state)) {
+        cout << "Solution found!" << endl;
+        set_plan(Plan());
+        return;
+    }
+    initial_h = heuristic->get_heuristic();
+    best_h_ever = initial_h;
+    restart();
+}
+
+void RandomWalkSearch::restart()
+{
+    StateRegistry::compute_initial_state_data(&current_data[0]);
+    current_path.clear();
+    current_real_g = 0;
+    current_h = initial_h;
+    h_min = initial_h;
+    steps_without_progress = 0;
+    length = initial_length;
+}
+
+/*
+  Runs a walk of at most max_length steps from the current state and
+  remembers its endpoint if it is the best one of this step. Returns true
+  if the walk reached a goal.
+*/
+bool RandomWalkSearch::run_walk(int max_length)
+{
+    ++num_walks_run;
+    copy(current_data.begin(), current_data.end(), walk_data[0].begin());
+    int buffer = 0;
+    State state = g_state_registry->get_unregistered_state(&walk_data[0][0]);
+    int real_g = current_real_g;
+    walk_ops.clear();
+    for (int i = 0; i < max_length; ++i) {
+        applicable_ops.clear();
+        g_successor_generator->generate_applicable_ops(state, applicable_ops);
+        search_progress.inc_expanded();
+        search_progress.inc_generated_ops(applicable_ops.size());
+        if (applicable_ops.empty()) {
+            // Dead end: the endpoint is not considered.
+            return false;
+        }
+        const Operator *op = applicable_ops[g_rng(applicable_ops.size())];
+        if (real_g + op->get_cost() >= bound) {
+            break;
+        }
+        StateRegistry::compute_successor_data(state, *op,
+                                              &walk_data[1 - buffer][0]);
+        buffer = 1 - buffer;
+        state = g_state_registry->get_unregistered_state(&walk_data[buffer][0]);
+        search_progress.inc_generated();
+        walk_ops.push_back(op);
+        real_g += op->get_cost();
+        if (test_goal(state)) {
+            cout << "Solution found!" << endl;
+            Plan plan(current_path);
+            plan.insert(plan.end(), walk_ops.begin(), walk_ops.end());
+            set_plan(plan);
+            return true;
+        }
+    }
+    if (walk_ops.empty()) {
+        return false;
+    }
+
+    heuristic->evaluate(state);
+    search_progress.inc_evaluated_states();
+    search_progress.inc_evaluations();
+    if (heuristic->is_dead_end()) {
+        search_progress.inc_dead_ends();
+        return false;
+    }
+    int h = heuristic->get_heuristic();
+    if (h < best_endpoint_h) {
+        best_endpoint_h = h;
+        best_walk_ops.swap(walk_ops);
+        copy(walk_data[buffer].begin(), walk_data[buffer].end(),
+             best_endpoint_data.begin());
+    }
+    return false;
+}
+
+SearchStatus RandomWalkSearch::step()
+{
+    if (found_solution()) {
+        return SOLVED;
+    }
+    if (initial_h == INF) {
+        return FAILED;
+    }
+
+    best_endpoint_h = INF;
+    best_walk_ops.clear();
+    int max_length = static_cast<int>(ceil(length));
+    for (int walk = 0; walk < num_walks; ++walk) {
+        if (run_walk(max_length)) {
+            return SOLVED;
+        }
+        if (best_endpoint_h < h_min) {
+            break;
+        }
+    }
+
+    if (best_endpoint_h != INF) {
+        // Jump to the best endpoint.
+        current_path.insert(current_path.end(), best_walk_ops.begin(),
+                            best_walk_ops.end());
+        for (size_t i = 0; i < best_walk_ops.size(); ++i) {
+            current_real_g += best_walk_ops[i]->get_cost();
+        }
+        current_data.swap(best_endpoint_data);
+        current_h = best_endpoint_h;
+    }
+    if (current_h < h_min) {
+        h_min = current_h;
+        steps_without_progress = 0;
+        length = initial_length;
+        if (h_min < best_h_ever) {
+            best_h_ever = h_min;
+            cout << "Best heuristic value: " << best_h_ever << " [walks "
+                 << num_walks_run << ", restarts " << num_restarts << ", t="
+                 << g_timer << "]" << endl;
+        }
+    } else {
+        ++steps_without_progress;
+        length *= length_factor;
+        if (steps_without_progress >= restart_after) {
+            ++num_restarts;
+            restart();
+        }
+    }
+    return IN_PROGRESS;
+}
+
+void RandomWalkSearch::statistics() const
+{
+    search_progress.print_statistics();
+    cout << "Random walks: " << num_walks_run << endl;
+    cout << "Restarts: " << num_restarts << endl;
+}
+
+static SearchEngine *_parse(OptionParser &parser)
+{
+    parser.document_synopsis(
+        "Monte-Carlo random walk search",
+        "Runs bursts of random walks from the current state, evaluates the "
+        "heuristic only at the endpoints and jumps to the best endpoint. "
+        "Restarts from the initial state if the search makes no progress. "
+        "Incomplete; the plans are usually far from optimal.");
+    parser.document_note(
+        "Heuristics",
+        "States are not registered, so heuristics that store information "
+        "per state or rely on reach_state are not supported.");
+    parser.add_option<Heuristic *>("eval", "heuristic");
+    parser.add_option<int>("walks", "maximum number of walks per step",
+                           "2000");
+    parser.add_option<int>("length", "initial length of the walks", "10");
+    parser.add_option<double>(
+        "length_factor",
+        "factor by which the walk length grows after a step without progress",
+        "1.5");
+    parser.add_option<int>(
+        "restart_after",
+        "number of steps without progress after which the search restarts",
+        "7");
+    parser.add_option<int>(
+        "random_seed",
+        "seed for g_rng at the start of the search (-1 keeps the current "
+        "state of g_rng, e.g. the one set with --random-seed)",
+        "-1");
+    SearchEngine::add_options_to_parser(parser);
+    Options opts = parser.parse();
+
+    if (opts.get<int>("walks") < 1 || opts.get<int>("length") < 1 ||
+        opts.get<int>("restart_after") < 1) {
+        parser.error("walks, length and restart_after must be positive");
+    }
+    if (opts.get<double>("length_factor") < 1) {
+        parser.error("length_factor must be at least 1");
+    }
+    if (opts.get<int>("random_seed") < -1) {
+        parser.error("random_seed must be -1 or non-negative");
+    }
+    if (parser.dry_run()) {
+        return 0;
+    }
+    if (opts.get<Heuristic *>("eval")->is_path_dependent()) {
+        parser.error("random_walks does not support heuristics that depend on the "
+                     "path to a state");
+    }
+    return new RandomWalkSearch(opts);
+}
+
+static Plugin<SearchEngine> _plugin("random_walks", _parse);
@@ -0,0 +1,83 @@
+#ifndef RANDOM_WALK_SEARCH_H
+#define RANDOM_WALK_SEARCH_H
+
+#include "search_engine.h"
+#include "state.h"
+
+#include <vector>
+
+// Usage example: the command line option for using Monte-Carlo random walks
+// with heuristic h is
+// ./fast-downward.py [path-to-PDDL-problem-file] --search "random_walks(h())"
+// So, for h^{FF}, 500 walks per step and seed 42 it is
+// ./fast-downward.py [path-to-PDDL-problem-file] --search "random_walks(ff(), walks=500, random_seed=42)"
+// Obviously, [path-to-PDDL-problem-file] has to be replaced by the actual path
+// to the PDDL problem file.
+
+/*
+  Monte-Carlo random walk search (Nakhost & Mueller, 2009, "Arvand").
+
+  Each step runs a burst of random walks from the current state. A walk
+  applies uniformly chosen applicable operators (drawn from g_rng) and the
+  heuristic is only evaluated at its endpoint. After the burst, the search
+  jumps to the endpoint with the smallest h-value, i.e., the walk is
+  appended to the current path. The burst ends early as soon as an endpoint
+  improves on the smallest h-value seen since the last restart, so the
+  number of walks adapts to the progress. The walk length grows by
+  length_factor after each step without progress and is reset when the
+  search makes progress. After restart_after steps without progress, the
+  search restarts from the initial state. A goal is tested after every
+  operator of a walk.
+
+  Walks run on two scratch buffers of packed state data. No state is
+  registered, so the memory needed is independent of the number of
+  states generated.
+*/
+
+class Heuristic;
+class Options;
+
+class RandomWalkSearch : public SearchEngine
+{
+    Heuristic *heuristic;
+    const int num_walks;
+    const int initial_length;
+    const double length_factor;
+    const int restart_after;
+    const int random_seed;
+
+    // Path to the current state and its packed data.
+    Plan current_path;
+    int current_real_g;
+    std::vector<PackedStateBin> current_data;
+    int current_h;
+    int initial_h;
+    // Smallest h-value of a jump target since the last restart.
+    int h_min;
+    int steps_without_progress;
+    double length;
+
+    // Scratch data of the walk that is running and the best endpoint.
+    std::vector<PackedStateBin> walk_data[2];
+    Plan walk_ops;
+    std::vector<PackedStateBin> best_endpoint_data;
+    Plan best_walk_ops;
+    int best_endpoint_h;
+    std::vector<const Operator *> applicable_ops;
+
+    int num_walks_run;
+    int num_restarts;
+    int best_h_ever;
+
+    void restart();
+    bool run_walk(int max_length);
+protected:
+    virtual void initialize();
+    virtual SearchStatus step();
+public:
+    RandomWalkSearch(const Options &opts);
+    virtual ~RandomWalkSearch() = default;
+    virtual void statistics() const;
+};
+
+#endif
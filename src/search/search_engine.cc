@@ -5,6 +5,7 @@
 #include "operator_cost.h"
 #include "option_parser.h"
 
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 #include <limits>
@@ -15,6 +16,8 @@ using namespace std;
 SearchEngine::SearchEngine(const Options &opts)
     : status(IN_PROGRESS),
       solution_found(false),
+      shared_bound(0),
+      interrupt(0),
       search_space(OperatorCost(opts.get_enum("cost_type"))),
       cost_type(OperatorCost(opts.get_enum("cost_type"))),
       max_time(opts.get<double>("max_time")) {
@@ -47,12 +50,36 @@ const SearchEngine::Plan &SearchEngine::get_plan() const {
 void SearchEngine::set_plan(const Plan &p) {
     solution_found = true;
     plan = p;
+    if (shared_bound) {
+        // Anytime engines find several plans before they finish.
+        int plan_cost = calculate_plan_cost(plan);
+        int current = shared_bound->load();
+        while (plan_cost < current &&
+               !shared_bound->compare_exchange_weak(current, plan_cost)) {
+        }
+    }
+}
+
+void SearchEngine::share_bound(atomic<int> *shared_bound_,
+                               const atomic<bool> *interrupt_) {
+    shared_bound = shared_bound_;
+    interrupt = interrupt_;
 }
 
 void SearchEngine::search() {
+    if (shared_bound)
+        bound = min(bound, shared_bound->load());
     initialize();
     CountdownTimer timer(max_time);
     while (status == IN_PROGRESS) {
+        if (shared_bound) {
+            bound = min(bound, shared_bound->load());
+            if (interrupt->load()) {
+                cout << "Search interrupted." << endl;
+                status = TIMEOUT;
+                break;
+            }
+        }
         status = step();
         if (timer.is_expired()) {
             cout << "Time limit reached. Abort search." << endl;
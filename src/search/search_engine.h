@@ -1,6 +1,7 @@
 #ifndef SEARCH_ENGINE_H
 #define SEARCH_ENGINE_H
 
+#include <atomic>
 #include <vector>
 
 class Heuristic;
@@ -21,6 +22,8 @@ private:
     SearchStatus status;
     bool solution_found;
     Plan plan;
+    std::atomic<int> *shared_bound;
+    const std::atomic<bool> *interrupt;
 protected:
     SearchSpace search_space;
     SearchProgress search_progress;
@@ -44,6 +47,31 @@ public:
     SearchStatus get_status() const;
     const Plan &get_plan() const;
     void search();
+    /*
+      Called before search() to continue from the finished search of the
+      previous phase of an iterated search, e.g. by taking over its open and
+      closed lists. Returns false if this engine cannot do that.
+    */
+    virtual bool warm_start(const SearchEngine & /*previous*/) {
+        return false;
+    }
+    /*
+      Returns true if a new engine with the same configuration can continue
+      from this finished search with warm_start() (e.g., a beam search that
+      was cut off, with a wider beam). Iterated search only repeats a failed
+      last phase if this is the case.
+    */
+    virtual bool can_continue() const {
+        return false;
+    }
+    /*
+      Used by parallel portfolios: before each step, the bound is lowered to
+      the value of shared_bound (the cost of the best plan any engine has
+      found so far), and the search stops with TIMEOUT once interrupt is set.
+      The real cost of every plan found is published to shared_bound at once.
+    */
+    void share_bound(std::atomic<int> *shared_bound,
+                     const std::atomic<bool> *interrupt);
     SearchProgress get_search_progress() const {return search_progress; }
     void set_bound(int b) {bound = b; }
     int get_bound() {return bound; }
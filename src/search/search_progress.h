@@ -57,6 +57,7 @@ public:
     int get_generated() const {return generated_states; }
     int get_reopened() const {return reopened_states; }
     int get_generated_ops() const {return generated_ops; }
+    int get_dead_ends() const {return dead_end_states; }
     int get_pathmax_corrections() const {return pathmax_corrections; }
 
     // f-value
@@ -162,6 +162,16 @@ SearchNode SearchSpace::get_node(const State &state)
     return SearchNode(state.get_id(), search_node_infos[state], cost_type);
 }
 
+void SearchSpace::copy_from(const SearchSpace &other)
+{
+    assert(cost_type == other.cost_type);
+    for (StateRegistry::const_iterator it = g_state_registry->begin();
+         it != g_state_registry->end(); ++it) {
+        State state = g_state_registry->lookup_state(*it);
+        search_node_infos[state] = other.search_node_infos[state];
+    }
+}
+
 void SearchSpace::trace_path(const State &goal_state,
                              vector<const Operator *> &path) const
 {
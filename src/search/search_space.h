@@ -58,6 +58,8 @@ class SearchSpace {
 public:
     SearchSpace(OperatorCost cost_type_);
     SearchNode get_node(const State &state);
+    // Copies the nodes of all states of the global registry from other.
+    void copy_from(const SearchSpace &other);
     void trace_path(const State &goal_state,
                     std::vector<const Operator *> &path) const;
 
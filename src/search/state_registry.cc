@@ -4,6 +4,8 @@
 #include "operator.h"
 #include "per_state_information.h"
 
+#include <algorithm>
+
 using namespace std;
 
 StateRegistry::StateRegistry()
@@ -47,10 +49,7 @@ State StateRegistry::lookup_state(StateID id) const {
 const State &StateRegistry::get_initial_state() {
     if (cached_initial_state == 0) {
         PackedStateBin *buffer = new PackedStateBin[g_state_packer->get_num_bins()];
-        for (size_t i = 0; i < g_initial_state_data.size(); ++i) {
-            g_state_packer->set(buffer, i, g_initial_state_data[i]);
-        }
-        g_axiom_evaluator->evaluate(buffer);
+        compute_initial_state_data(buffer);
         state_data_pool.push_back(buffer);
         // buffer is copied by push_back
         delete[] buffer;
@@ -67,14 +66,57 @@ State StateRegistry::get_successor_state(const State &predecessor, const Operato
     assert(!op.is_axiom());
     state_data_pool.push_back(predecessor.get_packed_buffer());
     PackedStateBin *buffer = state_data_pool[state_data_pool.size() - 1];
+    apply_effects(predecessor, op, buffer);
+    StateID id = insert_id_or_pop_state();
+    return lookup_state(id);
+}
+
+State StateRegistry::register_state_data(const PackedStateBin *buffer) {
+    state_data_pool.push_back(buffer);
+    StateID id = insert_id_or_pop_state();
+    return lookup_state(id);
+}
+
+State StateRegistry::get_unregistered_state(const PackedStateBin *buffer) const {
+    return State(buffer, *this, StateID::no_state);
+}
+
+StateID StateRegistry::find_state_data(const PackedStateBin *buffer) {
+    // The hash set can only look up states that are in the data pool.
+    state_data_pool.push_back(buffer);
+    StateID candidate(state_data_pool.size() - 1);
+    StateIDSet::const_iterator it = registered_states.find(candidate);
+    StateID result = (it == registered_states.end()) ? StateID::no_state : *it;
+    state_data_pool.pop_back();
+    return result;
+}
+
+void StateRegistry::compute_initial_state_data(PackedStateBin *buffer) {
+    for (size_t i = 0; i < g_initial_state_data.size(); ++i) {
+        g_state_packer->set(buffer, i, g_initial_state_data[i]);
+    }
+    g_axiom_evaluator->evaluate(buffer);
+}
+
+void StateRegistry::compute_successor_data(const State &predecessor,
+                                           const Operator &op,
+                                           PackedStateBin *buffer) {
+    assert(!op.is_axiom());
+    const PackedStateBin *predecessor_data = predecessor.get_packed_buffer();
+    copy(predecessor_data, predecessor_data + g_state_packer->get_num_bins(),
+         buffer);
+    apply_effects(predecessor, op, buffer);
+}
+
+// Expects buffer to hold the data of predecessor.
+void StateRegistry::apply_effects(const State &predecessor, const Operator &op,
+                                  PackedStateBin *buffer) {
     for (size_t i = 0; i < op.get_effects().size(); ++i) {
         const Effect &effect = op.get_effects()[i];
         if (effect.does_fire(predecessor))
             g_state_packer->set(buffer, effect.var, effect.val);
     }
     g_axiom_evaluator->evaluate(buffer);
-    StateID id = insert_id_or_pop_state();
-    return lookup_state(id);
 }
 
 void StateRegistry::subscribe(PerStateInformationBase *psi) const {
@@ -145,6 +145,8 @@ class StateRegistry
     State *cached_initial_state;
     mutable std::set<PerStateInformationBase *> subscribers;
     StateID insert_id_or_pop_state();
+    static void apply_effects(const State &predecessor, const Operator &op,
+                              PackedStateBin *buffer);
 public:
     StateRegistry();
     ~StateRegistry();
@@ -168,6 +170,40 @@ public:
     */
     State get_successor_state(const State &predecessor, const Operator &op);
 
+    /*
+      Registers the state whose packed data is given in buffer (the data is
+      copied) and returns it. Together with the two functions below, this
+      allows search algorithms to compute state data outside of a registry,
+      e.g. to decide which of several registries a state belongs to.
+    */
+    State register_state_data(const PackedStateBin *buffer);
+
+    /*
+      Returns a state for the packed data in buffer without registering it.
+      The state has the ID StateID::no_state, so it must not be used with
+      PerStateInformation, and buffer must outlive it. This allows search
+      algorithms that do not store states (e.g., IDA*) to evaluate states
+      and generate their successors without growing a registry.
+    */
+    State get_unregistered_state(const PackedStateBin *buffer) const;
+
+    /*
+      Returns the ID of the state whose packed data is given in buffer if it
+      is registered in this registry and StateID::no_state otherwise. Does
+      not register the state.
+    */
+    StateID find_state_data(const PackedStateBin *buffer);
+
+    /*
+      Write the packed data of the initial state or of the successor of
+      predecessor under op into buffer, which must have room for
+      g_state_packer->get_num_bins() bins. Nothing is registered.
+    */
+    static void compute_initial_state_data(PackedStateBin *buffer);
+    static void compute_successor_data(const State &predecessor,
+                                       const Operator &op,
+                                       PackedStateBin *buffer);
+
     /*
       Returns the number of states registered so far.
     */
@@ -176,6 +212,53 @@ public:
         return registered_states.size();
     }
 
+    /*
+      Iterates over the IDs of all registered states in the order in which
+      they were registered. Registering states while iterating is allowed;
+      the new states are visited if end() is called again.
+    */
+    class const_iterator
+    {
+        friend class StateRegistry;
+        StateID pos;
+
+        explicit const_iterator(int start)
+            : pos(start)
+        {
+        }
+    public:
+        const_iterator &operator++()
+        {
+            ++pos.value;
+            return *this;
+        }
+
+        bool operator==(const const_iterator &rhs) const
+        {
+            return pos == rhs.pos;
+        }
+
+        bool operator!=(const const_iterator &rhs) const
+        {
+            return !(*this == rhs);
+        }
+
+        StateID operator*() const
+        {
+            return pos;
+        }
+    };
+
+    const_iterator begin() const
+    {
+        return const_iterator(0);
+    }
+
+    const_iterator end() const
+    {
+        return const_iterator(size());
+    }
+
     /*
       Remembers the given PerStateInformation. If this StateRegistry is
       destroyed, it notifies all subscribed PerStateInformation objects.
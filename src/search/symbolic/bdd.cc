@@ -0,0 +1,529 @@
+#include "bdd.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <limits>
+
+using namespace std;
+
+// Kinds of cached operations. The cache key is kind | (ID << 3).
+enum {
+    OP_AND = 0,
+    OP_OR = 1,
+    OP_AND_NOT = 2,
+    OP_NOT = 3,
+    OP_EXISTS = 4,
+    OP_AND_EXISTS = 5,
+    OP_RENAME = 6
+};
+
+static const int FALSE_NODE = 0;
+static const int TRUE_NODE = 1;
+
+static inline size_t hash_triple(size_t a, size_t b, size_t c) {
+    size_t h = a * 12582917u;
+    h = (h ^ b) * 4256249u;
+    h = (h ^ c) * 741457u;
+    return h ^ (h >> 17);
+}
+
+
+Bdd::Bdd()
+    : manager(0), node(FALSE_NODE) {
+}
+
+Bdd::Bdd(BddManager *manager_, int node_)
+    : manager(manager_), node(node_) {
+    manager->ref(node);
+}
+
+Bdd::Bdd(const Bdd &other)
+    : manager(other.manager), node(other.node) {
+    if (manager)
+        manager->ref(node);
+}
+
+Bdd::~Bdd() {
+    if (manager)
+        manager->deref(node);
+}
+
+Bdd &Bdd::operator=(const Bdd &other) {
+    if (other.manager)
+        other.manager->ref(other.node);
+    if (manager)
+        manager->deref(node);
+    manager = other.manager;
+    node = other.node;
+    return *this;
+}
+
+Bdd Bdd::operator&(const Bdd &other) const {
+    assert(manager && manager == other.manager);
+    manager->collect_garbage_if_needed();
+    return Bdd(manager, manager->apply(OP_AND, node, other.node));
+}
+
+Bdd Bdd::operator|(const Bdd &other) const {
+    assert(manager && manager == other.manager);
+    manager->collect_garbage_if_needed();
+    return Bdd(manager, manager->apply(OP_OR, node, other.node));
+}
+
+Bdd Bdd::operator-(const Bdd &other) const {
+    assert(manager && manager == other.manager);
+    manager->collect_garbage_if_needed();
+    return Bdd(manager, manager->apply(OP_AND_NOT, node, other.node));
+}
+
+Bdd Bdd::operator!() const {
+    assert(manager);
+    manager->collect_garbage_if_needed();
+    return Bdd(manager, manager->negate(node));
+}
+
+Bdd &Bdd::operator&=(const Bdd &other) {
+    return *this = *this & other;
+}
+
+Bdd &Bdd::operator|=(const Bdd &other) {
+    return *this = *this | other;
+}
+
+size_t Bdd::get_num_nodes() const {
+    assert(manager);
+    return manager->count_nodes(node);
+}
+
+
+BddManager::BddManager(int num_vars_, int cache_size, size_t gc_threshold_)
+    : num_vars(num_vars_),
+      free_list(-1),
+      num_free_nodes(0),
+      gc_threshold(gc_threshold_),
+      current_stamp(0),
+      peak_num_nodes(2),
+      num_garbage_collections(0),
+      num_cache_lookups(0),
+      num_cache_hits(0) {
+    assert(cache_size > 0);
+    Node terminal = {num_vars, FALSE_NODE, FALSE_NODE, -1};
+    nodes.push_back(terminal);
+    terminal.low = terminal.high = TRUE_NODE;
+    nodes.push_back(terminal);
+    // Terminals are never collected.
+    ref_counts.resize(2, numeric_limits<int>::max() / 2);
+    unique_table.resize(1024, -1);
+
+    size_t real_cache_size = 1;
+    while (real_cache_size < static_cast<size_t>(cache_size))
+        real_cache_size *= 2;
+    CacheEntry empty = {-1, 0, 0, 0};
+    cache.resize(real_cache_size, empty);
+}
+
+size_t BddManager::hash_node(int var, int low, int high) const {
+    return hash_triple(var, low, high) & (unique_table.size() - 1);
+}
+
+void BddManager::resize_unique_table() {
+    unique_table.assign(unique_table.size() * 2, -1);
+    for (size_t i = 2; i < nodes.size(); ++i) {
+        Node &node = nodes[i];
+        if (node.var == -1)
+            continue;
+        size_t bucket = hash_node(node.var, node.low, node.high);
+        node.next = unique_table[bucket];
+        unique_table[bucket] = i;
+    }
+}
+
+int BddManager::make_node(int var, int low, int high) {
+    if (low == high)
+        return low;
+    assert(var < nodes[low].var && var < nodes[high].var);
+    size_t bucket = hash_node(var, low, high);
+    for (int i = unique_table[bucket]; i != -1; i = nodes[i].next) {
+        const Node &node = nodes[i];
+        if (node.var == var && node.low == low && node.high == high)
+            return i;
+    }
+
+    int id;
+    if (free_list != -1) {
+        id = free_list;
+        free_list = nodes[id].next;
+        --num_free_nodes;
+    } else {
+        id = nodes.size();
+        nodes.push_back(Node());
+        ref_counts.push_back(0);
+    }
+    Node &node = nodes[id];
+    node.var = var;
+    node.low = low;
+    node.high = high;
+    node.next = unique_table[bucket];
+    unique_table[bucket] = id;
+    ref_counts[id] = 0;
+
+    size_t num_live_nodes = get_num_live_nodes();
+    peak_num_nodes = max(peak_num_nodes, num_live_nodes);
+    if (num_live_nodes > unique_table.size())
+        resize_unique_table();
+    return id;
+}
+
+bool BddManager::lookup_cache(int op, int a, int b, int &result) {
+    ++num_cache_lookups;
+    const CacheEntry &entry =
+        cache[hash_triple(op, a, b) & (cache.size() - 1)];
+    if (entry.op == op && entry.a == a && entry.b == b) {
+        ++num_cache_hits;
+        result = entry.result;
+        return true;
+    }
+    return false;
+}
+
+void BddManager::insert_cache(int op, int a, int b, int result) {
+    CacheEntry &entry = cache[hash_triple(op, a, b) & (cache.size() - 1)];
+    entry.op = op;
+    entry.a = a;
+    entry.b = b;
+    entry.result = result;
+}
+
+int BddManager::apply(int op, int a, int b) {
+    switch (op) {
+    case OP_AND:
+        if (a == FALSE_NODE || b == FALSE_NODE)
+            return FALSE_NODE;
+        if (a == TRUE_NODE || a == b)
+            return b;
+        if (b == TRUE_NODE)
+            return a;
+        if (a > b)
+            swap(a, b);
+        break;
+    case OP_OR:
+        if (a == TRUE_NODE || b == TRUE_NODE)
+            return TRUE_NODE;
+        if (a == FALSE_NODE || a == b)
+            return b;
+        if (b == FALSE_NODE)
+            return a;
+        if (a > b)
+            swap(a, b);
+        break;
+    case OP_AND_NOT:
+        if (a == FALSE_NODE || b == TRUE_NODE || a == b)
+            return FALSE_NODE;
+        if (b == FALSE_NODE)
+            return a;
+        if (a == TRUE_NODE)
+            return negate(b);
+        break;
+    default:
+        assert(false);
+    }
+
+    int result;
+    if (lookup_cache(op, a, b, result))
+        return result;
+    int var_a = nodes[a].var;
+    int var_b = nodes[b].var;
+    int var = min(var_a, var_b);
+    int a_low = a, a_high = a, b_low = b, b_high = b;
+    if (var_a == var) {
+        a_low = nodes[a].low;
+        a_high = nodes[a].high;
+    }
+    if (var_b == var) {
+        b_low = nodes[b].low;
+        b_high = nodes[b].high;
+    }
+    int low = apply(op, a_low, b_low);
+    int high = apply(op, a_high, b_high);
+    result = make_node(var, low, high);
+    insert_cache(op, a, b, result);
+    return result;
+}
+
+int BddManager::negate(int a) {
+    if (a == FALSE_NODE)
+        return TRUE_NODE;
+    if (a == TRUE_NODE)
+        return FALSE_NODE;
+    int result;
+    if (lookup_cache(OP_NOT, a, 0, result))
+        return result;
+    int var = nodes[a].var;
+    int a_high = nodes[a].high;
+    int low = negate(nodes[a].low);
+    int high = negate(a_high);
+    result = make_node(var, low, high);
+    insert_cache(OP_NOT, a, 0, result);
+    return result;
+}
+
+int BddManager::exists(int a, int var_set) {
+    if (nodes[a].var > var_set_last[var_set])
+        return a;
+    int op = OP_EXISTS | (var_set << 3);
+    int result;
+    if (lookup_cache(op, a, 0, result))
+        return result;
+    int var = nodes[a].var;
+    int a_high = nodes[a].high;
+    int low = exists(nodes[a].low, var_set);
+    if (var_sets[var_set][var]) {
+        if (low == TRUE_NODE)
+            result = TRUE_NODE;
+        else
+            result = apply(OP_OR, low, exists(a_high, var_set));
+    } else {
+        result = make_node(var, low, exists(a_high, var_set));
+    }
+    insert_cache(op, a, 0, result);
+    return result;
+}
+
+int BddManager::and_exists(int a, int b, int var_set) {
+    if (a == FALSE_NODE || b == FALSE_NODE)
+        return FALSE_NODE;
+    if (a == TRUE_NODE || a == b)
+        return exists(b, var_set);
+    if (b == TRUE_NODE)
+        return exists(a, var_set);
+    int var_a = nodes[a].var;
+    int var_b = nodes[b].var;
+    int var = min(var_a, var_b);
+    if (var > var_set_last[var_set])
+        return apply(OP_AND, a, b);
+    if (a > b)
+        swap(a, b);
+
+    int op = OP_AND_EXISTS | (var_set << 3);
+    int result;
+    if (lookup_cache(op, a, b, result))
+        return result;
+    var_a = nodes[a].var;
+    var_b = nodes[b].var;
+    int a_low = a, a_high = a, b_low = b, b_high = b;
+    if (var_a == var) {
+        a_low = nodes[a].low;
+        a_high = nodes[a].high;
+    }
+    if (var_b == var) {
+        b_low = nodes[b].low;
+        b_high = nodes[b].high;
+    }
+    int low = and_exists(a_low, b_low, var_set);
+    if (var_sets[var_set][var]) {
+        if (low == TRUE_NODE)
+            result = TRUE_NODE;
+        else
+            result = apply(OP_OR, low,
+                           and_exists(a_high, b_high, var_set));
+    } else {
+        result = make_node(var, low, and_exists(a_high, b_high, var_set));
+    }
+    insert_cache(op, a, b, result);
+    return result;
+}
+
+int BddManager::rename(int a, int var_map) {
+    if (a == FALSE_NODE || a == TRUE_NODE)
+        return a;
+    int op = OP_RENAME | (var_map << 3);
+    int result;
+    if (lookup_cache(op, a, 0, result))
+        return result;
+    int var = nodes[a].var;
+    int a_high = nodes[a].high;
+    int low = rename(nodes[a].low, var_map);
+    int high = rename(a_high, var_map);
+    result = make_node(var_maps[var_map][var], low, high);
+    insert_cache(op, a, 0, result);
+    return result;
+}
+
+void BddManager::ref(int node) {
+    ++ref_counts[node];
+}
+
+void BddManager::deref(int node) {
+    assert(ref_counts[node] > 0);
+    --ref_counts[node];
+}
+
+void BddManager::collect_garbage_if_needed() {
+    if (get_num_live_nodes() > gc_threshold) {
+        collect_garbage();
+        // Avoid collecting over and over if most nodes are alive.
+        if (get_num_live_nodes() > gc_threshold / 2)
+            gc_threshold *= 2;
+    }
+}
+
+void BddManager::collect_garbage() {
+    ++num_garbage_collections;
+    vector<bool> marked(nodes.size(), false);
+    marked[FALSE_NODE] = marked[TRUE_NODE] = true;
+    vector<int> stack;
+    for (size_t i = 2; i < nodes.size(); ++i) {
+        if (ref_counts[i] > 0 && !marked[i]) {
+            marked[i] = true;
+            stack.push_back(i);
+        }
+        while (!stack.empty()) {
+            const Node &node = nodes[stack.back()];
+            stack.pop_back();
+            if (!marked[node.low]) {
+                marked[node.low] = true;
+                stack.push_back(node.low);
+            }
+            if (!marked[node.high]) {
+                marked[node.high] = true;
+                stack.push_back(node.high);
+            }
+        }
+    }
+
+    fill(unique_table.begin(), unique_table.end(), -1);
+    free_list = -1;
+    num_free_nodes = 0;
+    for (size_t i = nodes.size() - 1; i >= 2; --i) {
+        Node &node = nodes[i];
+        if (marked[i]) {
+            size_t bucket = hash_node(node.var, node.low, node.high);
+            node.next = unique_table[bucket];
+            unique_table[bucket] = i;
+        } else {
+            node.var = -1;
+            node.next = free_list;
+            free_list = i;
+            ++num_free_nodes;
+        }
+    }
+    // Cached results may refer to freed nodes.
+    CacheEntry empty = {-1, 0, 0, 0};
+    fill(cache.begin(), cache.end(), empty);
+}
+
+size_t BddManager::count_nodes(int node) const {
+    if (visit_stamps.size() < nodes.size())
+        visit_stamps.resize(nodes.size(), 0);
+    if (++current_stamp == 0) {
+        fill(visit_stamps.begin(), visit_stamps.end(), 0);
+        current_stamp = 1;
+    }
+    size_t count = 0;
+    vector<int> stack(1, node);
+    visit_stamps[node] = current_stamp;
+    while (!stack.empty()) {
+        int current = stack.back();
+        stack.pop_back();
+        ++count;
+        if (current == FALSE_NODE || current == TRUE_NODE)
+            continue;
+        int children[2] = {nodes[current].low, nodes[current].high};
+        for (int child : children) {
+            if (visit_stamps[child] != current_stamp) {
+                visit_stamps[child] = current_stamp;
+                stack.push_back(child);
+            }
+        }
+    }
+    return count;
+}
+
+Bdd BddManager::get_true() {
+    return Bdd(this, TRUE_NODE);
+}
+
+Bdd BddManager::get_false() {
+    return Bdd(this, FALSE_NODE);
+}
+
+Bdd BddManager::get_var(int var) {
+    assert(var >= 0 && var < num_vars);
+    collect_garbage_if_needed();
+    return Bdd(this, make_node(var, FALSE_NODE, TRUE_NODE));
+}
+
+int BddManager::add_var_set(const vector<int> &vars) {
+    vector<bool> var_set(num_vars, false);
+    int last = -1;
+    for (int var : vars) {
+        assert(var >= 0 && var < num_vars);
+        var_set[var] = true;
+        last = max(last, var);
+    }
+    var_sets.push_back(var_set);
+    var_set_last.push_back(last);
+    return var_sets.size() - 1;
+}
+
+int BddManager::add_var_map(const vector<int> &var_map) {
+    assert(static_cast<int>(var_map.size()) == num_vars);
+    var_maps.push_back(var_map);
+    return var_maps.size() - 1;
+}
+
+Bdd BddManager::exists(const Bdd &f, int var_set) {
+    assert(f.manager == this);
+    collect_garbage_if_needed();
+    return Bdd(this, exists(f.node, var_set));
+}
+
+Bdd BddManager::and_exists(const Bdd &f, const Bdd &g, int var_set) {
+    assert(f.manager == this && g.manager == this);
+    collect_garbage_if_needed();
+    return Bdd(this, and_exists(f.node, g.node, var_set));
+}
+
+Bdd BddManager::rename(const Bdd &f, int var_map) {
+    assert(f.manager == this);
+    collect_garbage_if_needed();
+    return Bdd(this, rename(f.node, var_map));
+}
+
+Bdd BddManager::pick_minterm(const Bdd &f, const vector<int> &vars) {
+    assert(f.manager == this && !f.is_false());
+    collect_garbage_if_needed();
+    vector<bool> values;
+    values.reserve(vars.size());
+    int node = f.node;
+    for (int var : vars) {
+        if (nodes[node].var != var) {
+            values.push_back(false);
+        } else if (nodes[node].low != FALSE_NODE) {
+            values.push_back(false);
+            node = nodes[node].low;
+        } else {
+            values.push_back(true);
+            node = nodes[node].high;
+        }
+    }
+    assert(node == TRUE_NODE);
+    int result = TRUE_NODE;
+    for (int i = vars.size() - 1; i >= 0; --i) {
+        if (values[i])
+            result = make_node(vars[i], FALSE_NODE, result);
+        else
+            result = make_node(vars[i], result, FALSE_NODE);
+    }
+    return Bdd(this, result);
+}
+
+void BddManager::print_statistics() const {
+    cout << "BDD variables: " << num_vars << endl;
+    cout << "BDD nodes: " << get_num_live_nodes() << " live, "
+         << peak_num_nodes << " peak" << endl;
+    cout << "BDD garbage collections: " << num_garbage_collections << endl;
+    cout << "BDD cache hits: " << num_cache_hits << " of "
+         << num_cache_lookups << " lookups" << endl;
+}
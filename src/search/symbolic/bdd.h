@@ -0,0 +1,166 @@
+#ifndef SYMBOLIC_BDD_H
+#define SYMBOLIC_BDD_H
+
+#include <cstddef>
+#include <vector>
+
+class BddManager;
+
+/*
+  Small self-contained package for reduced ordered binary decision diagrams
+  as used by symbolic search.
+
+  BddManager owns all nodes. Variables are identified by their level
+  (0 is the topmost variable), so the variable order is fixed when the
+  caller assigns levels. Node 0 is the constant false and node 1 the
+  constant true. The manager keeps
+  - a unique table (hash table with chaining through the nodes), so that
+    equal functions are represented by the same node,
+  - a lossy computed cache (direct-mapped) for the results of the
+    recursive operations, and
+  - reference counts of the nodes held by Bdd handles. When the number of
+    nodes exceeds a threshold at the start of an operation, all nodes that
+    are not reachable from a referenced node are put on a free list (mark
+    and sweep), and the computed cache is cleared. Garbage is never
+    collected during an operation, so intermediate results need no
+    references.
+
+  Quantification and renaming take the ID of a variable set or variable map
+  that is registered with the manager once. Renaming requires a map that
+  preserves the relative order of the variables it is applied to (e.g.,
+  swapping interleaved current and next-state variables).
+*/
+
+class Bdd {
+    friend class BddManager;
+    BddManager *manager;
+    int node;
+
+    Bdd(BddManager *manager, int node);
+public:
+    // Constructs a handle that does not belong to a manager yet.
+    Bdd();
+    Bdd(const Bdd &other);
+    ~Bdd();
+    Bdd &operator=(const Bdd &other);
+
+    Bdd operator&(const Bdd &other) const;
+    Bdd operator|(const Bdd &other) const;
+    // Conjunction with the negation of other.
+    Bdd operator-(const Bdd &other) const;
+    Bdd operator!() const;
+    Bdd &operator&=(const Bdd &other);
+    Bdd &operator|=(const Bdd &other);
+
+    bool operator==(const Bdd &other) const {
+        return node == other.node;
+    }
+    bool operator!=(const Bdd &other) const {
+        return node != other.node;
+    }
+    bool is_false() const {
+        return node == 0;
+    }
+    bool is_true() const {
+        return node == 1;
+    }
+    // Number of nodes including the terminal nodes.
+    size_t get_num_nodes() const;
+};
+
+class BddManager {
+    friend class Bdd;
+
+    struct Node {
+        // Level of the variable; num_vars for terminals and -1 for free nodes.
+        int var;
+        int low;
+        int high;
+        // Next node in the same bucket of the unique table or free list.
+        int next;
+    };
+
+    // op combines the kind of operation with the ID of its variable set or
+    // map; it is -1 for empty entries.
+    struct CacheEntry {
+        int op;
+        int a;
+        int b;
+        int result;
+    };
+
+    const int num_vars;
+    std::vector<Node> nodes;
+    std::vector<int> ref_counts;
+    std::vector<int> unique_table;
+    int free_list;
+    size_t num_free_nodes;
+    size_t gc_threshold;
+    std::vector<CacheEntry> cache;
+
+    std::vector<std::vector<bool>> var_sets;
+    // Deepest level of each variable set, -1 for the empty set.
+    std::vector<int> var_set_last;
+    std::vector<std::vector<int>> var_maps;
+
+    // Used by count_nodes to mark visited nodes without clearing.
+    mutable std::vector<unsigned int> visit_stamps;
+    mutable unsigned int current_stamp;
+
+    size_t peak_num_nodes;
+    int num_garbage_collections;
+    long long num_cache_lookups;
+    long long num_cache_hits;
+
+    size_t get_num_live_nodes() const {
+        return nodes.size() - num_free_nodes;
+    }
+    size_t hash_node(int var, int low, int high) const;
+    void resize_unique_table();
+    int make_node(int var, int low, int high);
+    bool lookup_cache(int op, int a, int b, int &result);
+    void insert_cache(int op, int a, int b, int result);
+
+    int apply(int op, int a, int b);
+    int negate(int a);
+    int exists(int a, int var_set);
+    int and_exists(int a, int b, int var_set);
+    int rename(int a, int var_map);
+
+    void ref(int node);
+    void deref(int node);
+    void collect_garbage_if_needed();
+    void collect_garbage();
+    size_t count_nodes(int node) const;
+public:
+    BddManager(int num_vars, int cache_size, size_t gc_threshold);
+
+    int get_num_vars() const {
+        return num_vars;
+    }
+    Bdd get_true();
+    Bdd get_false();
+    // The function that is true iff the variable is true.
+    Bdd get_var(int var);
+
+    // Registers the set of the given variables and returns its ID.
+    int add_var_set(const std::vector<int> &vars);
+    // Registers the map var -> var_map[var] and returns its ID.
+    int add_var_map(const std::vector<int> &var_map);
+
+    Bdd exists(const Bdd &f, int var_set);
+    // Computes exists var_set: f and g without building f and g.
+    Bdd and_exists(const Bdd &f, const Bdd &g, int var_set);
+    Bdd rename(const Bdd &f, int var_map);
+    /*
+      Returns a conjunction of literals over vars (sorted by level) that
+      implies f, i.e., a single satisfying assignment. Variables of vars
+      that f does not depend on are set to false. f must not be false and
+      must only depend on variables in vars.
+    */
+    Bdd pick_minterm(const Bdd &f, const std::vector<int> &vars);
+
+    void print_statistics() const;
+};
+
+#endif
@@ -0,0 +1,541 @@
+#include "symbolic_search.h"
+
+#include "../causal_graph.h"
+#include "../globals.h"
+#include "../option_parser.h"
+#include "../plugin.h"
+#include "../timer.h"
+#include "../utilities.h"
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+using namespace std;
+
+static const int INF = numeric_limits<int>::max();
+static const int BDD_CACHE_SIZE = 1 << 20;
+static const size_t BDD_GC_THRESHOLD = 1 << 20;
+
+
+SymbolicSearch::SymbolicSearch(const Options &opts)
+    : SearchEngine(opts),
+      direction(Direction(opts.get_enum("direction"))),
+      max_tr_size(opts.get<int>("max_tr_size")),
+      current_var_set(-1),
+      next_var_set(-1),
+      swap_map(-1),
+      best_cost(INF),
+      meeting_forward_g(-1),
+      meeting_backward_g(-1)
+{
+}
+
+SymbolicSearch::~SymbolicSearch()
+{
+}
+
+/*
+  Orders the variables greedily: starts with a variable with the most
+  neighbours in the causal graph and then always appends the variable that
+  has the most neighbours among the variables placed so far (ties are
+  broken in favour of more neighbours overall).
+*/
+vector<int> SymbolicSearch::compute_variable_order() const
+{
+    int num_vars = g_variable_domain.size();
+    vector<vector<int>> neighbours(num_vars);
+    for (int var = 0; var < num_vars; ++var) {
+        const vector<int> &succ = g_causal_graph->get_successors(var);
+        const vector<int> &pred = g_causal_graph->get_predecessors(var);
+        vector<int> &nb = neighbours[var];
+        nb.insert(nb.end(), succ.begin(), succ.end());
+        nb.insert(nb.end(), pred.begin(), pred.end());
+        sort(nb.begin(), nb.end());
+        nb.erase(unique(nb.begin(), nb.end()), nb.end());
+        nb.erase(remove(nb.begin(), nb.end(), var), nb.end());
+    }
+
+    vector<int> order;
+    vector<bool> placed(num_vars, false);
+    vector<int> placed_neighbours(num_vars, 0);
+    for (int i = 0; i < num_vars; ++i) {
+        int best_var = -1;
+        for (int var = 0; var < num_vars; ++var) {
+            if (placed[var])
+                continue;
+            if (best_var == -1 ||
+                placed_neighbours[var] > placed_neighbours[best_var] ||
+                (placed_neighbours[var] == placed_neighbours[best_var] &&
+                 neighbours[var].size() > neighbours[best_var].size()))
+                best_var = var;
+        }
+        order.push_back(best_var);
+        placed[best_var] = true;
+        for (int nb : neighbours[best_var])
+            ++placed_neighbours[nb];
+    }
+    return order;
+}
+
+void SymbolicSearch::create_encoding()
+{
+    int num_vars = g_variable_domain.size();
+    vector<int> order = compute_variable_order();
+    var_levels.resize(num_vars);
+    int num_bits = 0;
+    for (int var : order) {
+        int bits = 0;
+        while ((1 << bits) < g_variable_domain[var])
+            ++bits;
+        for (int bit = 0; bit < bits; ++bit) {
+            var_levels[var].push_back(2 * num_bits);
+            ++num_bits;
+        }
+    }
+
+    manager.reset(new BddManager(2 * num_bits, BDD_CACHE_SIZE,
+                                 BDD_GC_THRESHOLD));
+    vector<int> next_levels;
+    vector<int> swap(2 * num_bits);
+    for (int bit = 0; bit < num_bits; ++bit) {
+        current_levels.push_back(2 * bit);
+        next_levels.push_back(2 * bit + 1);
+        swap[2 * bit] = 2 * bit + 1;
+        swap[2 * bit + 1] = 2 * bit;
+    }
+    current_var_set = manager->add_var_set(current_levels);
+    next_var_set = manager->add_var_set(next_levels);
+    swap_map = manager->add_var_map(swap);
+
+    value_bdds.resize(num_vars);
+    next_value_bdds.resize(num_vars);
+    frame_bdds.resize(num_vars);
+    valid_states = manager->get_true();
+    for (int var = 0; var < num_vars; ++var) {
+        const vector<int> &levels = var_levels[var];
+        int bits = levels.size();
+        Bdd valid_values = manager->get_false();
+        for (int value = 0; value < g_variable_domain[var]; ++value) {
+            Bdd current = manager->get_true();
+            Bdd next = manager->get_true();
+            for (int bit = 0; bit < bits; ++bit) {
+                bool is_set = (value >> (bits - 1 - bit)) & 1;
+                Bdd x = manager->get_var(levels[bit]);
+                Bdd x_next = manager->get_var(levels[bit] + 1);
+                current &= is_set ? x : !x;
+                next &= is_set ? x_next : !x_next;
+            }
+            value_bdds[var].push_back(current);
+            next_value_bdds[var].push_back(next);
+            valid_values |= current;
+        }
+        valid_states &= valid_values;
+
+        Bdd frame = manager->get_true();
+        for (int bit = 0; bit < bits; ++bit) {
+            Bdd x = manager->get_var(levels[bit]);
+            Bdd x_next = manager->get_var(levels[bit] + 1);
+            frame &= (x & x_next) | !(x | x_next);
+        }
+        frame_bdds[var] = frame;
+    }
+    cout << "BDD variables: " << 2 * num_bits << " for " << num_vars
+         << " variables" << endl;
+}
+
+Bdd SymbolicSearch::encode_state(const vector<int> &values) const
+{
+    Bdd result = manager->get_true();
+    for (size_t var = 0; var < values.size(); ++var)
+        result &= value_bdds[var][values[var]];
+    return result;
+}
+
+Bdd SymbolicSearch::build_operator_relation(const Operator &op) const
+{
+    int num_vars = g_variable_domain.size();
+    vector<int> pre(num_vars, -1);
+    vector<int> eff(num_vars, -1);
+    const vector<Condition> &preconditions = op.get_preconditions();
+    for (size_t i = 0; i < preconditions.size(); ++i)
+        pre[preconditions[i].var] = preconditions[i].val;
+    const vector<Effect> &effects = op.get_effects();
+    for (size_t i = 0; i < effects.size(); ++i)
+        eff[effects[i].var] = effects[i].val;
+
+    Bdd relation = manager->get_true();
+    for (int var = 0; var < num_vars; ++var) {
+        if (eff[var] != -1) {
+            relation &= next_value_bdds[var][eff[var]];
+            if (pre[var] != -1)
+                relation &= value_bdds[var][pre[var]];
+        } else if (pre[var] != -1) {
+            relation &= value_bdds[var][pre[var]] &
+                        next_value_bdds[var][pre[var]];
+        } else {
+            relation &= frame_bdds[var];
+        }
+    }
+    return relation;
+}
+
+void SymbolicSearch::create_transition_relations()
+{
+    map<int, vector<const Operator *>> ops_by_cost;
+    for (size_t i = 0; i < g_operators.size(); ++i) {
+        const Operator &op = g_operators[i];
+        ops_by_cost[get_adjusted_cost(op)].push_back(&op);
+    }
+
+    size_t total_nodes = 0;
+    for (auto &entry : ops_by_cost) {
+        TransitionRelation group;
+        group.cost = entry.first;
+        for (const Operator *op : entry.second) {
+            Bdd relation = build_operator_relation(*op);
+            if (!group.ops.empty()) {
+                Bdd merged = group.relation | relation;
+                if (merged.get_num_nodes() <=
+                    static_cast<size_t>(max_tr_size)) {
+                    group.relation = merged;
+                    group.ops.push_back(op);
+                    continue;
+                }
+                total_nodes += group.relation.get_num_nodes();
+                transition_relations.push_back(group);
+                group.ops.clear();
+            }
+            group.relation = relation;
+            group.ops.push_back(op);
+        }
+        total_nodes += group.relation.get_num_nodes();
+        transition_relations.push_back(group);
+    }
+    cout << "Transition relations: " << transition_relations.size()
+         << " for " << g_operators.size() << " operators and "
+         << ops_by_cost.size() << " costs, " << total_nodes
+         << " BDD nodes" << endl;
+}
+
+Bdd SymbolicSearch::image(const Bdd &states, const Bdd &relation,
+                          bool is_forward) const
+{
+    if (is_forward) {
+        return manager->rename(
+            manager->and_exists(states, relation, current_var_set),
+            swap_map);
+    } else {
+        // Operators without precondition on an affected variable allow
+        // values outside of its domain.
+        return manager->and_exists(manager->rename(states, swap_map),
+                                   relation, next_var_set) & valid_states;
+    }
+}
+
+void SymbolicSearch::initialize()
+{
+    cout << "Conducting symbolic uniform-cost search, (real) bound = "
+         << bound << endl;
+    verify_no_axioms_no_conditional_effects();
+    Timer timer;
+    create_encoding();
+    create_transition_relations();
+    cout << "Time for building transition relations: " << timer << endl;
+
+    Bdd initial_states = encode_state(g_initial_state_data);
+    Bdd goal_states = valid_states;
+    for (size_t i = 0; i < g_goal.size(); ++i)
+        goal_states &= value_bdds[g_goal[i].first][g_goal[i].second];
+
+    forward.is_forward = true;
+    forward.is_searched = direction != BACKWARD;
+    backward.is_forward = false;
+    backward.is_searched = direction != FORWARD;
+    Bdd start_states[2] = {initial_states, goal_states};
+    SearchDirection *dirs[2] = {&forward, &backward};
+    for (int i = 0; i < 2; ++i) {
+        SearchDirection &dir = *dirs[i];
+        dir.num_expanded_layers = 0;
+        dir.image_time = 0;
+        dir.max_frontier_nodes = 0;
+        if (dir.is_searched) {
+            dir.open[0] = start_states[i];
+            dir.closed = manager->get_false();
+        } else {
+            // The start states are the only layer of a direction that is
+            // not searched.
+            dir.layers[0].push_back(start_states[i]);
+            dir.closed = start_states[i];
+        }
+    }
+    if (cost_type == NORMAL)
+        best_cost = bound;
+}
+
+int SymbolicSearch::get_next_g(const SearchDirection &dir) const
+{
+    if (!dir.is_searched)
+        return 0;
+    if (dir.open.empty())
+        return INF;
+    return dir.open.begin()->first;
+}
+
+/*
+  Intersects states, which have cost g in direction dir, with the closed
+  states of the other direction and updates the best plan.
+*/
+void SymbolicSearch::check_meeting(const Bdd &states, int g,
+                                   const SearchDirection &dir)
+{
+    const SearchDirection &other = dir.is_forward ? backward : forward;
+    Bdd common = states & other.closed;
+    if (common.is_false())
+        return;
+    for (const auto &entry : other.layers) {
+        int other_g = entry.first;
+        if (g + other_g >= best_cost)
+            return;
+        for (const Bdd &sublayer : entry.second) {
+            Bdd meeting = common & sublayer;
+            if (!meeting.is_false()) {
+                best_cost = g + other_g;
+                meeting_state = manager->pick_minterm(meeting, current_levels);
+                meeting_forward_g = dir.is_forward ? g : other_g;
+                meeting_backward_g = dir.is_forward ? other_g : g;
+                cout << "Found plan of cost " << best_cost << " [t="
+                     << g_timer << "]" << endl;
+                return;
+            }
+        }
+    }
+}
+
+void SymbolicSearch::expand_layer(SearchDirection &dir)
+{
+    int g = dir.open.begin()->first;
+    Bdd states = dir.open.begin()->second - dir.closed;
+    dir.open.erase(dir.open.begin());
+    if (states.is_false())
+        return;
+    ++dir.num_expanded_layers;
+    size_t frontier_nodes = states.get_num_nodes();
+    dir.max_frontier_nodes = max(dir.max_frontier_nodes, frontier_nodes);
+    Timer image_timer;
+
+    vector<Bdd> &sublayers = dir.layers[g];
+    sublayers.push_back(states);
+    dir.closed |= states;
+    check_meeting(states, g, dir);
+    Bdd layer = states;
+    while (true) {
+        Bdd new_states = manager->get_false();
+        for (const TransitionRelation &tr : transition_relations) {
+            if (tr.cost == 0)
+                new_states |= image(sublayers.back(), tr.relation,
+                                    dir.is_forward);
+        }
+        new_states = new_states - dir.closed;
+        if (new_states.is_false())
+            break;
+        sublayers.push_back(new_states);
+        dir.closed |= new_states;
+        layer |= new_states;
+        check_meeting(new_states, g, dir);
+    }
+
+    for (const TransitionRelation &tr : transition_relations) {
+        if (tr.cost == 0 || g + tr.cost >= best_cost)
+            continue;
+        int succ_g = g + tr.cost;
+        Bdd succ_states = image(layer, tr.relation, dir.is_forward) -
+                          dir.closed;
+        if (succ_states.is_false())
+            continue;
+        check_meeting(succ_states, succ_g, dir);
+        auto it = dir.open.find(succ_g);
+        if (it == dir.open.end())
+            dir.open.insert(make_pair(succ_g, succ_states));
+        else
+            it->second |= succ_states;
+    }
+    double time = image_timer();
+    dir.image_time += time;
+    cout << (dir.is_forward ? "Forward" : "Backward") << " layer g=" << g
+         << ": " << frontier_nodes << " BDD nodes, " << sublayers.size()
+         << " sublayers, image time " << time << "s [t=" << g_timer << "]"
+         << endl;
+}
+
+SearchStatus SymbolicSearch::step()
+{
+    if (cost_type == NORMAL && bound < best_cost) {
+        // The bound was lowered, e.g. by a parallel portfolio.
+        best_cost = bound;
+        meeting_state = Bdd();
+    }
+    int forward_g = get_next_g(forward);
+    int backward_g = get_next_g(backward);
+    /*
+      A direction that has closed all of its states can still meet states
+      that the other direction has not expanded yet, so it only ends the
+      search if the other direction is done as well.
+    */
+    if (forward_g == INF && backward.is_searched && backward_g != INF)
+        forward_g = 0;
+    if (backward_g == INF && forward.is_searched && forward_g != INF)
+        backward_g = 0;
+    if (forward_g == INF || backward_g == INF ||
+        best_cost <= forward_g + backward_g) {
+        if (meeting_state.is_false()) {
+            cout << "Completely explored state space -- no solution!" << endl;
+            return FAILED;
+        }
+        cout << "Solution found!" << endl;
+        extract_plan();
+        return SOLVED;
+    }
+
+    if (!forward.open.empty() && !backward.open.empty()) {
+        size_t forward_nodes = forward.open.begin()->second.get_num_nodes();
+        size_t backward_nodes = backward.open.begin()->second.get_num_nodes();
+        expand_layer(forward_nodes <= backward_nodes ? forward : backward);
+    } else {
+        expand_layer(forward.open.empty() ? backward : forward);
+    }
+    return IN_PROGRESS;
+}
+
+// Returns the sublayer of the layer with cost g of dir that contains state.
+int SymbolicSearch::find_sublayer(const SearchDirection &dir,
+                                  const Bdd &state, int g) const
+{
+    auto it = dir.layers.find(g);
+    if (it == dir.layers.end())
+        return -1;
+    for (size_t k = 0; k < it->second.size(); ++k) {
+        if (!(state & it->second[k]).is_false())
+            return k;
+    }
+    return -1;
+}
+
+/*
+  Returns the operators that lead from state (reached with cost g in dir)
+  to the start states of dir, starting with the one applied to state.
+  state does not need to be closed in dir if it was generated from a
+  closed state with cost g.
+*/
+SearchEngine::Plan SymbolicSearch::extract_path(const SearchDirection &dir,
+                                                Bdd state, int g) const
+{
+    Plan path;
+    while (true) {
+        int k = find_sublayer(dir, state, g);
+        if (g == 0 && k == 0)
+            break;
+        bool found = false;
+        for (const TransitionRelation &tr : transition_relations) {
+            // Zero-cost operators lead into the previous sublayer, all
+            // others into an earlier layer.
+            if ((k > 0) != (tr.cost == 0) || tr.cost > g)
+                continue;
+            auto it = dir.layers.find(g - tr.cost);
+            if (it == dir.layers.end())
+                continue;
+            Bdd target = manager->get_false();
+            if (k > 0) {
+                target = it->second[k - 1];
+            } else {
+                for (const Bdd &sublayer : it->second)
+                    target |= sublayer;
+            }
+            if ((image(state, tr.relation, !dir.is_forward) & target).is_false())
+                continue;
+            for (const Operator *op : tr.ops) {
+                Bdd relation = build_operator_relation(*op);
+                Bdd previous = image(state, relation, !dir.is_forward) &
+                               target;
+                if (!previous.is_false()) {
+                    path.push_back(op);
+                    state = manager->pick_minterm(previous, current_levels);
+                    g -= tr.cost;
+                    found = true;
+                    break;
+                }
+            }
+            if (found)
+                break;
+        }
+        if (!found) {
+            cerr << "Could not reconstruct the plan from the BDD layers."
+                 << endl;
+            exit_with(EXIT_CRITICAL_ERROR);
+        }
+    }
+    return path;
+}
+
+void SymbolicSearch::extract_plan()
+{
+    Plan plan = extract_path(forward, meeting_state, meeting_forward_g);
+    reverse(plan.begin(), plan.end());
+    Plan backward_path = extract_path(backward, meeting_state,
+                                      meeting_backward_g);
+    plan.insert(plan.end(), backward_path.begin(), backward_path.end());
+    set_plan(plan);
+}
+
+void SymbolicSearch::statistics() const
+{
+    const SearchDirection *dirs[2] = {&forward, &backward};
+    for (int i = 0; i < 2; ++i) {
+        const SearchDirection &dir = *dirs[i];
+        if (!dir.is_searched)
+            continue;
+        string name = dir.is_forward ? "Forward" : "Backward";
+        cout << name << " layers expanded: " << dir.num_expanded_layers
+             << endl;
+        cout << name << " image time: " << dir.image_time << "s" << endl;
+        cout << name << " max frontier: " << dir.max_frontier_nodes
+             << " BDD nodes" << endl;
+    }
+    if (manager)
+        manager->print_statistics();
+}
+
+static SearchEngine *_parse(OptionParser &parser)
+{
+    parser.document_synopsis(
+        "Symbolic search",
+        "Uniform-cost search on sets of states represented as binary "
+        "decision diagrams, in forward, backward or both directions. "
+        "Finds optimal plans.");
+    parser.document_note(
+        "Supported tasks",
+        "Axioms and conditional effects are not supported.");
+    vector<string> directions;
+    directions.push_back("FORWARD");
+    directions.push_back("BACKWARD");
+    directions.push_back("BIDIRECTIONAL");
+    parser.add_enum_option("direction", directions,
+                           "direction of the search", "BIDIRECTIONAL");
+    parser.add_option<int>(
+        "max_tr_size",
+        "maximum number of BDD nodes of a disjunction of transition "
+        "relations of operators with the same cost",
+        "100000");
+    SearchEngine::add_options_to_parser(parser);
+    Options opts = parser.parse();
+
+    if (opts.get<int>("max_tr_size") < 1) {
+        parser.error("max_tr_size must be positive");
+    }
+    if (parser.dry_run()) {
+        return 0;
+    }
+    return new SymbolicSearch(opts);
+}
+
+static Plugin<SearchEngine> _plugin("symbolic", _parse);
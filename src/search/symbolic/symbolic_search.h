@@ -0,0 +1,128 @@
+#ifndef SYMBOLIC_SYMBOLIC_SEARCH_H
+#define SYMBOLIC_SYMBOLIC_SEARCH_H
+
+#include "bdd.h"
+
+#include "../search_engine.h"
+
+#include <map>
+#include <memory>
+#include <vector>
+
+// Usage example: the command line option for using bidirectional symbolic
+// uniform-cost search is
+// ./fast-downward.py [path-to-PDDL-problem-file] --search "symbolic()"
+// So, for a forward search with transition relations of at most 10000 BDD
+// nodes it is
+// ./fast-downward.py [path-to-PDDL-problem-file] --search "symbolic(direction=forward, max_tr_size=10000)"
+// Obviously, [path-to-PDDL-problem-file] has to be replaced by the actual path
+// to the PDDL problem file.
+
+/*
+  Symbolic (BDD-based) uniform-cost search in forward, backward or both
+  directions (cf. Torralba et al., 2017, "Efficient symbolic search for
+  cost-optimal planning").
+
+  States are encoded in binary: each variable of the task gets
+  ceil(log2(domain size)) BDD variables for the current state (x) and as
+  many for the successor state (x'). The x and x' bits are interleaved, and
+  the variables of the task are ordered greedily so that variables that are
+  connected in the causal graph are close to each other.
+
+  The transition relation T(x, x') of each operator fixes the precondition
+  on x, the effects on x' and x = x' for the variables that the operator
+  does not change. The relations of operators with the same cost are
+  disjoined into groups of at most max_tr_size nodes. The forward image of
+  a set S(x) under T is exists x: S(x) and T(x, x') (with x' renamed to x),
+  the backward image is exists x': S(x') and T(x, x').
+
+  Each direction expands the states of its open list in layers of equal
+  cost g. A layer is closed under the images of the zero-cost groups; the
+  images of the other groups go to the open list with cost g + cost. The
+  states of each layer are kept for plan reconstruction. Whenever a layer
+  is expanded or new states are generated, they are intersected with the
+  closed states of the other direction; a common state gives a plan of cost
+  g_forward + g_backward. The search stops when the cheapest plan is no
+  more expensive than the sum of the smallest g-values of the two open
+  lists. Bidirectional search expands the direction whose next layer has
+  fewer BDD nodes.
+
+  The plan is reconstructed from the meeting state by regressing (forward)
+  or progressing (backward) it through the stored layers with the
+  transition relations of single operators.
+*/
+
+class Options;
+
+class SymbolicSearch : public SearchEngine
+{
+    enum Direction {FORWARD, BACKWARD, BIDIRECTIONAL};
+
+    struct TransitionRelation {
+        int cost;
+        Bdd relation;
+        std::vector<const Operator *> ops;
+    };
+
+    struct SearchDirection {
+        bool is_forward;
+        bool is_searched;
+        std::map<int, Bdd> open;
+        // Expanded layers by g-value; zero-cost operators lead from one
+        // sublayer of a layer to the next.
+        std::map<int, std::vector<Bdd>> layers;
+        Bdd closed;
+        int num_expanded_layers;
+        double image_time;
+        size_t max_frontier_nodes;
+    };
+
+    const Direction direction;
+    const int max_tr_size;
+
+    std::unique_ptr<BddManager> manager;
+    // BDD levels of the bits of each variable, most significant bit first.
+    std::vector<std::vector<int>> var_levels;
+    std::vector<int> current_levels;
+    int current_var_set;
+    int next_var_set;
+    int swap_map;
+    // Encodings of the states that satisfy var = value, on x and on x'.
+    std::vector<std::vector<Bdd>> value_bdds;
+    std::vector<std::vector<Bdd>> next_value_bdds;
+    // x = x' for each variable.
+    std::vector<Bdd> frame_bdds;
+    Bdd valid_states;
+    std::vector<TransitionRelation> transition_relations;
+
+    SearchDirection forward;
+    SearchDirection backward;
+    int best_cost;
+    Bdd meeting_state;
+    int meeting_forward_g;
+    int meeting_backward_g;
+
+    std::vector<int> compute_variable_order() const;
+    void create_encoding();
+    Bdd encode_state(const std::vector<int> &values) const;
+    Bdd build_operator_relation(const Operator &op) const;
+    void create_transition_relations();
+    Bdd image(const Bdd &states, const Bdd &relation, bool is_forward) const;
+
+    int get_next_g(const SearchDirection &dir) const;
+    void check_meeting(const Bdd &states, int g, const SearchDirection &dir);
+    void expand_layer(SearchDirection &dir);
+    int find_sublayer(const SearchDirection &dir, const Bdd &state,
+                      int g) const;
+    Plan extract_path(const SearchDirection &dir, Bdd state, int g) const;
+    void extract_plan();
+protected:
+    virtual void initialize();
+    virtual SearchStatus step();
+public:
+    SymbolicSearch(const Options &opts);
+    virtual ~SymbolicSearch();
+    virtual void statistics() const;
+};
+
+#endif
@@ -0,0 +1,140 @@
+#include "thread_pool.h"
+
+#include <cassert>
+
+using namespace std;
+
+static inline unsigned long long pack_range(unsigned int begin,
+                                            unsigned int end) {
+    return (static_cast<unsigned long long>(begin) << 32) | end;
+}
+
+static inline unsigned int range_begin(unsigned long long range) {
+    return range >> 32;
+}
+
+static inline unsigned int range_end(unsigned long long range) {
+    return range & 0xffffffffULL;
+}
+
+ThreadPool::ThreadPool(int num_threads)
+    : generation(0),
+      busy_threads(0),
+      shutting_down(false),
+      task_function(0),
+      task_ranges(num_threads),
+      num_steals(0) {
+    assert(num_threads >= 1);
+    for (int i = 0; i < num_threads; ++i)
+        task_ranges[i] = 0;
+    for (int i = 1; i < num_threads; ++i) {
+        threads.push_back(thread(&ThreadPool::worker_loop, this, i));
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        lock_guard<std::mutex> lock(mutex);
+        shutting_down = true;
+    }
+    work_available.notify_all();
+    for (size_t i = 0; i < threads.size(); ++i) {
+        threads[i].join();
+    }
+}
+
+void ThreadPool::worker_loop(int thread_id) {
+    unsigned int seen_generation = 0;
+    unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        work_available.wait(lock, [&] {
+                                return shutting_down ||
+                                       generation != seen_generation;
+                            });
+        if (shutting_down)
+            return;
+        seen_generation = generation;
+        lock.unlock();
+        process_tasks(thread_id);
+        lock.lock();
+        if (--busy_threads == 0)
+            work_done.notify_one();
+    }
+}
+
+bool ThreadPool::pop_own_task(int thread_id, int &task) {
+    atomic<unsigned long long> &own_range = task_ranges[thread_id];
+    unsigned long long range = own_range.load();
+    while (true) {
+        unsigned int begin = range_begin(range);
+        unsigned int end = range_end(range);
+        if (begin >= end)
+            return false;
+        if (own_range.compare_exchange_weak(range, pack_range(begin + 1, end))) {
+            task = begin;
+            return true;
+        }
+    }
+}
+
+bool ThreadPool::steal_tasks(int thread_id, int &task) {
+    int num_threads = task_ranges.size();
+    for (int offset = 1; offset < num_threads; ++offset) {
+        atomic<unsigned long long> &victim_range =
+            task_ranges[(thread_id + offset) % num_threads];
+        unsigned long long range = victim_range.load();
+        while (true) {
+            unsigned int begin = range_begin(range);
+            unsigned int end = range_end(range);
+            if (begin >= end)
+                break;
+            unsigned int middle = begin + (end - begin) / 2;
+            if (victim_range.compare_exchange_weak(
+                    range, pack_range(begin, middle))) {
+                /*
+                  Our own range is empty, so nobody else modifies it and we
+                  can publish the stolen tasks with a plain store.
+                */
+                task_ranges[thread_id] = pack_range(middle + 1, end);
+                task = middle;
+                ++num_steals;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void ThreadPool::process_tasks(int thread_id) {
+    int task;
+    while (pop_own_task(thread_id, task) || steal_tasks(thread_id, task))
+        (*task_function)(task, thread_id);
+}
+
+void ThreadPool::parallel_for(int num_tasks, const TaskFunction &func) {
+    if (threads.empty() || num_tasks <= 1) {
+        for (int task = 0; task < num_tasks; ++task)
+            func(task, 0);
+        return;
+    }
+    {
+        lock_guard<std::mutex> lock(mutex);
+        task_function = &func;
+        int num_threads = task_ranges.size();
+        for (int i = 0; i < num_threads; ++i) {
+            unsigned int begin = static_cast<long long>(num_tasks) * i /
+                                 num_threads;
+            unsigned int end = static_cast<long long>(num_tasks) * (i + 1) /
+                               num_threads;
+            task_ranges[i] = pack_range(begin, end);
+        }
+        busy_threads = threads.size();
+        ++generation;
+    }
+    work_available.notify_all();
+    process_tasks(0);
+
+    unique_lock<std::mutex> lock(mutex);
+    work_done.wait(lock, [&] {return busy_threads == 0; });
+    task_function = 0;
+}
@@ -0,0 +1,69 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+  Fixed set of threads for data-parallel loops. The thread that calls
+  parallel_for takes part in the work as thread 0, so a pool with
+  num_threads = 1 creates no threads at all and runs everything inline.
+
+  The tasks of a loop are split evenly between the threads at the start.
+  Each thread works through its own range from the front and, once it has
+  run out of tasks, steals the back half of the range of another thread.
+  This balances the load when the cost of tasks varies (e.g., heuristic
+  evaluations) without a shared counter that all threads contend on.
+*/
+class ThreadPool {
+    typedef std::function<void(int task, int thread_id)> TaskFunction;
+
+    std::vector<std::thread> threads;
+
+    std::mutex mutex;
+    std::condition_variable work_available;
+    std::condition_variable work_done;
+    // Incremented whenever a new loop starts.
+    unsigned int generation;
+    int busy_threads;
+    bool shutting_down;
+
+    const TaskFunction *task_function;
+    /*
+      Remaining tasks [begin, end) of each thread, packed as
+      (begin << 32) | end so that the owner and thieves can update a range
+      with a single compare-and-swap.
+    */
+    std::vector<std::atomic<unsigned long long>> task_ranges;
+    std::atomic<int> num_steals;
+
+    bool pop_own_task(int thread_id, int &task);
+    bool steal_tasks(int thread_id, int &task);
+    void worker_loop(int thread_id);
+    void process_tasks(int thread_id);
+public:
+    explicit ThreadPool(int num_threads);
+    ~ThreadPool();
+
+    int get_num_threads() const {
+        return threads.size() + 1;
+    }
+
+    /*
+      Calls func(task, thread_id) for all tasks in [0, num_tasks) and
+      returns when all calls have finished. thread_id is in
+      [0, get_num_threads()) and no two concurrent calls share it.
+    */
+    void parallel_for(int num_tasks, const TaskFunction &func);
+
+    // Number of successful steals over all loops so far.
+    int get_num_steals() const {
+        return num_steals;
+    }
+};
+
+#endif
@@ -10,7 +10,11 @@
 #include "sum_evaluator.h"
 #include "weighted_evaluator.h"
 #include "standard_scalar_open_list.h"
+#include "state_registry.h"
+#include "thread_pool.h"
+#include "utilities.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstdlib>
 #include <set>
@@ -23,7 +27,16 @@ WeightedAstar::WeightedAstar(
     : SearchEngine(opts),
       reopen_closed_nodes(opts.get<bool>("reopen_closed")),
       helpful_actions(opts.get<bool>("helpful_actions")),
-      open_list(opts.get<OpenList<StateID> *>("open"))
+      num_threads(opts.get<int>("threads")),
+      warm_started(false),
+      thread_pool(0),
+      batch_evaluation(false),
+      num_parallel_batches(0),
+      num_parallel_evaluations(0),
+      open_list(opts.get<OpenList<StateID> *>("open")),
+      preferred_open_list(0),
+      expand_preferred_next(true),
+      num_preferred_expansions(0)
 {
     if (opts.contains("f_eval")) {
         f_evaluator = opts.get<ScalarEvaluator *>("f_eval");
@@ -35,6 +48,17 @@ WeightedAstar::WeightedAstar(
     } else {
         pruning = nullptr;
     }
+    if (opts.contains("preferred_open")) {
+        preferred_open_list = opts.get<OpenList<StateID> *>("preferred_open");
+    }
+}
+
+WeightedAstar::~WeightedAstar()
+{
+    delete thread_pool;
+    for (size_t i = 0; i < evaluation_contexts.size(); ++i) {
+        delete evaluation_contexts[i];
+    }
 }
 
 void WeightedAstar::initialize()
@@ -44,7 +68,7 @@ void WeightedAstar::initialize()
          << " reopening closed nodes, (real) bound = " << bound
          << endl;
     if (helpful_actions) {
-        cout << "using only helpful actions" << endl;
+        cout << "preferring successors reached by helpful actions" << endl;
     }
     if (pruning != nullptr) {
         pruning->initialize();
@@ -65,19 +89,39 @@ void WeightedAstar::initialize()
         f_evaluator->get_involved_heuristics(hset);
     }
 
+    /*
+      The nodes store a single h-value, and only this heuristic is evaluated,
+      so other heuristics would be combined with stale values.
+    */
+    if (hset.size() != 1) {
+        cerr << "wastar supports exactly one heuristic, but the open list "
+             << "and f_eval use " << hset.size() << endl;
+        exit_with(EXIT_UNSUPPORTED);
+    }
     heuristic = *hset.begin();
 
     assert(heuristic != 0);
 
     const State &initial_state = g_initial_state();
 
-    heuristic->evaluate(initial_state);
+    evaluate_state(initial_state);
+    if (num_threads > 1) {
+        setup_parallel_evaluation();
+    }
+    // Batch evaluation does not compute helpful actions.
+    if (!thread_pool && !helpful_actions && hset.size() == 1 &&
+        heuristic->supports_batch_evaluation()) {
+        cout << "Evaluating the successors of each state in one batch" << endl;
+        batch_evaluation = true;
+    }
 
     open_list->evaluate(0, false);
     search_progress.inc_evaluated_states();
     search_progress.inc_evaluations();
 
-    if (open_list->is_dead_end()) {
+    if (warm_started) {
+        reinsert_open_nodes();
+    } else if (open_list->is_dead_end()) {
         cout << "Initial state is a dead end." << endl;
     } else {
         search_progress.get_initial_h_values();
@@ -93,14 +137,174 @@ void WeightedAstar::initialize()
     }
 }
 
+bool WeightedAstar::warm_start(const SearchEngine &previous)
+{
+    const WeightedAstar *previous_search =
+        dynamic_cast<const WeightedAstar *>(&previous);
+    // Without reopening, the closed nodes could keep too expensive paths.
+    // A failed previous search has nothing left to continue from.
+    if (!previous_search || previous.get_status() == FAILED ||
+        !reopen_closed_nodes || pruning ||
+        previous_search->pruning || previous_search->cost_type != cost_type) {
+        return false;
+    }
+    // The nodes store h-values, so both searches need the same heuristic.
+    set<Heuristic *> hset;
+    open_list->get_involved_heuristics(hset);
+    if (hset.size() != 1 ||
+        !(*hset.begin())->has_same_estimates(*previous_search->heuristic)) {
+        return false;
+    }
+    // Nodes are expanded with the helpful actions stored when evaluated.
+    if (helpful_actions && !previous_search->helpful_actions) {
+        return false;
+    }
+    search_space.copy_from(previous_search->search_space);
+    if (helpful_actions) {
+        for (StateRegistry::const_iterator it = g_state_registry->begin();
+             it != g_state_registry->end(); ++it) {
+            State state = g_state_registry->lookup_state(*it);
+            state_helpful_actions[state] =
+                previous_search->state_helpful_actions[state];
+        }
+    }
+    warm_started = true;
+    return true;
+}
+
+/*
+  Puts the open nodes of the search space of the previous phase into the
+  open list. Closed nodes stay closed until they are reached on a cheaper
+  path, which keeps A* optimal with admissible heuristics.
+*/
+void WeightedAstar::reinsert_open_nodes()
+{
+    int num_open = 0;
+    int num_closed = 0;
+    for (StateRegistry::const_iterator it = g_state_registry->begin();
+         it != g_state_registry->end(); ++it) {
+        State state = g_state_registry->lookup_state(*it);
+        SearchNode node = search_space.get_node(state);
+        if (node.is_closed()) {
+            ++num_closed;
+        } else if (node.is_open() && node.get_real_g() < bound) {
+            heuristic->set_evaluator_value(node.get_h());
+            open_list->evaluate(node.get_g(), false);
+            open_list->insert(*it);
+            ++num_open;
+        }
+    }
+    cout << "Warm start with " << num_open << " open and " << num_closed
+         << " closed nodes of the previous search" << endl;
+}
+
+void WeightedAstar::setup_parallel_evaluation()
+{
+    set<Heuristic *> hset;
+    open_list->get_involved_heuristics(hset);
+    if (hset.size() == 1) {
+        evaluation_contexts = heuristic->create_evaluation_contexts(num_threads);
+    }
+    if (evaluation_contexts.empty()) {
+        cout << "Heuristic does not support evaluation contexts; "
+             << "evaluating successors sequentially." << endl;
+        return;
+    }
+    cout << "Evaluating successors on " << num_threads << " threads" << endl;
+    thread_pool = new ThreadPool(num_threads);
+}
+
+void WeightedAstar::evaluate_state(const State &state)
+{
+    if (!helpful_actions) {
+        heuristic->evaluate(state);
+        return;
+    }
+    // Cached values come without helpful actions.
+    heuristic->evaluate_uncached(state);
+    vector<const Operator *> helpful;
+    if (!heuristic->is_dead_end()) {
+        heuristic->get_helpful_actions(helpful);
+    }
+    store_helpful_actions(state, helpful);
+}
+
+void WeightedAstar::store_helpful_actions(const State &state,
+                                          vector<const Operator *> &helpful)
+{
+    sort(helpful.begin(), helpful.end());
+    state_helpful_actions[state].swap(helpful);
+}
+
+void WeightedAstar::evaluate_new_successors(
+    const vector<State> &successors, vector<int> &h_values,
+    vector<vector<const Operator *>> &helpful)
+{
+    // Positions of the successors that need a heuristic value.
+    vector<int> new_successors;
+    for (size_t i = 0; i < successors.size(); ++i) {
+        SearchNode succ_node = search_space.get_node(successors[i]);
+        if (succ_node.is_new()) {
+            new_successors.push_back(i);
+        }
+    }
+    h_values.assign(successors.size(), -1);
+    helpful.assign(successors.size(), vector<const Operator *>());
+    if (!new_successors.empty()) {
+        ++num_parallel_batches;
+        num_parallel_evaluations += new_successors.size();
+    }
+    if (!thread_pool) {
+        vector<State> states;
+        for (int pos : new_successors) {
+            states.push_back(successors[pos]);
+        }
+        vector<int> values;
+        heuristic->evaluate_batch(states, values);
+        for (size_t i = 0; i < new_successors.size(); ++i) {
+            h_values[new_successors[i]] = values[i];
+        }
+        return;
+    }
+    thread_pool->parallel_for(
+        new_successors.size(),
+        [&](int task, int thread_id) {
+            Heuristic *context = evaluation_contexts[thread_id];
+            int pos = new_successors[task];
+            context->evaluate(successors[pos]);
+            if (!context->is_dead_end()) {
+                h_values[pos] = context->get_heuristic();
+                if (helpful_actions) {
+                    context->get_helpful_actions(helpful[pos]);
+                }
+            }
+        });
+}
 
 void WeightedAstar::statistics() const
 {
     search_progress.print_statistics();
     search_space.statistics();
+    if (batch_evaluation) {
+        cout << "Batch evaluation: " << num_parallel_evaluations
+             << " states in " << num_parallel_batches << " batches" << endl;
+    }
+    if (thread_pool) {
+        cout << "Parallel evaluation: " << num_parallel_evaluations
+             << " states in " << num_parallel_batches << " batches, "
+             << thread_pool->get_num_steals() << " steals" << endl;
+    }
+    if (preferred_open_list) {
+        cout << "Expansions from the preferred open list: "
+             << num_preferred_expansions << endl;
+    }
     if (pruning != nullptr) {
         pruning->print_statistics();
     }
+    if (heuristic->get_num_cache_hits() > 0) {
+        cout << "Heuristic cache hits: " << heuristic->get_num_cache_hits()
+             << endl;
+    }
 }
 
 SearchStatus WeightedAstar::step()
@@ -120,13 +324,22 @@ SearchStatus WeightedAstar::step()
 
     g_successor_generator->generate_applicable_ops(s, applicable_ops);
 
-    // TODO implement support for helpful actions here
-    // use the helpful_actions variable to check if helpful actions are enabled.
+    // Copied because looking up the successors may insert new entries.
+    vector<const Operator *> helpful;
+    if (helpful_actions) {
+        helpful = state_helpful_actions[s];
+    }
 
     if (pruning != nullptr) {
         pruning->prune_operators(s, applicable_ops);
     }
 
+    /*
+      We register all successors first so that their heuristic values can be
+      computed in parallel before the successors are processed in order.
+    */
+    vector<State> successors;
+    vector<const Operator *> successor_ops;
     for (size_t i = 0; i < applicable_ops.size(); ++i) {
         const Operator *op = applicable_ops[i];
 
@@ -136,10 +349,31 @@ SearchStatus WeightedAstar::step()
             continue;
         }
 
-        State succ_state = g_state_registry->get_successor_state(s, *op);
+        successors.push_back(g_state_registry->get_successor_state(s, *op));
+        successor_ops.push_back(op);
         search_progress.inc_generated();
+    }
+
+    vector<int> h_values;
+    vector<vector<const Operator *>> succ_helpful;
+    bool evaluate_in_advance = thread_pool || batch_evaluation;
+    if (evaluate_in_advance) {
+        // The heuristic must see the paths before the successors are evaluated.
+        for (size_t i = 0; i < successors.size(); ++i) {
+            if (search_space.get_node(successors[i]).is_new()) {
+                heuristic->reach_state(s, *successor_ops[i], successors[i]);
+            }
+        }
+        evaluate_new_successors(successors, h_values, succ_helpful);
+    }
+
+    for (size_t i = 0; i < successors.size(); ++i) {
+        const Operator *op = successor_ops[i];
+        const State &succ_state = successors[i];
 
         SearchNode succ_node = search_space.get_node(succ_state);
+        bool preferred = helpful_actions &&
+                         binary_search(helpful.begin(), helpful.end(), op);
 
         // Previously encountered dead end. Don't re-evaluate.
         if (succ_node.is_dead_end()) {
@@ -147,7 +381,7 @@ SearchStatus WeightedAstar::step()
         }
 
         // update new path
-        if (succ_node.is_new()) {
+        if (succ_node.is_new() && !evaluate_in_advance) {
             /*
                 Note that we must call reach_state for the
                 heuristic for its side effects.
@@ -158,7 +392,15 @@ SearchStatus WeightedAstar::step()
         if (succ_node.is_new()) {
             // We have not seen this state before.
             // Evaluate and create a new node.
-            heuristic->evaluate(succ_state);
+            if (evaluate_in_advance) {
+                // Already computed by evaluate_new_successors.
+                heuristic->set_evaluator_value(h_values[i]);
+                if (helpful_actions) {
+                    store_helpful_actions(succ_state, succ_helpful[i]);
+                }
+            } else {
+                evaluate_state(succ_state);
+            }
 
             succ_node.clear_h_dirty();
             search_progress.inc_evaluated_states();
@@ -169,7 +411,7 @@ SearchStatus WeightedAstar::step()
             // before having checked that we're not in a dead end. The
             // division of responsibilities is a bit tricky here -- we
             // may want to refactor this later.
-            open_list->evaluate(node.get_g() + get_adjusted_cost(*op), false);
+            open_list->evaluate(node.get_g() + get_adjusted_cost(*op), preferred);
             bool dead_end = open_list->is_dead_end();
             if (dead_end) {
                 succ_node.mark_as_dead_end();
@@ -177,11 +419,15 @@ SearchStatus WeightedAstar::step()
                 continue;
             }
 
-            int succ_h = heuristic->get_heuristic();
+            int succ_h = heuristic->get_value();
 
             succ_node.open(succ_h, node, op);
 
             open_list->insert(succ_state.get_id());
+            if (preferred_open_list) {
+                preferred_open_list->evaluate(succ_node.get_g(), preferred);
+                preferred_open_list->insert(succ_state.get_id());
+            }
 
         } else if (succ_node.get_g() > node.get_g() + get_adjusted_cost(*op)) {
             // We found a new cheapest path to an open or closed state.
@@ -192,9 +438,13 @@ SearchStatus WeightedAstar::step()
                 succ_node.reopen(node, op);
                 heuristic->set_evaluator_value(succ_node.get_h());
 
-                open_list->evaluate(succ_node.get_g(), false);
+                open_list->evaluate(succ_node.get_g(), preferred);
 
                 open_list->insert(succ_state.get_id());
+                if (preferred_open_list) {
+                    preferred_open_list->evaluate(succ_node.get_g(), preferred);
+                    preferred_open_list->insert(succ_state.get_id());
+                }
             } else {
                 // if we do not reopen closed nodes, we just update the parent pointers
                 // Note that this could cause an incompatibility between
@@ -216,8 +466,18 @@ pair<SearchNode, bool> WeightedAstar::fetch_next_node()
             SearchNode dummy_node = search_space.get_node(g_initial_state());
             return make_pair(dummy_node, false);
         }
-        vector<int> last_key_removed;
-        StateID id = open_list->remove_min(0);
+        /*
+          The open list contains all open nodes, so the search only fails
+          when it is empty. Preferred nodes are taken from the preferred
+          open list in every other expansion.
+        */
+        bool from_preferred = false;
+        if (preferred_open_list && !preferred_open_list->empty()) {
+            from_preferred = expand_preferred_next;
+            expand_preferred_next = !expand_preferred_next;
+        }
+        StateID id = from_preferred ? preferred_open_list->remove_min(0) :
+                     open_list->remove_min(0);
 
         State s = g_state_registry->lookup_state(id);
         SearchNode node = search_space.get_node(s);
@@ -228,6 +488,9 @@ pair<SearchNode, bool> WeightedAstar::fetch_next_node()
 
         node.close();
         assert(!node.is_dead_end());
+        if (from_preferred) {
+            ++num_preferred_expansions;
+        }
         update_jump_statistic(node);
         search_progress.inc_expanded();
         return make_pair(node, true);
@@ -269,9 +532,18 @@ static SearchEngine *_parse_wastar(OptionParser &parser)
 
     parser.add_option<ScalarEvaluator *>("eval", "evaluator for h-value");
     parser.add_option<int>("w", "heuristic weight", "1");
-    parser.add_option<bool>("helpful_actions", "use helpful actions", "false");
+    parser.add_option<bool>(
+        "helpful_actions",
+        "alternate with an open list of the successors reached by helpful "
+        "actions",
+        "false");
     parser.add_option<PruningMethod *>("pruning", "use a pruning method", "",
                                        OptionFlags(false));
+    parser.add_option<int>(
+        "threads",
+        "number of threads for evaluating the successors of a state; "
+        "needs a heuristic that supports evaluation contexts",
+        "1");
 
     SearchEngine::add_options_to_parser(parser);
     Options opts = parser.parse();
@@ -300,6 +572,10 @@ static SearchEngine *_parse_wastar(OptionParser &parser)
                                   new TieBreakingOpenList<StateID>(evals, false, false);
 
         opts.set("open", open);
+        if (opts.get<bool>("helpful_actions")) {
+            opts.set("preferred_open", static_cast<OpenList<StateID> *>(
+                         new TieBreakingOpenList<StateID>(evals, true, false)));
+        }
         opts.set("f_eval", f_eval);
         opts.set("reopen_closed", true);
         engine = new WeightedAstar(opts);
@@ -11,6 +11,7 @@
 #include "timer.h"
 
 #include "open_list.h"
+#include "per_state_information.h"
 
 // Usage example: the command line option for using wastar with weight x and
 // heuristic with name h is
@@ -23,6 +24,16 @@
 // To enable helpful actions you additionally need to pass helpful_actions=true,
 // so for example running wastar with h^{FF}, weight 5, and helpful actions:
 // ./fast-downward.py [path-to-PDDL-problem-file] --search "wastar(ff(), w=5, helpful_actions=true)"
+// The helpful actions of a state are stored when it is evaluated. Successors
+// reached by them are also put into a second open list, and the search
+// alternates between both lists. All successors are still generated, so the
+// search stays complete.
+// To evaluate the successors of each expanded state on N threads, pass
+// threads=N. This requires a heuristic that supports evaluation contexts.
+// The search itself (and hence the plan) does not depend on N.
+// Without threads and helpful actions, heuristics that support batch
+// evaluation (e.g. h^max with uniform costs) evaluate all new successors of a
+// state at once.
 // If you want to enable a pruning method, please check the file corresponding
 // to the desired method for further details.
 // Obviously, [path-to-PDDL-problem-file] has to be replaced by the actual path
@@ -34,22 +45,49 @@ class Heuristic;
 class Options;
 class PruningMethod;
 class ScalarEvaluator;
+class ThreadPool;
 
 class WeightedAstar : public SearchEngine
 {
     // Search Behavior parameters
     bool reopen_closed_nodes; // whether to reopen closed nodes upon finding lower g paths
-    bool helpful_actions; // use helpful actions pruning
+    bool helpful_actions; // prefer successors reached by helpful actions
     PruningMethod *pruning; // the specified pruning method
+    int num_threads; // threads for evaluating the successors of a node
+    bool warm_started; // continues the search space of a previous phase
+
+    // Only used if successors are evaluated in parallel.
+    ThreadPool *thread_pool;
+    std::vector<Heuristic *> evaluation_contexts;
+    // Otherwise, heuristics that support it evaluate all successors at once.
+    bool batch_evaluation;
+    int num_parallel_batches;
+    int num_parallel_evaluations;
 
     OpenList<StateID> *open_list;
     ScalarEvaluator *f_evaluator;
 
+    // Only used with helpful actions.
+    OpenList<StateID> *preferred_open_list;
+    // Sorted helpful actions of each evaluated state.
+    PerStateInformation<std::vector<const Operator *>> state_helpful_actions;
+    bool expand_preferred_next;
+    int num_preferred_expansions;
+
 protected:
     SearchStatus step();
     std::pair<SearchNode, bool> fetch_next_node();
     void update_jump_statistic(const SearchNode &node);
     void print_heuristic_values(const std::vector<int> &values) const;
+    void setup_parallel_evaluation();
+    void evaluate_new_successors(
+        const std::vector<State> &successors, std::vector<int> &h_values,
+        std::vector<std::vector<const Operator *>> &helpful);
+    // Evaluates the heuristic and stores the helpful actions if needed.
+    void evaluate_state(const State &state);
+    void store_helpful_actions(const State &state,
+                               std::vector<const Operator *> &helpful);
+    void reinsert_open_nodes();
 
     Heuristic *heuristic;
 
@@ -57,7 +95,9 @@ protected:
 
 public:
     WeightedAstar(const Options &opts);
+    virtual ~WeightedAstar();
     void statistics() const;
+    virtual bool warm_start(const SearchEngine &previous);
 
     void dump_search_space();
 };